@@ -0,0 +1,807 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * pointerdetectix-run --- the filter over a video file or a capture, as fast as it
+ * goes and without a media server: events as CSV or JSON lines, one timing per frame
+ *
+ *   pointerdetectix-run -l layout.json -f jsonl -t timings.csv session.webm > events.jsonl
+ *   ls *.dtx | xargs -P $(nproc) -I{} pointerdetectix-run -l layout.json -o {}.csv {}
+ */
+
+#ifdef HAVE_CONFIG_H
+    #include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <json-glib/json-glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kmsdetectixcapture.h"
+
+
+#define THIS_PLUGIN_NAME    "pointerdetectix"
+
+
+typedef struct _RunnerStruct
+{
+    GstElement    * pipeline;
+    GstElement    * detectix;
+    FILE          * events;
+    FILE          * timings;
+    gboolean        is_jsonl;
+    gint64          calibrate_frame;      // calibrate-color before this frame, -1 never
+    GHashTable    * overrides;            // properties given on the command line, kept over a capture's
+    guint64         num_frames;           // frames that entered the filter
+    GstClockTime    pts;                  // of the frame in the filter
+    guint64         frame_start_ns;
+    GArray        * durations_ns;         // guint64 per frame
+
+} RunnerStruct;
+
+
+static gchar      * The_Layout_Path   = NULL;
+static gchar      * The_Events_Path   = NULL;
+static gchar      * The_Timings_Path  = NULL;
+static gchar      * The_Format        = NULL;
+static gchar      * The_Plugin_Path   = NULL;
+static gchar     ** The_Properties    = NULL;
+static gint64       The_Calibrate     = -1;
+
+static GOptionEntry The_Options[] =
+{
+    { "layout",     'l', 0, G_OPTION_ARG_FILENAME,     &The_Layout_Path,  "windows as JSON, like the server's PointerDetectixWindowMediaParam", "FILE" },
+    { "events",     'o', 0, G_OPTION_ARG_FILENAME,     &The_Events_Path,  "write the events here instead of to stdout", "FILE" },
+    { "format",     'f', 0, G_OPTION_ARG_STRING,       &The_Format,       "csv (default) or jsonl", "FORMAT" },
+    { "timings",    't', 0, G_OPTION_ARG_FILENAME,     &The_Timings_Path, "write frame,pts_ns,process_ns per frame as CSV", "FILE" },
+    { "property",   'p', 0, G_OPTION_ARG_STRING_ARRAY, &The_Properties,   "set a property of the filter, repeatable", "NAME=VALUE" },
+    { "calibrate",  'c', 0, G_OPTION_ARG_INT64,        &The_Calibrate,    "calibrate the color on the calibration area before this frame", "FRAME" },
+    { "plugin-path", 0,  0, G_OPTION_ARG_FILENAME,     &The_Plugin_Path,  "directory holding the pointerdetectix plugin, if not installed", "DIR" },
+    { NULL }
+};
+
+
+static gboolean get_json_number(JsonObject * aObjectPtr, const gchar * aNamePtr, GValue * aValuePtr)
+{
+    JsonNode * node_ptr = json_object_get_member(aObjectPtr, aNamePtr);
+
+    if ((node_ptr == NULL) || (JSON_NODE_TYPE (node_ptr) != JSON_NODE_VALUE))
+    {
+        return FALSE;
+    }
+
+    if (json_node_get_value_type(node_ptr) == G_TYPE_INT64)
+    {
+        g_value_init(aValuePtr, G_TYPE_INT);
+        g_value_set_int(aValuePtr, (gint) json_node_get_int(node_ptr));
+    }
+    else if (json_node_get_value_type(node_ptr) == G_TYPE_DOUBLE)
+    {
+        g_value_init(aValuePtr, G_TYPE_DOUBLE);
+        g_value_set_double(aValuePtr, json_node_get_double(node_ptr));
+    }
+    else
+    {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/*
+ * the structure PointerDetectixFilterImpl builds for one window, with the same names ---
+ * coordinates given as fractions of the frame stay doubles, as the filter expects them
+ */
+static GstStructure * window_from_json(JsonObject * aWindowPtr)
+{
+    static const gchar * json_names[4]   = { "upperRightX", "upperRightY", "width", "height" };
+    static const gchar * filter_names[4] = { "upRightCornerX", "upRightCornerY", "width", "height" };
+
+    const gchar  * id_ptr;
+    GstStructure * window_ptr;
+    gint           index;
+
+    if (! json_object_has_member(aWindowPtr, "id") || ((id_ptr = json_object_get_string_member(aWindowPtr, "id")) == NULL))
+    {
+        return NULL;
+    }
+
+    window_ptr = gst_structure_new(id_ptr, "id", G_TYPE_STRING, id_ptr, NULL);
+
+    for (index = 0; index < 4; index++)
+    {
+        GValue value = G_VALUE_INIT;
+
+        if (! get_json_number(aWindowPtr, json_names[index], &value))
+        {
+            gst_structure_free(window_ptr);
+            return NULL;
+        }
+
+        gst_structure_take_value(window_ptr, filter_names[index], &value);
+    }
+
+    if (json_object_has_member(aWindowPtr, "image"))
+    {
+        gst_structure_set(window_ptr, "inactive_uri", G_TYPE_STRING, json_object_get_string_member(aWindowPtr, "image"), NULL);
+    }
+
+    if (json_object_has_member(aWindowPtr, "activeImage"))
+    {
+        gst_structure_set(window_ptr, "active_uri", G_TYPE_STRING, json_object_get_string_member(aWindowPtr, "activeImage"), NULL);
+    }
+
+    if (json_object_has_member(aWindowPtr, "imageTransparency"))
+    {
+        gst_structure_set(window_ptr, "transparency", G_TYPE_DOUBLE, json_object_get_double_member(aWindowPtr, "imageTransparency"), NULL);
+    }
+
+    if (json_object_has_member(aWindowPtr, "referenceWidth") && json_object_has_member(aWindowPtr, "referenceHeight"))
+    {
+        gst_structure_set(window_ptr,
+                          "referenceWidth",  G_TYPE_INT, (gint) json_object_get_int_member(aWindowPtr, "referenceWidth"),
+                          "referenceHeight", G_TYPE_INT, (gint) json_object_get_int_member(aWindowPtr, "referenceHeight"),
+                          NULL);
+    }
+
+    return window_ptr;
+}
+
+
+/*
+ * the layout is an array of windows, or an object with "windows" and an optional
+ * "calibrationRegion" using the names of the server's WindowParam
+ */
+static gboolean apply_layout(RunnerStruct * aRunnerPtr, const gchar * aPathPtr)
+{
+    JsonParser   * parser_ptr = json_parser_new();
+    JsonNode     * root_ptr;
+    JsonArray    * windows_ptr = NULL;
+    JsonObject   * region_ptr  = NULL;
+    GstStructure * layout_ptr;
+    GError       * error_ptr   = NULL;
+    guint          index;
+
+    if (! json_parser_load_from_file(parser_ptr, aPathPtr, &error_ptr))
+    {
+        g_printerr("%s: %s\n", aPathPtr, error_ptr->message);
+        g_error_free(error_ptr);
+        g_object_unref(parser_ptr);
+        return FALSE;
+    }
+
+    root_ptr = json_parser_get_root(parser_ptr);
+
+    if (JSON_NODE_HOLDS_ARRAY (root_ptr))
+    {
+        windows_ptr = json_node_get_array(root_ptr);
+    }
+    else if (JSON_NODE_HOLDS_OBJECT (root_ptr))
+    {
+        JsonObject * object_ptr = json_node_get_object(root_ptr);
+
+        if (json_object_has_member(object_ptr, "windows"))
+        {
+            windows_ptr = json_object_get_array_member(object_ptr, "windows");
+        }
+
+        if (json_object_has_member(object_ptr, "calibrationRegion"))
+        {
+            region_ptr = json_object_get_object_member(object_ptr, "calibrationRegion");
+        }
+    }
+
+    if (windows_ptr == NULL)
+    {
+        g_printerr("%s: expected an array of windows, or an object with \"windows\"\n", aPathPtr);
+        g_object_unref(parser_ptr);
+        return FALSE;
+    }
+
+    layout_ptr = gst_structure_new_empty("windowsLayout");
+
+    for (index = 0; index < json_array_get_length(windows_ptr); index++)
+    {
+        JsonNode     * node_ptr   = json_array_get_element(windows_ptr, index);
+        GstStructure * window_ptr = JSON_NODE_HOLDS_OBJECT (node_ptr) ? window_from_json(json_node_get_object(node_ptr)) : NULL;
+
+        if (window_ptr == NULL)
+        {
+            g_printerr("%s: window %u lacks id, upperRightX, upperRightY, width or height\n", aPathPtr, index);
+            gst_structure_free(layout_ptr);
+            g_object_unref(parser_ptr);
+            return FALSE;
+        }
+
+        gst_structure_set(layout_ptr, gst_structure_get_name(window_ptr), GST_TYPE_STRUCTURE, window_ptr, NULL);
+        gst_structure_free(window_ptr);
+    }
+
+    g_object_set(aRunnerPtr->detectix, "windows-layout", layout_ptr, NULL);
+    g_hash_table_add(aRunnerPtr->overrides, g_strdup("windows-layout"));
+    gst_structure_free(layout_ptr);
+
+    if (region_ptr != NULL)
+    {
+        GstStructure * area_ptr = gst_structure_new("calibration_area",
+                                                    "x",      G_TYPE_INT, (gint) json_object_get_int_member(region_ptr, "topRightCornerX"),
+                                                    "y",      G_TYPE_INT, (gint) json_object_get_int_member(region_ptr, "topRightCornerY"),
+                                                    "width",  G_TYPE_INT, (gint) json_object_get_int_member(region_ptr, "width"),
+                                                    "height", G_TYPE_INT, (gint) json_object_get_int_member(region_ptr, "height"),
+                                                    NULL);
+
+        g_object_set(aRunnerPtr->detectix, "calibration-area", area_ptr, NULL);
+        g_hash_table_add(aRunnerPtr->overrides, g_strdup("calibration-area"));
+        gst_structure_free(area_ptr);
+    }
+
+    g_object_unref(parser_ptr);
+
+    return TRUE;
+}
+
+
+static gboolean apply_properties(RunnerStruct * aRunnerPtr)
+{
+    gint index;
+
+    for (index = 0; (The_Properties != NULL) && (The_Properties[index] != NULL); index++)
+    {
+        gchar ** pair_ptr = g_strsplit(The_Properties[index], "=", 2);
+
+        if ((g_strv_length(pair_ptr) != 2) ||
+            (g_object_class_find_property(G_OBJECT_GET_CLASS (aRunnerPtr->detectix), pair_ptr[0]) == NULL))
+        {
+            g_printerr("unknown property (%s)\n", The_Properties[index]);
+            g_strfreev(pair_ptr);
+            return FALSE;
+        }
+
+        gst_util_set_object_arg(G_OBJECT (aRunnerPtr->detectix), pair_ptr[0], pair_ptr[1]);
+        g_hash_table_add(aRunnerPtr->overrides, g_strdup(pair_ptr[0]));
+
+        g_strfreev(pair_ptr);
+    }
+
+    return TRUE;
+}
+
+
+// one event per line, stamped with the frame the filter was analyzing when it was posted
+static void write_event(RunnerStruct * aRunnerPtr, const GstStructure * aStructurePtr)
+{
+    const gchar * name_ptr = gst_structure_get_name(aStructurePtr);
+    guint64       frame    = aRunnerPtr->num_frames - 1;
+    gint          index;
+
+    if (aRunnerPtr->is_jsonl)
+    {
+        JsonBuilder   * builder_ptr   = json_builder_new();
+        JsonGenerator * generator_ptr = json_generator_new();
+        JsonNode      * root_ptr;
+        gchar         * text_ptr;
+
+        json_builder_begin_object(builder_ptr);
+        json_builder_set_member_name(builder_ptr, "frame");
+        json_builder_add_int_value(builder_ptr, (gint64) frame);
+        json_builder_set_member_name(builder_ptr, "pts_ns");
+        json_builder_add_int_value(builder_ptr, GST_CLOCK_TIME_IS_VALID (aRunnerPtr->pts) ? (gint64) aRunnerPtr->pts : -1);
+        json_builder_set_member_name(builder_ptr, "event");
+        json_builder_add_string_value(builder_ptr, name_ptr);
+
+        for (index = 0; index < gst_structure_n_fields(aStructurePtr); index++)
+        {
+            const gchar  * field_ptr = gst_structure_nth_field_name(aStructurePtr, index);
+            const GValue * value_ptr = gst_structure_get_value(aStructurePtr, field_ptr);
+
+            json_builder_set_member_name(builder_ptr, field_ptr);
+
+            if (G_VALUE_HOLDS_INT (value_ptr))
+            {
+                json_builder_add_int_value(builder_ptr, g_value_get_int(value_ptr));
+            }
+            else if (G_VALUE_HOLDS_DOUBLE (value_ptr))
+            {
+                json_builder_add_double_value(builder_ptr, g_value_get_double(value_ptr));
+            }
+            else if (G_VALUE_HOLDS_BOOLEAN (value_ptr))
+            {
+                json_builder_add_boolean_value(builder_ptr, g_value_get_boolean(value_ptr));
+            }
+            else if (G_VALUE_HOLDS_STRING (value_ptr))
+            {
+                json_builder_add_string_value(builder_ptr, g_value_get_string(value_ptr));
+            }
+            else
+            {
+                gchar * serialized_ptr = gst_value_serialize(value_ptr);
+
+                json_builder_add_string_value(builder_ptr, serialized_ptr);
+                g_free(serialized_ptr);
+            }
+        }
+
+        json_builder_end_object(builder_ptr);
+
+        root_ptr = json_builder_get_root(builder_ptr);
+        json_generator_set_root(generator_ptr, root_ptr);
+        text_ptr = json_generator_to_data(generator_ptr, NULL);
+
+        fprintf(aRunnerPtr->events, "%s\n", text_ptr);
+
+        g_free(text_ptr);
+        json_node_free(root_ptr);
+        g_object_unref(generator_ptr);
+        g_object_unref(builder_ptr);
+    }
+    else
+    {
+        const gchar * window_ptr = gst_structure_get_string(aStructurePtr, "window");
+        gint          x          = 0;
+        gint          y          = 0;
+        gboolean      visible    = FALSE;
+        gdouble       confidence = 0.0;
+
+        gst_structure_get_int(aStructurePtr, "x", &x);
+        gst_structure_get_int(aStructurePtr, "y", &y);
+        gst_structure_get_boolean(aStructurePtr, "visible", &visible);
+        gst_structure_get_double(aStructurePtr, "confidence", &confidence);
+
+        // window ids are free text, quoted as RFC 4180 has it
+        if (window_ptr != NULL)
+        {
+            gchar ** parts_ptr = g_strsplit(window_ptr, "\"", -1);
+            gchar  * quoted    = g_strjoinv("\"\"", parts_ptr);
+
+            fprintf(aRunnerPtr->events, "%" G_GUINT64_FORMAT ",%" G_GINT64_FORMAT ",%s,\"%s\",,,,\n", frame,
+                    GST_CLOCK_TIME_IS_VALID (aRunnerPtr->pts) ? (gint64) aRunnerPtr->pts : -1, name_ptr, quoted);
+
+            g_free(quoted);
+            g_strfreev(parts_ptr);
+        }
+        else
+        {
+            fprintf(aRunnerPtr->events, "%" G_GUINT64_FORMAT ",%" G_GINT64_FORMAT ",%s,,%d,%d,%d,%.3f\n", frame,
+                    GST_CLOCK_TIME_IS_VALID (aRunnerPtr->pts) ? (gint64) aRunnerPtr->pts : -1, name_ptr,
+                    x, y, visible ? 1 : 0, confidence);
+        }
+    }
+
+    return;
+}
+
+
+// on the streaming thread, while the frame that caused the message is still in the filter
+static GstBusSyncReply on_bus_message(GstBus * aBusPtr, GstMessage * aMessagePtr, gpointer aDataPtr)
+{
+    RunnerStruct * runner_ptr = (RunnerStruct *) aDataPtr;
+
+    if ((GST_MESSAGE_TYPE (aMessagePtr) == GST_MESSAGE_ELEMENT) &&
+        (GST_MESSAGE_SRC (aMessagePtr) == GST_OBJECT (runner_ptr->detectix)))
+    {
+        write_event(runner_ptr, gst_message_get_structure(aMessagePtr));
+
+        gst_message_unref(aMessagePtr);
+
+        return GST_BUS_DROP;
+    }
+
+    return GST_BUS_PASS;
+}
+
+
+static GstPadProbeReturn on_frame_in(GstPad * aPadPtr, GstPadProbeInfo * aInfoPtr, gpointer aDataPtr)
+{
+    RunnerStruct * runner_ptr = (RunnerStruct *) aDataPtr;
+
+    if ((gint64) runner_ptr->num_frames == runner_ptr->calibrate_frame)
+    {
+        g_signal_emit_by_name(runner_ptr->detectix, "calibrate-color");
+    }
+
+    runner_ptr->pts            = GST_BUFFER_PTS (GST_PAD_PROBE_INFO_BUFFER (aInfoPtr));
+    runner_ptr->num_frames    += 1;
+    runner_ptr->frame_start_ns = gst_util_get_timestamp();
+
+    return GST_PAD_PROBE_OK;
+}
+
+
+static GstPadProbeReturn on_frame_out(GstPad * aPadPtr, GstPadProbeInfo * aInfoPtr, gpointer aDataPtr)
+{
+    RunnerStruct * runner_ptr = (RunnerStruct *) aDataPtr;
+    guint64        elapsed_ns = gst_util_get_timestamp() - runner_ptr->frame_start_ns;
+
+    g_array_append_val(runner_ptr->durations_ns, elapsed_ns);
+
+    if (runner_ptr->timings != NULL)
+    {
+        fprintf(runner_ptr->timings, "%" G_GUINT64_FORMAT ",%" G_GINT64_FORMAT ",%" G_GUINT64_FORMAT "\n",
+                runner_ptr->num_frames - 1, GST_CLOCK_TIME_IS_VALID (runner_ptr->pts) ? (gint64) runner_ptr->pts : -1,
+                elapsed_ns);
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+
+static void on_decoded_pad(GstElement * aDecodePtr, GstPad * aPadPtr, gpointer aDataPtr)
+{
+    GstElement * convert_ptr = GST_ELEMENT (aDataPtr);
+    GstPad     * sink_ptr    = gst_element_get_static_pad(convert_ptr, "sink");
+    GstCaps    * caps_ptr    = gst_pad_query_caps(aPadPtr, NULL);
+
+    // the first video stream is analyzed, audio and further streams are left unlinked
+    if (! gst_pad_is_linked(sink_ptr) && (gst_caps_get_size(caps_ptr) > 0) &&
+        g_str_has_prefix(gst_structure_get_name(gst_caps_get_structure(caps_ptr, 0)), "video/"))
+    {
+        gst_pad_link(aPadPtr, sink_ptr);
+    }
+
+    gst_caps_unref(caps_ptr);
+    gst_object_unref(sink_ptr);
+
+    return;
+}
+
+
+// blocks until the end of the file --- frames go through as fast as the filter takes them
+static gboolean run_file(RunnerStruct * aRunnerPtr, const gchar * aPathPtr)
+{
+    GstElement * source_ptr  = gst_element_factory_make("filesrc", NULL);
+    GstElement * decode_ptr  = gst_element_factory_make("decodebin", NULL);
+    GstElement * convert_ptr = gst_element_factory_make("videoconvert", NULL);
+    GstElement * sink_ptr    = gst_element_factory_make("fakesink", NULL);
+    GstBus     * bus_ptr;
+    GstMessage * message_ptr;
+    gboolean     is_ok;
+
+    if ((source_ptr == NULL) || (decode_ptr == NULL) || (convert_ptr == NULL) || (sink_ptr == NULL))
+    {
+        g_printerr("filesrc, decodebin, videoconvert and fakesink are needed to read %s\n", aPathPtr);
+        return FALSE;
+    }
+
+    g_object_set(source_ptr, "location", aPathPtr, NULL);
+    g_object_set(sink_ptr, "sync", FALSE, NULL);
+
+    gst_bin_add_many(GST_BIN (aRunnerPtr->pipeline), source_ptr, decode_ptr, convert_ptr, sink_ptr, NULL);
+
+    if (! gst_element_link(source_ptr, decode_ptr) ||
+        ! gst_element_link_many(convert_ptr, aRunnerPtr->detectix, sink_ptr, NULL))
+    {
+        g_printerr("cannot link the pipeline for %s\n", aPathPtr);
+        return FALSE;
+    }
+
+    g_signal_connect(decode_ptr, "pad-added", G_CALLBACK (on_decoded_pad), convert_ptr);
+
+    if (gst_element_set_state(aRunnerPtr->pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    {
+        g_printerr("cannot play %s\n", aPathPtr);
+        return FALSE;
+    }
+
+    bus_ptr     = gst_element_get_bus(aRunnerPtr->pipeline);
+    message_ptr = gst_bus_timed_pop_filtered(bus_ptr, GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    is_ok       = (GST_MESSAGE_TYPE (message_ptr) == GST_MESSAGE_EOS);
+
+    if (! is_ok)
+    {
+        GError * error_ptr = NULL;
+
+        gst_message_parse_error(message_ptr, &error_ptr, NULL);
+        g_printerr("%s: %s\n", aPathPtr, error_ptr->message);
+        g_error_free(error_ptr);
+    }
+
+    gst_message_unref(message_ptr);
+    gst_object_unref(bus_ptr);
+
+    return is_ok;
+}
+
+
+/*
+ * frames are pushed straight into the filter, in the order of the capture --- its
+ * properties and actions are replayed, except the ones given on the command line
+ */
+static gboolean run_capture(RunnerStruct * aRunnerPtr, KmsDetectixCaptureReader * aReaderPtr)
+{
+    GstElement      * sink_ptr   = gst_element_factory_make("fakesink", NULL);
+    GstPad          * pad_ptr    = gst_pad_new("src", GST_PAD_SRC);
+    GstPad          * input_ptr  = gst_element_get_static_pad(aRunnerPtr->detectix, "sink");
+    GstVideoInfo      info;
+    KmsDetectixRecord record;
+    gboolean          has_caps   = FALSE;
+    gboolean          is_ok      = TRUE;
+    GstSegment        segment;
+
+    g_object_set(sink_ptr, "sync", FALSE, NULL);
+
+    gst_bin_add(GST_BIN (aRunnerPtr->pipeline), sink_ptr);
+
+    if (! gst_element_link(aRunnerPtr->detectix, sink_ptr) || (gst_pad_link(pad_ptr, input_ptr) != GST_PAD_LINK_OK) ||
+        (gst_element_set_state(aRunnerPtr->pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE))
+    {
+        g_printerr("cannot start the filter\n");
+        gst_object_unref(input_ptr);
+        gst_object_unref(pad_ptr);
+        return FALSE;
+    }
+
+    gst_pad_set_active(pad_ptr, TRUE);
+    gst_pad_push_event(pad_ptr, gst_event_new_stream_start("capture"));
+
+    gst_video_info_init(&info);
+
+    while (is_ok && kms_detectix_capture_reader_next(aReaderPtr, &record))
+    {
+        const gchar * text_ptr = (const gchar *) record.data;
+
+        switch (record.type)
+        {
+            case KMS_DETECTIX_RECORD_CAPS:
+                {
+                    GstCaps * caps_ptr = gst_caps_from_string(text_ptr);
+
+                    is_ok = (caps_ptr != NULL) && gst_video_info_from_caps(&info, caps_ptr) &&
+                            gst_pad_push_event(pad_ptr, gst_event_new_caps(caps_ptr));
+
+                    if (is_ok && ! has_caps)
+                    {
+                        gst_segment_init(&segment, GST_FORMAT_TIME);
+                        is_ok = gst_pad_push_event(pad_ptr, gst_event_new_segment(&segment));
+                    }
+
+                    has_caps = is_ok;
+
+                    if (caps_ptr != NULL)
+                    {
+                        gst_caps_unref(caps_ptr);
+                    }
+                }
+                break;
+
+            case KMS_DETECTIX_RECORD_FRAME:
+                {
+                    gsize        row_size   = (gsize) GST_VIDEO_INFO_WIDTH (&info) * GST_VIDEO_INFO_COMP_PSTRIDE (&info, 0);
+                    GstBuffer  * buffer_ptr;
+                    GstMapInfo   map;
+                    gint         row;
+
+                    if (! has_caps || (record.size != row_size * GST_VIDEO_INFO_HEIGHT (&info)))
+                    {
+                        is_ok = FALSE;
+                        break;
+                    }
+
+                    buffer_ptr = gst_buffer_new_allocate(NULL, GST_VIDEO_INFO_SIZE (&info), NULL);
+
+                    gst_buffer_map(buffer_ptr, &map, GST_MAP_WRITE);
+
+                    for (row = 0; row < GST_VIDEO_INFO_HEIGHT (&info); row++)
+                    {
+                        memcpy(map.data + GST_VIDEO_INFO_PLANE_OFFSET (&info, 0) + row * GST_VIDEO_INFO_PLANE_STRIDE (&info, 0),
+                               record.data + row * row_size, row_size);
+                    }
+
+                    gst_buffer_unmap(buffer_ptr, &map);
+
+                    GST_BUFFER_PTS (buffer_ptr) = record.time_ns;
+
+                    is_ok = (gst_pad_push(pad_ptr, buffer_ptr) == GST_FLOW_OK);
+                }
+                break;
+
+            case KMS_DETECTIX_RECORD_PROPERTY:
+                if (! g_hash_table_contains(aRunnerPtr->overrides, text_ptr))
+                {
+                    gst_util_set_object_arg(G_OBJECT (aRunnerPtr->detectix), text_ptr, text_ptr + strlen(text_ptr) + 1);
+                }
+                break;
+
+            case KMS_DETECTIX_RECORD_ACTION:
+                g_signal_emit_by_name(aRunnerPtr->detectix, text_ptr);
+                break;
+
+            case KMS_DETECTIX_RECORD_MESSAGE:     // posted again by the filter, if it still behaves the same
+                break;
+        }
+    }
+
+    if (! is_ok)
+    {
+        g_printerr("capture frame %" G_GUINT64_FORMAT " does not match its caps\n", aRunnerPtr->num_frames);
+    }
+
+    gst_pad_push_event(pad_ptr, gst_event_new_eos());
+    gst_pad_set_active(pad_ptr, FALSE);
+    gst_pad_unlink(pad_ptr, input_ptr);
+
+    gst_object_unref(input_ptr);
+    gst_object_unref(pad_ptr);
+
+    return is_ok;
+}
+
+
+static gint compare_durations(gconstpointer aLeftPtr, gconstpointer aRightPtr)
+{
+    guint64 left  = *(const guint64 *) aLeftPtr;
+    guint64 right = *(const guint64 *) aRightPtr;
+
+    return (left > right) - (left < right);
+}
+
+
+static void print_summary(RunnerStruct * aRunnerPtr, guint64 aElapsedNs)
+{
+    GArray * durations_ptr = aRunnerPtr->durations_ns;
+    guint64  total_ns      = 0;
+    guint    index;
+
+    if (durations_ptr->len == 0)
+    {
+        g_printerr("no frame reached the filter\n");
+        return;
+    }
+
+    for (index = 0; index < durations_ptr->len; index++)
+    {
+        total_ns += g_array_index(durations_ptr, guint64, index);
+    }
+
+    g_array_sort(durations_ptr, compare_durations);
+
+    g_printerr("%u frames in %.3f s, %.1f frames/s --- filter per frame: mean %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+               durations_ptr->len, aElapsedNs / 1e9, durations_ptr->len * 1e9 / MAX(aElapsedNs, 1),
+               total_ns / 1e6 / durations_ptr->len,
+               g_array_index(durations_ptr, guint64, durations_ptr->len / 2) / 1e6,
+               g_array_index(durations_ptr, guint64, (durations_ptr->len - 1) * 99 / 100) / 1e6,
+               g_array_index(durations_ptr, guint64, durations_ptr->len - 1) / 1e6);
+
+    return;
+}
+
+
+int main(int argc, char * argv[])
+{
+    GOptionContext           * context_ptr = g_option_context_new("INPUT --- a video file, or a capture written by the capture property");
+    GError                   * error_ptr   = NULL;
+    KmsDetectixCaptureReader * reader_ptr;
+    RunnerStruct               runner;
+    GstBus                   * bus_ptr;
+    GstPad                   * pad_ptr;
+    guint64                    start_ns;
+    gboolean                   is_ok;
+
+    g_option_context_add_main_entries(context_ptr, The_Options, NULL);
+    g_option_context_add_group(context_ptr, gst_init_get_option_group());
+
+    if (! g_option_context_parse(context_ptr, &argc, &argv, &error_ptr) || (argc != 2))
+    {
+        g_printerr("%s\n", (error_ptr != NULL) ? error_ptr->message : "expected one input");
+        g_printerr("%s", g_option_context_get_help(context_ptr, TRUE, NULL));
+        return EXIT_FAILURE;
+    }
+
+    g_option_context_free(context_ptr);
+
+    if ((The_Format != NULL) && (strcmp(The_Format, "csv") != 0) && (strcmp(The_Format, "jsonl") != 0))
+    {
+        g_printerr("unknown format (%s), expected csv or jsonl\n", The_Format);
+        return EXIT_FAILURE;
+    }
+
+    if (The_Plugin_Path != NULL)
+    {
+        gst_registry_scan_path(gst_registry_get(), The_Plugin_Path);
+    }
+
+    memset(&runner, 0, sizeof(runner));
+
+    runner.pipeline        = gst_pipeline_new("detectixrun");
+    runner.detectix        = gst_element_factory_make(THIS_PLUGIN_NAME, "detectix");
+    runner.is_jsonl        = (g_strcmp0(The_Format, "jsonl") == 0);
+    runner.calibrate_frame = The_Calibrate;
+    runner.overrides       = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    runner.pts             = GST_CLOCK_TIME_NONE;
+    runner.durations_ns    = g_array_new(FALSE, FALSE, sizeof(guint64));
+    runner.events          = (The_Events_Path != NULL) ? fopen(The_Events_Path, "w") : stdout;
+    runner.timings         = (The_Timings_Path != NULL) ? fopen(The_Timings_Path, "w") : NULL;
+
+    if (runner.detectix == NULL)
+    {
+        g_printerr("%s is not installed, see --plugin-path\n", THIS_PLUGIN_NAME);
+        return EXIT_FAILURE;
+    }
+
+    if ((runner.events == NULL) || ((The_Timings_Path != NULL) && (runner.timings == NULL)))
+    {
+        g_printerr("cannot write %s\n", (runner.events == NULL) ? The_Events_Path : The_Timings_Path);
+        return EXIT_FAILURE;
+    }
+
+    gst_bin_add(GST_BIN (runner.pipeline), runner.detectix);
+
+    if (((The_Layout_Path != NULL) && ! apply_layout(&runner, The_Layout_Path)) || ! apply_properties(&runner))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (! runner.is_jsonl)
+    {
+        fprintf(runner.events, "frame,pts_ns,event,window,x,y,visible,confidence\n");
+    }
+
+    if (runner.timings != NULL)
+    {
+        fprintf(runner.timings, "frame,pts_ns,process_ns\n");
+    }
+
+    bus_ptr = gst_element_get_bus(runner.pipeline);
+    gst_bus_set_sync_handler(bus_ptr, on_bus_message, &runner, NULL);
+    gst_object_unref(bus_ptr);
+
+    pad_ptr = gst_element_get_static_pad(runner.detectix, "sink");
+    gst_pad_add_probe(pad_ptr, GST_PAD_PROBE_TYPE_BUFFER, on_frame_in, &runner, NULL);
+    gst_object_unref(pad_ptr);
+
+    pad_ptr = gst_element_get_static_pad(runner.detectix, "src");
+    gst_pad_add_probe(pad_ptr, GST_PAD_PROBE_TYPE_BUFFER, on_frame_out, &runner, NULL);
+    gst_object_unref(pad_ptr);
+
+    start_ns   = gst_util_get_timestamp();
+    reader_ptr = kms_detectix_capture_reader_new(argv[1]);
+
+    if (reader_ptr != NULL)
+    {
+        is_ok = run_capture(&runner, reader_ptr);
+        kms_detectix_capture_reader_free(reader_ptr);
+    }
+    else
+    {
+        is_ok = run_file(&runner, argv[1]);
+    }
+
+    print_summary(&runner, gst_util_get_timestamp() - start_ns);
+
+    gst_element_set_state(runner.pipeline, GST_STATE_NULL);
+    gst_object_unref(runner.pipeline);
+
+    if (runner.events != stdout)
+    {
+        fclose(runner.events);
+    }
+
+    if (runner.timings != NULL)
+    {
+        fclose(runner.timings);
+    }
+
+    g_hash_table_unref(runner.overrides);
+    g_array_unref(runner.durations_ns);
+
+    return is_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// ends file:  "detectixrun.c"
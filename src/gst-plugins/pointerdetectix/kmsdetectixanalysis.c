@@ -0,0 +1,290 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixanalysis.h"
+#include "kmsdetectixarena.h"
+#include "kmsdetectixblobs.h"
+
+#include <string.h>
+
+
+#define MIN_POINTER_AREA        4       // pixels, at analysis resolution
+#define MAX_SCALE_SHIFT         3       // largest block the downscale kernel averages
+#define STRIP_BYTES             (256 * 1024)    // scratch of one strip, sized for the L2 of a core
+#define MIN_STRIP_ROWS          8
+#define OPEN_HALO               2       // rows of context the 3x3 erode and dilate need on each side
+
+
+struct _KmsDetectixAnalysis
+{
+    KmsDetectixArena          * arena;
+    const KmsDetectixPixel    * pixel;          // layout of the caps and its kernels
+    void                     (* classify) (const guint8 *, gint, guint64 *, gint, gint, gint, const guint8 *, const guint8 *);
+    void                     (* downscale) (const guint8 *, gint, guint8 *, gint, gint, gint, guint, guint16 *);
+    gboolean                    is_ready;       // the arena is carved for width x height
+    gint                        width;
+    gint                        height;
+    gint                        strip_rows;     // mask rows labeled per strip
+    gint                        band_rows;      // a strip with its halo
+    guint8                    * scaled;         // downscaled rows of a band in the caps layout, half the caps wide
+    gint                        scaled_stride;
+    gint                        scaled_width;
+    guint64                   * mask;           // a band of mask rows, the caps wide at one bit per pixel
+    guint64                   * eroded;         // first half of the opening, sized as mask
+    guint64                   * opened;         // the opening, sized as mask
+    gint                        mask_stride;    // in words
+    guint16                   * sums;           // one row of column sums for the downscale
+    KmsDetectixBlobs            blobs;
+};
+
+
+KmsDetectixAnalysis * kms_detectix_analysis_new(void)
+{
+    KmsDetectixAnalysis * analysis_ptr = g_slice_new0(KmsDetectixAnalysis);
+
+    analysis_ptr->arena = kms_detectix_arena_new();
+    analysis_ptr->pixel = kms_detectix_layout_pixel(KMS_DETECTIX_LAYOUT_BGR);
+
+    return analysis_ptr;
+}
+
+
+void kms_detectix_analysis_free(KmsDetectixAnalysis * aAnalysisPtr)
+{
+    if (aAnalysisPtr == NULL)
+    {
+        return;
+    }
+
+    kms_detectix_arena_free(aAnalysisPtr->arena);
+
+    g_slice_free(KmsDetectixAnalysis, aAnalysisPtr);
+
+    return;
+}
+
+
+gboolean kms_detectix_analysis_set_info(KmsDetectixAnalysis * aAnalysisPtr, gint aWidth, gint aHeight, KmsDetectixLayout aLayout)
+{
+    const KmsDetectixKernels * kernels_ptr = kms_detectix_kernels();
+    gsize                      mask_bytes;
+    gsize                      capacity;
+
+    aAnalysisPtr->is_ready = FALSE;
+
+    if ((aWidth <= 0) || (aHeight <= 0) || (aWidth > G_MAXUINT16) || (aHeight > G_MAXUINT16) || (aLayout >= KMS_DETECTIX_LAYOUTS))
+    {
+        return FALSE;
+    }
+
+    // the variants of the frame kernels for the layout, out of the set picked at plugin load
+    aAnalysisPtr->pixel     = kms_detectix_layout_pixel(aLayout);
+    aAnalysisPtr->classify  = kernels_ptr->classify[aLayout];
+    aAnalysisPtr->downscale = kernels_ptr->downscale[aLayout];
+
+    aAnalysisPtr->width         = aWidth;
+    aAnalysisPtr->height        = aHeight;
+    aAnalysisPtr->scaled_width  = aWidth / 2;
+    aAnalysisPtr->scaled_stride = (gint) kms_detectix_arena_round((gsize) aAnalysisPtr->scaled_width * aAnalysisPtr->pixel->size);
+    aAnalysisPtr->mask_stride   = (gint) (kms_detectix_arena_round(KMS_DETECTIX_MASK_WORDS(aWidth) * sizeof(guint64)) / sizeof(guint64));
+
+    // as many rows as keep the scaled rows and the three masks of a band within STRIP_BYTES
+    aAnalysisPtr->strip_rows = STRIP_BYTES / (aAnalysisPtr->scaled_stride + aAnalysisPtr->mask_stride * (gint) sizeof(guint64) * 3) -
+                               OPEN_HALO * 2;
+    aAnalysisPtr->strip_rows = CLAMP(aAnalysisPtr->strip_rows, MIN_STRIP_ROWS, aHeight);
+    aAnalysisPtr->band_rows  = aAnalysisPtr->strip_rows + OPEN_HALO * 2;
+
+    mask_bytes = (gsize) aAnalysisPtr->mask_stride * aAnalysisPtr->band_rows * sizeof(guint64);
+
+    // rows start on cache lines, and so does every piece
+    capacity = kms_detectix_arena_round((gsize) aAnalysisPtr->scaled_stride * aAnalysisPtr->band_rows) +
+               kms_detectix_arena_round(mask_bytes) * 3 +
+               kms_detectix_arena_round((gsize) aWidth * aAnalysisPtr->pixel->size * sizeof(guint16)) +
+               kms_detectix_blobs_scratch_size(aWidth, aHeight);
+
+    if (! kms_detectix_arena_prepare(aAnalysisPtr->arena, capacity))
+    {
+        return FALSE;
+    }
+
+    aAnalysisPtr->scaled = kms_detectix_arena_take(aAnalysisPtr->arena, (gsize) aAnalysisPtr->scaled_stride * aAnalysisPtr->band_rows);
+    aAnalysisPtr->mask   = kms_detectix_arena_take(aAnalysisPtr->arena, mask_bytes);
+    aAnalysisPtr->eroded = kms_detectix_arena_take(aAnalysisPtr->arena, mask_bytes);
+    aAnalysisPtr->opened = kms_detectix_arena_take(aAnalysisPtr->arena, mask_bytes);
+    aAnalysisPtr->sums   = kms_detectix_arena_take(aAnalysisPtr->arena, (gsize) aWidth * aAnalysisPtr->pixel->size * sizeof(guint16));
+
+    if ((aAnalysisPtr->mask == NULL) || (aAnalysisPtr->eroded == NULL) || (aAnalysisPtr->opened == NULL) || (aAnalysisPtr->sums == NULL) ||
+        ! kms_detectix_blobs_init(&aAnalysisPtr->blobs, aAnalysisPtr->arena, aWidth, aHeight))
+    {
+        return FALSE;
+    }
+
+    aAnalysisPtr->is_ready = TRUE;
+
+    return TRUE;
+}
+
+
+void kms_detectix_analysis_release(KmsDetectixAnalysis * aAnalysisPtr)
+{
+    aAnalysisPtr->is_ready = FALSE;
+
+    kms_detectix_arena_release(aAnalysisPtr->arena);
+
+    return;
+}
+
+
+// aNumRows mask rows from aFirstRow on, downscaled first when aScaleShift is not 0
+static void classify_rows(KmsDetectixAnalysis         * aAnalysisPtr,
+                          const guint8                * aRoiPtr,
+                          gint                          aStride,
+                          gint                          aWidth,
+                          gint                          aFirstRow,
+                          gint                          aNumRows,
+                          guint                         aScaleShift,
+                          const KmsDetectixColorRange * aRangePtr,
+                          guint64                     * aMaskPtr)
+{
+    const guint8 * work_ptr    = aRoiPtr + (aFirstRow << aScaleShift) * aStride;
+    gint           work_stride = aStride;
+
+    if (aNumRows <= 0)
+    {
+        return;
+    }
+
+    if (aScaleShift > 0)
+    {
+        aAnalysisPtr->downscale(work_ptr, aStride, aAnalysisPtr->scaled, aAnalysisPtr->scaled_stride, aWidth, aNumRows,
+                                aScaleShift, aAnalysisPtr->sums);
+
+        work_ptr    = aAnalysisPtr->scaled;
+        work_stride = aAnalysisPtr->scaled_stride;
+    }
+
+    aAnalysisPtr->classify(work_ptr, work_stride, aMaskPtr, aAnalysisPtr->mask_stride, aWidth, aNumRows,
+                           aRangePtr->low, aRangePtr->high);
+
+    return;
+}
+
+
+/*
+ * the search window goes through every stage one strip of rows at a time: the rows of a
+ * strip and its halo are classified into a band that stays in cache, opened, and labeled
+ * right away --- the halo rows are kept for the next strip, so every frame row is read once
+ * and no mask is ever the size of the frame
+ */
+void kms_detectix_analysis_find_pointer(KmsDetectixAnalysis         * aAnalysisPtr,
+                                        const guint8                * aPixelsPtr,
+                                        gint                          aStride,
+                                        const GstVideoRectangle     * aRoiPtr,
+                                        guint                         aScaleShift,
+                                        const KmsDetectixColorRange * aRangePtr,
+                                        KmsDetectixPointer          * aPointerPtr)
+{
+    const KmsDetectixKernels * kernels_ptr = kms_detectix_kernels();
+    gint                       width       = aRoiPtr->w >> aScaleShift;
+    gint                       height      = aRoiPtr->h >> aScaleShift;
+    gint                       stride      = aAnalysisPtr->mask_stride;
+    const guint8             * roi_ptr;
+    KmsDetectixBlob            blob;
+    gboolean                   is_blob;
+    gint                       band_top    = 0;     // mask rows in the band
+    gint                       band_end    = 0;
+    gint                       top;
+    gint                       box_w;
+    gint                       box_h;
+
+    aPointerPtr->found = FALSE;
+    aPointerPtr->blobs = 0;
+
+    if (! aAnalysisPtr->is_ready || (width <= 0) || (height <= 0) || (aScaleShift > MAX_SCALE_SHIFT) ||
+        (aRoiPtr->w > aAnalysisPtr->width) || (aRoiPtr->h > aAnalysisPtr->height) ||
+        ((aScaleShift > 0) && (width > aAnalysisPtr->scaled_width)))
+    {
+        return;
+    }
+
+    roi_ptr = aPixelsPtr + aRoiPtr->y * aStride + aRoiPtr->x * (gint) aAnalysisPtr->pixel->size;
+
+    kms_detectix_blobs_begin(&aAnalysisPtr->blobs);
+
+    for (top = 0; top < height; top += aAnalysisPtr->strip_rows)
+    {
+        gint bottom     = MIN(height, top + aAnalysisPtr->strip_rows);
+        gint need_top   = MAX(0, top - OPEN_HALO);
+        gint need_end   = MIN(height, bottom + OPEN_HALO);
+        gint eroded_top;
+        gint eroded_end;
+
+        // the halo of the previous strip moves up to the top of the band
+        if (need_top > band_top)
+        {
+            memmove(aAnalysisPtr->mask, aAnalysisPtr->mask + (need_top - band_top) * stride,
+                    (gsize) (band_end - need_top) * stride * sizeof(guint64));
+            band_top = need_top;
+        }
+
+        classify_rows(aAnalysisPtr, roi_ptr, aStride, width, band_end, need_end - band_end, aScaleShift, aRangePtr,
+                      aAnalysisPtr->mask + (band_end - band_top) * stride);
+
+        band_end = need_end;
+
+        /*
+         * opening removes isolated noise pixels before looking for blobs, 64 of them per word
+         * operation --- the kernels take the first and last rows they are given for the border,
+         * so only rows inside the band are kept
+         */
+        kernels_ptr->erode(aAnalysisPtr->mask, stride, aAnalysisPtr->eroded, stride, width, band_end - band_top);
+
+        eroded_top = (band_top == 0)      ? 0      : band_top + 1;
+        eroded_end = (band_end == height) ? height : band_end - 1;
+
+        kernels_ptr->dilate(aAnalysisPtr->eroded + (eroded_top - band_top) * stride, stride, aAnalysisPtr->opened, stride,
+                            width, eroded_end - eroded_top);
+
+        kms_detectix_blobs_add_rows(&aAnalysisPtr->blobs, aAnalysisPtr->opened + (top - eroded_top) * stride, stride, width,
+                                    top, bottom - top);
+    }
+
+    is_blob = kms_detectix_blobs_end(&aAnalysisPtr->blobs, &blob);
+
+    aPointerPtr->blobs = aAnalysisPtr->blobs.num_blobs;
+
+    if (! is_blob || (blob.area < MIN_POINTER_AREA))
+    {
+        return;
+    }
+
+    box_w = blob.right  - blob.left + 1;
+    box_h = blob.bottom - blob.top  + 1;
+
+    aPointerPtr->found      = TRUE;
+    aPointerPtr->x          = aRoiPtr->x + (gint) (((gdouble) blob.sum_x / blob.area) * (1 << aScaleShift));
+    aPointerPtr->y          = aRoiPtr->y + (gint) (((gdouble) blob.sum_y / blob.area) * (1 << aScaleShift));
+    aPointerPtr->bounds.x   = aRoiPtr->x + (blob.left << aScaleShift);
+    aPointerPtr->bounds.y   = aRoiPtr->y + (blob.top  << aScaleShift);
+    aPointerPtr->bounds.w   = box_w << aScaleShift;
+    aPointerPtr->bounds.h   = box_h << aScaleShift;
+    aPointerPtr->confidence = MIN(1.0, (gdouble) blob.area / (gdouble) (box_w * box_h));
+
+    return;
+}
+
+// ends file:  "kmsdetectixanalysis.c"
@@ -0,0 +1,77 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_ANALYSIS_H_
+#define _KMS_DETECTIX_ANALYSIS_H_
+
+#include <gst/video/video.h>
+
+#include "kmsdetectixkernels.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Pointer search of one frame.
+ *
+ * The search window is downscaled, classified against the calibrated color
+ * range, opened and labeled; the largest component is the pointer. Every
+ * buffer this needs comes from one arena carved in set_info, so frames of
+ * the same caps never allocate. The frame itself is read in place.
+ */
+
+typedef struct _KmsDetectixColorRange
+{
+    guint8      low[3];     // B, G, R
+    guint8      high[3];
+
+} KmsDetectixColorRange;
+
+
+typedef struct _KmsDetectixPointer
+{
+    gboolean            found;
+    gint                x;              // centroid, frame coordinates
+    gint                y;
+    GstVideoRectangle   bounds;         // bounding box, frame coordinates
+    gdouble             confidence;     // blob area over bounding box area
+    guint               blobs;          // components in the mask, found or not
+
+} KmsDetectixPointer;
+
+
+typedef struct _KmsDetectixAnalysis KmsDetectixAnalysis;
+
+
+KmsDetectixAnalysis * kms_detectix_analysis_new(void);
+
+void kms_detectix_analysis_free(KmsDetectixAnalysis * aAnalysisPtr);
+
+// sizes the arena for frames of the caps --- the only place scratch memory is allocated
+gboolean kms_detectix_analysis_set_info(KmsDetectixAnalysis * aAnalysisPtr, gint aWidth, gint aHeight, KmsDetectixLayout aLayout);
+
+void kms_detectix_analysis_release(KmsDetectixAnalysis * aAnalysisPtr);
+
+void kms_detectix_analysis_find_pointer(KmsDetectixAnalysis         * aAnalysisPtr,
+                                        const guint8                * aPixelsPtr,
+                                        gint                          aStride,
+                                        const GstVideoRectangle     * aRoiPtr,
+                                        guint                         aScaleShift,
+                                        const KmsDetectixColorRange * aRangePtr,
+                                        KmsDetectixPointer          * aPointerPtr);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixarena.h"
+
+#include <stdlib.h>
+
+
+struct _KmsDetectixArena
+{
+    guint8    * block;      // KMS_DETECTIX_ARENA_ALIGN aligned, NULL when released
+    gsize       size;       // bytes allocated
+    gsize       capacity;   // bytes prepared for
+    gsize       used;
+};
+
+
+KmsDetectixArena * kms_detectix_arena_new(void)
+{
+    return g_slice_new0(KmsDetectixArena);
+}
+
+
+void kms_detectix_arena_free(KmsDetectixArena * aArenaPtr)
+{
+    if (aArenaPtr == NULL)
+    {
+        return;
+    }
+
+    kms_detectix_arena_release(aArenaPtr);
+
+    g_slice_free(KmsDetectixArena, aArenaPtr);
+
+    return;
+}
+
+
+gboolean kms_detectix_arena_prepare(KmsDetectixArena * aArenaPtr, gsize aCapacity)
+{
+    aArenaPtr->capacity = 0;
+    aArenaPtr->used     = 0;
+
+    if (aCapacity > aArenaPtr->size)
+    {
+        void * block_ptr = NULL;
+
+        kms_detectix_arena_release(aArenaPtr);
+
+        if (posix_memalign(&block_ptr, KMS_DETECTIX_ARENA_ALIGN, aCapacity) != 0)
+        {
+            return FALSE;
+        }
+
+        aArenaPtr->block = block_ptr;
+        aArenaPtr->size  = aCapacity;
+    }
+
+    aArenaPtr->capacity = aCapacity;
+
+    return TRUE;
+}
+
+
+gpointer kms_detectix_arena_take(KmsDetectixArena * aArenaPtr, gsize aSize)
+{
+    gsize    size = kms_detectix_arena_round(aSize);
+    gpointer piece_ptr;
+
+    if ((aArenaPtr->block == NULL) || (size > aArenaPtr->capacity - aArenaPtr->used))
+    {
+        return NULL;
+    }
+
+    piece_ptr        = aArenaPtr->block + aArenaPtr->used;
+    aArenaPtr->used += size;
+
+    return piece_ptr;
+}
+
+
+void kms_detectix_arena_release(KmsDetectixArena * aArenaPtr)
+{
+    free(aArenaPtr->block);
+
+    aArenaPtr->block    = NULL;
+    aArenaPtr->size     = 0;
+    aArenaPtr->capacity = 0;
+    aArenaPtr->used     = 0;
+
+    return;
+}
+
+// ends file:  "kmsdetectixarena.c"
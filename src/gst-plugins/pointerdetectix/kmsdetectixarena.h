@@ -0,0 +1,64 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_ARENA_H_
+#define _KMS_DETECTIX_ARENA_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Scratch memory of the analysis.
+ *
+ * One cache line aligned block holds every per-frame buffer: planes, masks,
+ * label runs and blob lists. It is carved once per caps, every piece on its
+ * own cache line, and reused by every frame until the caps change or
+ * streaming stops, so the steady state never calls the allocator. The block
+ * is only reallocated when new caps need more than it already has.
+ */
+
+#define KMS_DETECTIX_ARENA_ALIGN    64
+
+typedef struct _KmsDetectixArena KmsDetectixArena;
+
+
+// bytes a piece of aSize takes in the arena
+static inline gsize kms_detectix_arena_round(gsize aSize)
+{
+    return (aSize + KMS_DETECTIX_ARENA_ALIGN - 1) & ~((gsize) KMS_DETECTIX_ARENA_ALIGN - 1);
+}
+
+
+KmsDetectixArena * kms_detectix_arena_new(void);
+
+void kms_detectix_arena_free(KmsDetectixArena * aArenaPtr);
+
+/*
+ * empties the arena for aCapacity bytes of rounded pieces, keeping the block
+ * when it is large enough --- FALSE when it cannot be allocated
+ */
+gboolean kms_detectix_arena_prepare(KmsDetectixArena * aArenaPtr, gsize aCapacity);
+
+// next aligned piece, NULL when the prepared capacity is exhausted
+gpointer kms_detectix_arena_take(KmsDetectixArena * aArenaPtr, gsize aSize);
+
+// gives the block back, e.g. when streaming stops
+void kms_detectix_arena_release(KmsDetectixArena * aArenaPtr);
+
+G_END_DECLS
+
+#endif
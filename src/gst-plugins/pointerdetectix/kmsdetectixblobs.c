@@ -0,0 +1,277 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixblobs.h"
+
+
+struct _KmsDetectixRun
+{
+    guint16     start;      // first and last set column
+    guint16     end;
+    guint16     row;
+};
+
+
+static guint runs_for(gint aWidth, gint aHeight)
+{
+    // every other pixel set is the most runs a mask can hold
+    return (guint) MIN((gsize) aHeight * (gsize) ((aWidth + 1) / 2), KMS_DETECTIX_BLOBS_MAX_RUNS);
+}
+
+
+gsize kms_detectix_blobs_scratch_size(gint aWidth, gint aHeight)
+{
+    guint capacity = runs_for(aWidth, aHeight);
+
+    return kms_detectix_arena_round(capacity * sizeof(KmsDetectixRun)) +
+           kms_detectix_arena_round(capacity * sizeof(guint32)) +
+           kms_detectix_arena_round(capacity * sizeof(KmsDetectixBlob));
+}
+
+
+gboolean kms_detectix_blobs_init(KmsDetectixBlobs * aBlobsPtr, KmsDetectixArena * aArenaPtr, gint aWidth, gint aHeight)
+{
+    if ((aWidth <= 0) || (aHeight <= 0) || (aWidth > G_MAXUINT16) || (aHeight > G_MAXUINT16))
+    {
+        aBlobsPtr->capacity = 0;
+
+        return FALSE;
+    }
+
+    aBlobsPtr->capacity = runs_for(aWidth, aHeight);
+    aBlobsPtr->runs     = kms_detectix_arena_take(aArenaPtr, aBlobsPtr->capacity * sizeof(KmsDetectixRun));
+    aBlobsPtr->parents  = kms_detectix_arena_take(aArenaPtr, aBlobsPtr->capacity * sizeof(guint32));
+    aBlobsPtr->blobs    = kms_detectix_arena_take(aArenaPtr, aBlobsPtr->capacity * sizeof(KmsDetectixBlob));
+
+    if ((aBlobsPtr->runs == NULL) || (aBlobsPtr->parents == NULL) || (aBlobsPtr->blobs == NULL))
+    {
+        aBlobsPtr->capacity = 0;
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+// parents always point to a lower run, roots to themselves
+static guint32 find_root(guint32 * aParentsPtr, guint32 aRun)
+{
+    while (aParentsPtr[aRun] != aRun)
+    {
+        aParentsPtr[aRun] = aParentsPtr[aParentsPtr[aRun]];
+        aRun              = aParentsPtr[aRun];
+    }
+
+    return aRun;
+}
+
+
+static void join(guint32 * aParentsPtr, guint32 aRun, guint32 aOther)
+{
+    guint32 root  = find_root(aParentsPtr, aRun);
+    guint32 other = find_root(aParentsPtr, aOther);
+
+    if (root < other)
+    {
+        aParentsPtr[other] = root;
+    }
+    else if (other < root)
+    {
+        aParentsPtr[root] = other;
+    }
+
+    return;
+}
+
+
+// first column from aCol on whose mask bit is aBit, aWidth when there is none
+static gint find_bit(const guint64 * aRowPtr, gint aCol, gint aWidth, gboolean aBit)
+{
+    guint64 flip = aBit ? 0 : G_MAXUINT64;
+    gint    word = aCol / 64;
+    guint64 bits;
+
+    if (aCol >= aWidth)
+    {
+        return aWidth;
+    }
+
+    bits = (aRowPtr[word] ^ flip) & (G_MAXUINT64 << (aCol % 64));
+
+    while (bits == 0)
+    {
+        if (++word * 64 >= aWidth)
+        {
+            return aWidth;
+        }
+
+        bits = aRowPtr[word] ^ flip;
+    }
+
+    return MIN(aWidth, word * 64 + __builtin_ctzll(bits));
+}
+
+
+void kms_detectix_blobs_begin(KmsDetectixBlobs * aBlobsPtr)
+{
+    aBlobsPtr->num_blobs = 0;
+    aBlobsPtr->num_runs  = 0;
+    aBlobsPtr->above     = 0;
+    aBlobsPtr->is_full   = (aBlobsPtr->capacity == 0);
+
+    return;
+}
+
+
+void kms_detectix_blobs_add_rows(KmsDetectixBlobs * aBlobsPtr,
+                                 const guint64    * aMaskPtr,
+                                 gint               aStride,
+                                 gint               aWidth,
+                                 gint               aFirstRow,
+                                 gint               aNumRows)
+{
+    KmsDetectixRun * runs_ptr    = aBlobsPtr->runs;
+    guint32        * parents_ptr = aBlobsPtr->parents;
+    guint            count       = aBlobsPtr->num_runs;
+    guint            above_begin = aBlobsPtr->above;
+    guint            above_end   = count;
+    gint             row;
+
+    // the runs above the first row are those of the last row of the previous call
+    for (row = 0; ! aBlobsPtr->is_full && (row < aNumRows); row++)
+    {
+        const guint64 * mask_ptr = aMaskPtr + row * aStride;
+        guint           above    = above_begin;
+        guint           begin    = count;
+        gint            col      = 0;
+
+        // runs are found a word at a time, a row of empty words costs one test each
+        while ((col = find_bit(mask_ptr, col, aWidth, TRUE)) < aWidth)
+        {
+            guint touching;
+            gint  start = col;
+
+            col = find_bit(mask_ptr, col, aWidth, FALSE);
+
+            if (count == aBlobsPtr->capacity)
+            {
+                aBlobsPtr->is_full = TRUE;
+                break;
+            }
+
+            runs_ptr[count].start = (guint16) start;
+            runs_ptr[count].end   = (guint16) (col - 1);
+            runs_ptr[count].row   = (guint16) (aFirstRow + row);
+            parents_ptr[count]    = count;
+
+            // runs above that end left of this one cannot touch any later run either
+            while ((above < above_end) && (runs_ptr[above].end + 1 < start))
+            {
+                above++;
+            }
+
+            for (touching = above; (touching < above_end) && (runs_ptr[touching].start <= col); touching++)
+            {
+                join(parents_ptr, count, touching);
+            }
+
+            count++;
+        }
+
+        above_begin = begin;
+        above_end   = count;
+    }
+
+    aBlobsPtr->num_runs = count;
+    aBlobsPtr->above    = above_begin;
+
+    return;
+}
+
+
+gboolean kms_detectix_blobs_end(KmsDetectixBlobs * aBlobsPtr, KmsDetectixBlob * aBlobPtr)
+{
+    KmsDetectixRun * runs_ptr    = aBlobsPtr->runs;
+    guint32        * parents_ptr = aBlobsPtr->parents;
+    guint            count       = aBlobsPtr->num_runs;
+    guint            best        = 0;
+    guint            index;
+
+    aBlobsPtr->num_blobs = 0;
+
+    if (aBlobsPtr->is_full || (count == 0))
+    {
+        return FALSE;
+    }
+
+    // ascending order meets every parent already flattened to its root
+    for (index = 0; index < count; index++)
+    {
+        const KmsDetectixRun * run_ptr = &runs_ptr[index];
+        guint                  length  = run_ptr->end - run_ptr->start + 1u;
+        guint32                root    = parents_ptr[parents_ptr[index]];
+        KmsDetectixBlob      * blob_ptr = &aBlobsPtr->blobs[root];
+
+        parents_ptr[index] = root;
+
+        if (root == index)
+        {
+            aBlobsPtr->num_blobs++;
+
+            blob_ptr->area   = 0;
+            blob_ptr->left   = run_ptr->start;
+            blob_ptr->top    = run_ptr->row;
+            blob_ptr->right  = run_ptr->end;
+            blob_ptr->bottom = run_ptr->row;
+            blob_ptr->sum_x  = 0;
+            blob_ptr->sum_y  = 0;
+        }
+
+        blob_ptr->area   += length;
+        blob_ptr->left    = MIN(blob_ptr->left,   run_ptr->start);
+        blob_ptr->right   = MAX(blob_ptr->right,  run_ptr->end);
+        blob_ptr->bottom  = MAX(blob_ptr->bottom, run_ptr->row);
+        blob_ptr->sum_x  += (guint64) (run_ptr->start + run_ptr->end) * length / 2;
+        blob_ptr->sum_y  += (guint64) run_ptr->row * length;
+
+        if (blob_ptr->area > aBlobsPtr->blobs[best].area)
+        {
+            best = root;
+        }
+    }
+
+    *aBlobPtr = aBlobsPtr->blobs[best];
+
+    return TRUE;
+}
+
+
+gboolean kms_detectix_blobs_largest(KmsDetectixBlobs * aBlobsPtr,
+                                    const guint64    * aMaskPtr,
+                                    gint               aStride,
+                                    gint               aWidth,
+                                    gint               aHeight,
+                                    KmsDetectixBlob  * aBlobPtr)
+{
+    kms_detectix_blobs_begin(aBlobsPtr);
+    kms_detectix_blobs_add_rows(aBlobsPtr, aMaskPtr, aStride, aWidth, 0, aHeight);
+
+    return kms_detectix_blobs_end(aBlobsPtr, aBlobPtr);
+}
+
+// ends file:  "kmsdetectixblobs.c"
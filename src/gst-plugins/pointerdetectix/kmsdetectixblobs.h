@@ -0,0 +1,98 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_BLOBS_H_
+#define _KMS_DETECTIX_BLOBS_H_
+
+#include "kmsdetectixarena.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Connected components of the pointer mask.
+ *
+ * The mask, one bit per pixel as the kernels write it, is read once, row by
+ * row, as runs of set bits. Runs that touch a run of the row above,
+ * diagonals included, are joined in a union-find forest, then a single pass
+ * over the runs sums area, bounding box and moments per component. Runs, parents and sums live in the analysis arena;
+ * a mask with more runs than it was sized for is reported as too noisy to
+ * hold a pointer. Rows may come in strips, so the mask of a whole frame
+ * never has to exist at once.
+ */
+
+#define KMS_DETECTIX_BLOBS_MAX_RUNS     16384
+
+
+typedef struct _KmsDetectixBlob
+{
+    guint       area;       // set pixels
+    guint16     left;       // bounding box, inclusive
+    guint16     top;
+    guint16     right;
+    guint16     bottom;
+    guint64     sum_x;      // first moments, area times the centroid
+    guint64     sum_y;
+
+} KmsDetectixBlob;
+
+
+typedef struct _KmsDetectixRun  KmsDetectixRun;
+
+typedef struct _KmsDetectixBlobs
+{
+    KmsDetectixRun    * runs;
+    guint32           * parents;
+    KmsDetectixBlob   * blobs;      // indexed by the run that is the root of each component
+    guint               capacity;
+    guint               num_blobs;  // components of the last mask, 0 when it was too noisy
+    guint               num_runs;   // of the mask being added
+    guint               above;      // first run of the last row added
+    gboolean            is_full;    // more runs than capacity, the mask is dropped
+
+} KmsDetectixBlobs;
+
+
+// arena bytes the scratch of a aWidth x aHeight mask takes
+gsize kms_detectix_blobs_scratch_size(gint aWidth, gint aHeight);
+
+// carves the scratch out of an arena prepared with room for kms_detectix_blobs_scratch_size
+gboolean kms_detectix_blobs_init(KmsDetectixBlobs * aBlobsPtr, KmsDetectixArena * aArenaPtr, gint aWidth, gint aHeight);
+
+// starts a mask whose rows are added in order by add_rows
+void kms_detectix_blobs_begin(KmsDetectixBlobs * aBlobsPtr);
+
+// aNumRows mask rows of aWidth pixels, aStride words apart, the first of them row aFirstRow of the mask, right below the rows added before
+void kms_detectix_blobs_add_rows(KmsDetectixBlobs * aBlobsPtr,
+                                 const guint64    * aMaskPtr,
+                                 gint               aStride,
+                                 gint               aWidth,
+                                 gint               aFirstRow,
+                                 gint               aNumRows);
+
+// FALSE when the mask added since begin is empty or has more runs than the scratch holds
+gboolean kms_detectix_blobs_end(KmsDetectixBlobs * aBlobsPtr, KmsDetectixBlob * aBlobPtr);
+
+// begin, all the rows and end in one call
+gboolean kms_detectix_blobs_largest(KmsDetectixBlobs * aBlobsPtr,
+                                    const guint64    * aMaskPtr,
+                                    gint               aStride,
+                                    gint               aWidth,
+                                    gint               aHeight,
+                                    KmsDetectixBlob  * aBlobPtr);
+
+G_END_DECLS
+
+#endif
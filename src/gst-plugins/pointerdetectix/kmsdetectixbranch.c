@@ -0,0 +1,418 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixbranch.h"
+
+#include <string.h>
+#include <stdio.h>
+
+
+typedef enum
+{
+    e_BRANCH_TEE,
+    e_BRANCH_QUEUE,
+    e_BRANCH_CONVERT,
+    e_BRANCH_FILTER,
+    e_BRANCH_SINK,
+    e_BRANCH_NUM_ELEMENTS
+
+} BRANCH_ELEMENTS_e;
+
+
+static const gchar * The_Branch_Factories[e_BRANCH_NUM_ELEMENTS] = { "tee", "queue", "videoconvert", "capsfilter", "fakesink" };
+
+static gint The_Branch_Count = 0;
+
+
+struct _KmsDetectixBranch
+{
+    gint            ref_count;
+    gint            is_flowing;         // atomic --- set by the splice probe
+    gint            is_removed;         // atomic --- set by unsplice, a late splice probe does nothing
+    GstBin        * bin_ptr;            // parent of producer and consumer, owns the branch elements
+    GstPad        * producer_pad;
+    GstPad        * consumer_pad;
+    GstPad        * tee_main_pad;       // request pads of the tee, media and analysis
+    GstPad        * tee_side_pad;
+    GstElement    * elements[e_BRANCH_NUM_ELEMENTS];
+};
+
+
+static gboolean is_auto(const gchar * aNamePtr)
+{
+    return (aNamePtr == NULL) || (strcmp(aNamePtr, "auto") == 0);
+}
+
+
+static KmsDetectixBranch * branch_ref(KmsDetectixBranch * aBranchPtr)
+{
+    g_atomic_int_inc(&aBranchPtr->ref_count);
+
+    return aBranchPtr;
+}
+
+
+void kms_detectix_branch_unref(KmsDetectixBranch * aBranchPtr)
+{
+    gint index;
+
+    if ((aBranchPtr == NULL) || ! g_atomic_int_dec_and_test(&aBranchPtr->ref_count))
+    {
+        return;
+    }
+
+    for (index = 0; index < e_BRANCH_NUM_ELEMENTS; index++)
+    {
+        if (aBranchPtr->elements[index] != NULL)
+        {
+            gst_object_unref(aBranchPtr->elements[index]);
+        }
+    }
+
+    if (aBranchPtr->tee_main_pad != NULL)   gst_object_unref(aBranchPtr->tee_main_pad);
+    if (aBranchPtr->tee_side_pad != NULL)   gst_object_unref(aBranchPtr->tee_side_pad);
+    if (aBranchPtr->producer_pad != NULL)   gst_object_unref(aBranchPtr->producer_pad);
+    if (aBranchPtr->consumer_pad != NULL)   gst_object_unref(aBranchPtr->consumer_pad);
+    if (aBranchPtr->bin_ptr      != NULL)   gst_object_unref(aBranchPtr->bin_ptr);
+
+    g_slice_free(KmsDetectixBranch, aBranchPtr);
+
+    return;
+}
+
+
+gboolean kms_detectix_branch_is_flowing(KmsDetectixBranch * aBranchPtr)
+{
+    return (aBranchPtr != NULL) && g_atomic_int_get(&aBranchPtr->is_flowing);
+}
+
+
+// "auto" is the parent of the element, otherwise the closest ancestor with that name
+static GstBin * find_link_bin(GstElement * aElementPtr, const gchar * aNamePtr)
+{
+    GstObject * parent_ptr = gst_object_get_parent(GST_OBJECT(aElementPtr));
+
+    while ((parent_ptr != NULL) && ! is_auto(aNamePtr))
+    {
+        gchar     * name_ptr = gst_object_get_name(parent_ptr);
+        gboolean    is_found = (g_strcmp0(name_ptr, aNamePtr) == 0);
+        GstObject * next_ptr = is_found ? NULL : gst_object_get_parent(parent_ptr);
+
+        g_free(name_ptr);
+
+        if (is_found)
+        {
+            break;
+        }
+
+        gst_object_unref(parent_ptr);
+        parent_ptr = next_ptr;
+    }
+
+    if ((parent_ptr != NULL) && ! GST_IS_BIN(parent_ptr))
+    {
+        gst_object_unref(parent_ptr);
+        parent_ptr = NULL;
+    }
+
+    return (GstBin *) parent_ptr;
+}
+
+
+// "auto" is the pad linked to the consumer when it belongs to the producer
+static GstPad * get_producer_pad(GstElement * aProducerPtr, const gchar * aNamePtr, GstPad * aConsumerPadPtr)
+{
+    GstPad * peer_ptr;
+
+    if (! is_auto(aNamePtr))
+    {
+        return gst_element_get_static_pad(aProducerPtr, aNamePtr);
+    }
+
+    peer_ptr = gst_pad_get_peer(aConsumerPadPtr);
+
+    if ((peer_ptr != NULL) && (GST_OBJECT_PARENT(peer_ptr) == GST_OBJECT(aProducerPtr)))
+    {
+        return peer_ptr;
+    }
+
+    if (peer_ptr != NULL)
+    {
+        gst_object_unref(peer_ptr);
+    }
+
+    return gst_element_get_static_pad(aProducerPtr, "src");
+}
+
+
+static GstPadProbeReturn splice_probe(GstPad * aPadPtr, GstPadProbeInfo * aInfoPtr, gpointer aDataPtr)
+{
+    KmsDetectixBranch * branch_ptr   = (KmsDetectixBranch *) aDataPtr;
+    GstPad            * tee_sink_ptr;
+
+    if (g_atomic_int_get(&branch_ptr->is_removed))
+    {
+        return GST_PAD_PROBE_REMOVE;
+    }
+
+    tee_sink_ptr = gst_element_get_static_pad(branch_ptr->elements[e_BRANCH_TEE], "sink");
+
+    gst_pad_unlink(branch_ptr->producer_pad, branch_ptr->consumer_pad);
+
+    if ((gst_pad_link(branch_ptr->producer_pad, tee_sink_ptr) == GST_PAD_LINK_OK) &&
+        (gst_pad_link(branch_ptr->tee_main_pad, branch_ptr->consumer_pad) == GST_PAD_LINK_OK))
+    {
+        g_atomic_int_set(&branch_ptr->is_flowing, TRUE);
+    }
+    else
+    {
+        GST_WARNING_OBJECT(aPadPtr, "tee could not be spliced, keeping the direct link");
+
+        gst_pad_unlink(branch_ptr->producer_pad, tee_sink_ptr);
+        gst_pad_unlink(branch_ptr->tee_main_pad, branch_ptr->consumer_pad);
+        gst_pad_link(branch_ptr->producer_pad, branch_ptr->consumer_pad);
+    }
+
+    gst_object_unref(tee_sink_ptr);
+
+    return GST_PAD_PROBE_REMOVE;
+}
+
+
+static void remove_elements(KmsDetectixBranch * aBranchPtr)
+{
+    gint index;
+
+    for (index = 0; index < e_BRANCH_NUM_ELEMENTS; index++)
+    {
+        gst_element_set_state(aBranchPtr->elements[index], GST_STATE_NULL);
+    }
+
+    gst_element_release_request_pad(aBranchPtr->elements[e_BRANCH_TEE], aBranchPtr->tee_main_pad);
+    gst_element_release_request_pad(aBranchPtr->elements[e_BRANCH_TEE], aBranchPtr->tee_side_pad);
+
+    for (index = 0; index < e_BRANCH_NUM_ELEMENTS; index++)
+    {
+        gst_bin_remove(aBranchPtr->bin_ptr, aBranchPtr->elements[index]);
+    }
+
+    return;
+}
+
+
+/*
+ * the producer is idle, so no buffer is inside the tee --- the branch threads are
+ * stopped from here, the queue task is not the streaming thread running this probe
+ */
+static GstPadProbeReturn unsplice_probe(GstPad * aPadPtr, GstPadProbeInfo * aInfoPtr, gpointer aDataPtr)
+{
+    KmsDetectixBranch * branch_ptr   = (KmsDetectixBranch *) aDataPtr;
+    GstPad            * tee_sink_ptr = gst_element_get_static_pad(branch_ptr->elements[e_BRANCH_TEE], "sink");
+
+    g_atomic_int_set(&branch_ptr->is_flowing, FALSE);
+
+    if (gst_pad_unlink(branch_ptr->producer_pad, tee_sink_ptr))
+    {
+        gst_pad_unlink(branch_ptr->tee_main_pad, branch_ptr->consumer_pad);
+        gst_pad_link(branch_ptr->producer_pad, branch_ptr->consumer_pad);
+    }
+
+    gst_object_unref(tee_sink_ptr);
+
+    remove_elements(branch_ptr);
+
+    return GST_PAD_PROBE_REMOVE;
+}
+
+
+static KmsDetectixBranch * build_branch(GstElement * aElementPtr, GstCaps * aCapsPtr, GCallback aHandoff, gpointer aHandoffObject,
+                                        gchar * aNotePtr, gsize aNoteSize)
+{
+    KmsDetectixBranch * branch_ptr = g_slice_new0(KmsDetectixBranch);
+    gchar             * owner_ptr  = gst_object_get_name(GST_OBJECT(aElementPtr));
+    guint               number     = (guint) g_atomic_int_add(&The_Branch_Count, 1);
+    GstPad            * queue_pad;
+    gint                index;
+
+    branch_ptr->ref_count = 1;
+
+    for (index = 0; index < e_BRANCH_NUM_ELEMENTS; index++)
+    {
+        // named after the detector, so the branch is recognizable in the elements list
+        gchar * name_ptr = g_strdup_printf("%s-branch%u-%s", owner_ptr, number, The_Branch_Factories[index]);
+
+        branch_ptr->elements[index] = gst_element_factory_make(The_Branch_Factories[index], name_ptr);
+
+        g_free(name_ptr);
+
+        if (branch_ptr->elements[index] == NULL)
+        {
+            snprintf(aNotePtr, aNoteSize, "note=element (%s) is not available", The_Branch_Factories[index]);
+
+            g_free(owner_ptr);
+            kms_detectix_branch_unref(branch_ptr);
+            return NULL;
+        }
+
+        gst_object_ref_sink(branch_ptr->elements[index]);
+    }
+
+    g_free(owner_ptr);
+
+    // at most one frame waits for the analysis, older ones are dropped
+    g_object_set(branch_ptr->elements[e_BRANCH_QUEUE], "leaky", 2, "max-size-buffers", 1,
+                 "max-size-bytes", 0, "max-size-time", (guint64) 0, "silent", TRUE, NULL);
+
+    g_object_set(branch_ptr->elements[e_BRANCH_FILTER], "caps", aCapsPtr, NULL);
+
+    g_object_set(branch_ptr->elements[e_BRANCH_SINK], "sync", FALSE, "async", FALSE, "qos", FALSE,
+                 "enable-last-sample", FALSE, "signal-handoffs", TRUE, NULL);
+
+    g_signal_connect_object(branch_ptr->elements[e_BRANCH_SINK], "handoff", aHandoff, aHandoffObject, (GConnectFlags) 0);
+
+    branch_ptr->tee_main_pad = gst_element_get_request_pad(branch_ptr->elements[e_BRANCH_TEE], "src_%u");
+    branch_ptr->tee_side_pad = gst_element_get_request_pad(branch_ptr->elements[e_BRANCH_TEE], "src_%u");
+
+    queue_pad = gst_element_get_static_pad(branch_ptr->elements[e_BRANCH_QUEUE], "sink");
+
+    if ((branch_ptr->tee_main_pad == NULL) || (branch_ptr->tee_side_pad == NULL) ||
+        (gst_pad_link(branch_ptr->tee_side_pad, queue_pad) != GST_PAD_LINK_OK) ||
+        ! gst_element_link_many(branch_ptr->elements[e_BRANCH_QUEUE], branch_ptr->elements[e_BRANCH_CONVERT],
+                                branch_ptr->elements[e_BRANCH_FILTER], branch_ptr->elements[e_BRANCH_SINK], NULL))
+    {
+        snprintf(aNotePtr, aNoteSize, "note=analysis branch could not be linked");
+
+        gst_object_unref(queue_pad);
+        kms_detectix_branch_unref(branch_ptr);
+        return NULL;
+    }
+
+    gst_object_unref(queue_pad);
+
+    return branch_ptr;
+}
+
+
+KmsDetectixBranch * kms_detectix_branch_splice(GstElement    * aElementPtr,
+                                               gchar * const * aLinkPtr,
+                                               gchar * const * aPadsPtr,
+                                               GstCaps       * aCapsPtr,
+                                               GCallback       aHandoff,
+                                               gpointer        aHandoffObject,
+                                               gchar         * aNotePtr,
+                                               gsize           aNoteSize)
+{
+    GstBin            * search_ptr   = find_link_bin(aElementPtr, aLinkPtr[0]);
+    GstElement        * producer_ptr = NULL;
+    GstElement        * consumer_ptr = NULL;
+    GstPad            * producer_pad = NULL;
+    GstPad            * consumer_pad = NULL;
+    GstPad            * peer_pad     = NULL;
+    KmsDetectixBranch * branch_ptr   = NULL;
+    gint                index;
+
+    if (search_ptr == NULL)
+    {
+        snprintf(aNotePtr, aNoteSize, "note=pipeline (%s) not found", aLinkPtr[0]);
+        return NULL;
+    }
+
+    consumer_ptr = is_auto(aLinkPtr[2]) ? gst_object_ref(aElementPtr) : gst_bin_get_by_name(search_ptr, aLinkPtr[2]);
+    consumer_pad = consumer_ptr ? gst_element_get_static_pad(consumer_ptr, is_auto(aPadsPtr[1]) ? "sink" : aPadsPtr[1]) : NULL;
+
+    if (is_auto(aLinkPtr[1]))
+    {
+        peer_pad     = consumer_pad ? gst_pad_get_peer(consumer_pad) : NULL;
+        producer_ptr = peer_pad ? gst_pad_get_parent_element(peer_pad) : NULL;
+    }
+    else
+    {
+        producer_ptr = gst_bin_get_by_name(search_ptr, aLinkPtr[1]);
+    }
+
+    producer_pad = (producer_ptr && consumer_pad) ? get_producer_pad(producer_ptr, aPadsPtr[0], consumer_pad) : NULL;
+
+    if (peer_pad != NULL)
+    {
+        gst_object_unref(peer_pad);
+    }
+
+    peer_pad = producer_pad ? gst_pad_get_peer(producer_pad) : NULL;
+
+    if ((producer_pad == NULL) || (consumer_pad == NULL))
+    {
+        snprintf(aNotePtr, aNoteSize, "note=producer (%s) or consumer (%s) pad not found", aLinkPtr[1], aLinkPtr[2]);
+    }
+    else if ((peer_pad != consumer_pad) || (GST_OBJECT_PARENT(producer_ptr) != GST_OBJECT_PARENT(consumer_ptr)))
+    {
+        snprintf(aNotePtr, aNoteSize, "note=producer (%s) is not linked to consumer (%s) in the same bin", aLinkPtr[1], aLinkPtr[2]);
+    }
+    else
+    {
+        branch_ptr = build_branch(aElementPtr, aCapsPtr, aHandoff, aHandoffObject, aNotePtr, aNoteSize);
+    }
+
+    if (branch_ptr != NULL)
+    {
+        branch_ptr->bin_ptr      = GST_BIN(gst_object_get_parent(GST_OBJECT(producer_ptr)));
+        branch_ptr->producer_pad = gst_object_ref(producer_pad);
+        branch_ptr->consumer_pad = gst_object_ref(consumer_pad);
+
+        for (index = 0; index < e_BRANCH_NUM_ELEMENTS; index++)
+        {
+            gst_bin_add(branch_ptr->bin_ptr, branch_ptr->elements[index]);
+        }
+
+        // downstream first, so every element is ready before the tee receives a buffer
+        for (index = e_BRANCH_NUM_ELEMENTS - 1; index >= 0; index--)
+        {
+            gst_element_sync_state_with_parent(branch_ptr->elements[index]);
+        }
+
+        gst_pad_add_probe(producer_pad, GST_PAD_PROBE_TYPE_IDLE, splice_probe,
+                          branch_ref(branch_ptr), (GDestroyNotify) kms_detectix_branch_unref);
+    }
+
+    if (peer_pad     != NULL)   gst_object_unref(peer_pad);
+    if (producer_pad != NULL)   gst_object_unref(producer_pad);
+    if (consumer_pad != NULL)   gst_object_unref(consumer_pad);
+    if (producer_ptr != NULL)   gst_object_unref(producer_ptr);
+    if (consumer_ptr != NULL)   gst_object_unref(consumer_ptr);
+
+    gst_object_unref(search_ptr);
+
+    return branch_ptr;
+}
+
+
+void kms_detectix_branch_unsplice(KmsDetectixBranch * aBranchPtr)
+{
+    if (aBranchPtr == NULL)
+    {
+        return;
+    }
+
+    g_atomic_int_set(&aBranchPtr->is_removed, TRUE);
+
+    // the probe owns the caller reference from now on
+    gst_pad_add_probe(aBranchPtr->producer_pad, GST_PAD_PROBE_TYPE_IDLE, unsplice_probe,
+                      aBranchPtr, (GDestroyNotify) kms_detectix_branch_unref);
+
+    return;
+}
+
+// ends file:  "kmsdetectixbranch.c"
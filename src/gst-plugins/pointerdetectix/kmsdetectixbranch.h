@@ -0,0 +1,63 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_BRANCH_H_
+#define _KMS_DETECTIX_BRANCH_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Analysis branch described by the link and pads params.
+ *
+ * A tee is spliced between the producer and the consumer, the media keeps
+ * flowing through its first src pad while the second one feeds a leaky
+ * queue, a videoconvert and a fakesink whose handoff runs the analysis.
+ * The queue drops frames the analysis cannot keep up with, so the media
+ * path never waits on the detector. Both splice and unsplice happen from
+ * an idle probe on the producer pad, so they are safe while PLAYING.
+ */
+
+typedef struct _KmsDetectixBranch KmsDetectixBranch;
+
+
+/*
+ * NULL with the reason in aNotePtr when the names do not resolve to two linked
+ * pads of the same bin --- aHandoff is a fakesink "handoff" callback, disconnected
+ * automatically when aHandoffObject is finalized
+ */
+KmsDetectixBranch * kms_detectix_branch_splice(GstElement    * aElementPtr,
+                                               gchar * const * aLinkPtr,
+                                               gchar * const * aPadsPtr,
+                                               GstCaps       * aCapsPtr,
+                                               GCallback       aHandoff,
+                                               gpointer        aHandoffObject,
+                                               gchar         * aNotePtr,
+                                               gsize           aNoteSize);
+
+// restores the direct link and removes the branch elements, consumes the reference
+void kms_detectix_branch_unsplice(KmsDetectixBranch * aBranchPtr);
+
+// drops the reference without touching the topology, the bin owns the elements
+void kms_detectix_branch_unref(KmsDetectixBranch * aBranchPtr);
+
+// TRUE once the tee is linked and the media goes through it
+gboolean kms_detectix_branch_is_flowing(KmsDetectixBranch * aBranchPtr);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,369 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixcapture.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+
+struct _KmsDetectixCapture
+{
+    GMutex          lock;
+    gint            is_open;        // atomic --- lets frames skip the lock while not capturing
+    FILE          * file;
+    gchar         * caps;           // of the last frame written
+    guint64         time_ns;        // PTS of the last frame written
+};
+
+
+struct _KmsDetectixCaptureReader
+{
+    FILE          * file;
+    guint8        * data;
+    gsize           capacity;
+};
+
+
+KmsDetectixCapture * kms_detectix_capture_new(void)
+{
+    KmsDetectixCapture * capture_ptr = g_slice_new0(KmsDetectixCapture);
+
+    g_mutex_init(&capture_ptr->lock);
+
+    return capture_ptr;
+}
+
+
+void kms_detectix_capture_free(KmsDetectixCapture * aCapturePtr)
+{
+    if (aCapturePtr == NULL)
+    {
+        return;
+    }
+
+    kms_detectix_capture_open(aCapturePtr, NULL);
+
+    g_mutex_clear(&aCapturePtr->lock);
+
+    g_slice_free(KmsDetectixCapture, aCapturePtr);
+
+    return;
+}
+
+
+gboolean kms_detectix_capture_open(KmsDetectixCapture * aCapturePtr, const gchar * aPathPtr)
+{
+    gboolean is_ok = TRUE;
+
+    g_mutex_lock(&aCapturePtr->lock);
+
+    if (aCapturePtr->file != NULL)
+    {
+        fclose(aCapturePtr->file);
+        aCapturePtr->file = NULL;
+    }
+
+    g_free(aCapturePtr->caps);
+    aCapturePtr->caps    = NULL;
+    aCapturePtr->time_ns = 0;
+
+    if ((aPathPtr != NULL) && (aPathPtr[0] != '\0'))
+    {
+        aCapturePtr->file = g_fopen(aPathPtr, "wb");
+
+        is_ok = (aCapturePtr->file != NULL) &&
+                (fwrite(KMS_DETECTIX_CAPTURE_MAGIC, 1, strlen(KMS_DETECTIX_CAPTURE_MAGIC), aCapturePtr->file) ==
+                 strlen(KMS_DETECTIX_CAPTURE_MAGIC));
+
+        if (! is_ok && (aCapturePtr->file != NULL))
+        {
+            fclose(aCapturePtr->file);
+            aCapturePtr->file = NULL;
+        }
+    }
+
+    g_atomic_int_set(&aCapturePtr->is_open, aCapturePtr->file != NULL);
+
+    g_mutex_unlock(&aCapturePtr->lock);
+
+    return is_ok;
+}
+
+
+gboolean kms_detectix_capture_is_open(KmsDetectixCapture * aCapturePtr)
+{
+    return g_atomic_int_get(&aCapturePtr->is_open);
+}
+
+
+void kms_detectix_capture_flush(KmsDetectixCapture * aCapturePtr)
+{
+    g_mutex_lock(&aCapturePtr->lock);
+
+    if (aCapturePtr->file != NULL)
+    {
+        fflush(aCapturePtr->file);
+    }
+
+    g_mutex_unlock(&aCapturePtr->lock);
+
+    return;
+}
+
+
+// with the lock held --- a failed write closes the capture rather than leaving a torn record behind
+static void write_header(KmsDetectixCapture * aCapturePtr, KmsDetectixRecordType aType, gsize aSize)
+{
+    KmsDetectixRecordHeader header;
+
+    header.type    = aType;
+    header.size    = (guint32) aSize;
+    header.time_ns = aCapturePtr->time_ns;
+
+    if (fwrite(&header, sizeof(header), 1, aCapturePtr->file) != 1)
+    {
+        GST_WARNING ("capture stopped, cannot write");
+
+        fclose(aCapturePtr->file);
+        aCapturePtr->file = NULL;
+
+        g_atomic_int_set(&aCapturePtr->is_open, FALSE);
+    }
+
+    return;
+}
+
+
+static void write_payload(KmsDetectixCapture * aCapturePtr, const void * aDataPtr, gsize aSize)
+{
+    if ((aCapturePtr->file != NULL) && (aSize > 0) && (fwrite(aDataPtr, 1, aSize, aCapturePtr->file) != aSize))
+    {
+        GST_WARNING ("capture stopped, cannot write");
+
+        fclose(aCapturePtr->file);
+        aCapturePtr->file = NULL;
+
+        g_atomic_int_set(&aCapturePtr->is_open, FALSE);
+    }
+
+    return;
+}
+
+
+static void write_record(KmsDetectixCapture * aCapturePtr, KmsDetectixRecordType aType, const void * aDataPtr, gsize aSize)
+{
+    g_mutex_lock(&aCapturePtr->lock);
+
+    if (aCapturePtr->file != NULL)
+    {
+        write_header(aCapturePtr, aType, aSize);
+        write_payload(aCapturePtr, aDataPtr, aSize);
+    }
+
+    g_mutex_unlock(&aCapturePtr->lock);
+
+    return;
+}
+
+
+void kms_detectix_capture_frame(KmsDetectixCapture * aCapturePtr, const GstVideoFrame * aFramePtr)
+{
+    GstCaps      * caps_ptr;
+    gchar        * caps_text;
+    const guint8 * pixels_ptr = GST_VIDEO_FRAME_PLANE_DATA (aFramePtr, 0);
+    gint           stride     = GST_VIDEO_FRAME_PLANE_STRIDE (aFramePtr, 0);
+    gint           height     = GST_VIDEO_FRAME_HEIGHT (aFramePtr);
+    gsize          row_size   = (gsize) GST_VIDEO_FRAME_WIDTH (aFramePtr) * GST_VIDEO_FRAME_COMP_PSTRIDE (aFramePtr, 0);
+    GstClockTime   pts        = GST_BUFFER_PTS (aFramePtr->buffer);
+    gint           row;
+
+    if (! kms_detectix_capture_is_open(aCapturePtr))
+    {
+        return;
+    }
+
+    caps_ptr  = gst_video_info_to_caps((GstVideoInfo *) &aFramePtr->info);
+    caps_text = gst_caps_to_string(caps_ptr);
+
+    gst_caps_unref(caps_ptr);
+
+    g_mutex_lock(&aCapturePtr->lock);
+
+    aCapturePtr->time_ns = GST_CLOCK_TIME_IS_VALID (pts) ? pts : aCapturePtr->time_ns;
+
+    if ((aCapturePtr->file != NULL) && (g_strcmp0(caps_text, aCapturePtr->caps) != 0))
+    {
+        write_header(aCapturePtr, KMS_DETECTIX_RECORD_CAPS, strlen(caps_text));
+        write_payload(aCapturePtr, caps_text, strlen(caps_text));
+
+        g_free(aCapturePtr->caps);
+        aCapturePtr->caps = g_strdup(caps_text);
+    }
+
+    if (aCapturePtr->file != NULL)
+    {
+        write_header(aCapturePtr, KMS_DETECTIX_RECORD_FRAME, row_size * height);
+
+        for (row = 0; row < height; row++)
+        {
+            write_payload(aCapturePtr, pixels_ptr + row * stride, row_size);
+        }
+    }
+
+    g_mutex_unlock(&aCapturePtr->lock);
+
+    g_free(caps_text);
+
+    return;
+}
+
+
+void kms_detectix_capture_property(KmsDetectixCapture * aCapturePtr, const gchar * aNamePtr, const GValue * aValuePtr)
+{
+    gchar * value_text;
+    gchar * payload;
+    gsize   name_size;
+    gsize   value_size;
+
+    if (! kms_detectix_capture_is_open(aCapturePtr) || ((value_text = gst_value_serialize(aValuePtr)) == NULL))
+    {
+        return;
+    }
+
+    name_size  = strlen(aNamePtr) + 1;
+    value_size = strlen(value_text);
+    payload    = g_malloc(name_size + value_size);
+
+    memcpy(payload, aNamePtr, name_size);
+    memcpy(payload + name_size, value_text, value_size);
+
+    write_record(aCapturePtr, KMS_DETECTIX_RECORD_PROPERTY, payload, name_size + value_size);
+
+    g_free(payload);
+    g_free(value_text);
+
+    return;
+}
+
+
+void kms_detectix_capture_action(KmsDetectixCapture * aCapturePtr, const gchar * aNamePtr)
+{
+    if (kms_detectix_capture_is_open(aCapturePtr))
+    {
+        write_record(aCapturePtr, KMS_DETECTIX_RECORD_ACTION, aNamePtr, strlen(aNamePtr));
+    }
+
+    return;
+}
+
+
+void kms_detectix_capture_message(KmsDetectixCapture * aCapturePtr, const GstStructure * aStructurePtr)
+{
+    gchar * text;
+
+    if (! kms_detectix_capture_is_open(aCapturePtr))
+    {
+        return;
+    }
+
+    text = gst_structure_to_string(aStructurePtr);
+
+    write_record(aCapturePtr, KMS_DETECTIX_RECORD_MESSAGE, text, strlen(text));
+
+    g_free(text);
+
+    return;
+}
+
+
+KmsDetectixCaptureReader * kms_detectix_capture_reader_new(const gchar * aPathPtr)
+{
+    KmsDetectixCaptureReader * reader_ptr;
+    FILE                     * file_ptr = g_fopen(aPathPtr, "rb");
+    gchar                      magic[sizeof(KMS_DETECTIX_CAPTURE_MAGIC)] = "";
+
+    if (file_ptr == NULL)
+    {
+        return NULL;
+    }
+
+    if ((fread(magic, 1, strlen(KMS_DETECTIX_CAPTURE_MAGIC), file_ptr) != strlen(KMS_DETECTIX_CAPTURE_MAGIC)) ||
+        (strcmp(magic, KMS_DETECTIX_CAPTURE_MAGIC) != 0))
+    {
+        fclose(file_ptr);
+
+        return NULL;
+    }
+
+    reader_ptr = g_slice_new0(KmsDetectixCaptureReader);
+
+    reader_ptr->file = file_ptr;
+
+    return reader_ptr;
+}
+
+
+void kms_detectix_capture_reader_free(KmsDetectixCaptureReader * aReaderPtr)
+{
+    if (aReaderPtr == NULL)
+    {
+        return;
+    }
+
+    fclose(aReaderPtr->file);
+    g_free(aReaderPtr->data);
+
+    g_slice_free(KmsDetectixCaptureReader, aReaderPtr);
+
+    return;
+}
+
+
+gboolean kms_detectix_capture_reader_next(KmsDetectixCaptureReader * aReaderPtr, KmsDetectixRecord * aRecordPtr)
+{
+    KmsDetectixRecordHeader header;
+
+    if (fread(&header, sizeof(header), 1, aReaderPtr->file) != 1)
+    {
+        return FALSE;
+    }
+
+    // one spare byte keeps text payloads NUL terminated
+    if (header.size + 1u > aReaderPtr->capacity)
+    {
+        aReaderPtr->capacity = header.size + 1u;
+        aReaderPtr->data     = g_realloc(aReaderPtr->data, aReaderPtr->capacity);
+    }
+
+    if ((header.size > 0) && (fread(aReaderPtr->data, 1, header.size, aReaderPtr->file) != header.size))
+    {
+        return FALSE;
+    }
+
+    aReaderPtr->data[header.size] = '\0';
+
+    aRecordPtr->type    = (KmsDetectixRecordType) header.type;
+    aRecordPtr->time_ns = header.time_ns;
+    aRecordPtr->size    = header.size;
+    aRecordPtr->data    = aReaderPtr->data;
+
+    return TRUE;
+}
+
+// ends file:  "kmsdetectixcapture.c"
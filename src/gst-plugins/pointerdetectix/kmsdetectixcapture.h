@@ -0,0 +1,102 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_CAPTURE_H_
+#define _KMS_DETECTIX_CAPTURE_H_
+
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Capture of everything that drives pointerdetectix, for offline replay.
+ *
+ * A capture file is KMS_DETECTIX_CAPTURE_MAGIC followed by records, each a
+ * KmsDetectixRecordHeader in host byte order and its payload. Frames are
+ * stored as raw rows without stride padding, preceded by their caps each
+ * time the caps change; property changes, actions and the messages posted
+ * are interleaved in the order they happened, stamped with the PTS of the
+ * frame they followed. Replaying the frames, properties and actions through
+ * a new element should post the same messages.
+ */
+
+#define KMS_DETECTIX_CAPTURE_MAGIC      "DTXCAP01"
+
+typedef enum
+{
+    KMS_DETECTIX_RECORD_CAPS = 1,       // caps string of the frames that follow
+    KMS_DETECTIX_RECORD_FRAME,          // rows of plane 0, packed
+    KMS_DETECTIX_RECORD_PROPERTY,       // property name, a NUL, the serialized value
+    KMS_DETECTIX_RECORD_ACTION,         // action signal name
+    KMS_DETECTIX_RECORD_MESSAGE         // structure of a posted element message, as a string
+
+} KmsDetectixRecordType;
+
+
+typedef struct _KmsDetectixRecordHeader
+{
+    guint32     type;
+    guint32     size;       // payload bytes
+    guint64     time_ns;    // PTS of the frame, or of the last frame before the record
+
+} KmsDetectixRecordHeader;
+
+
+typedef struct _KmsDetectixRecord
+{
+    KmsDetectixRecordType   type;
+    guint64                 time_ns;
+    gsize                   size;
+    const guint8          * data;       // owned by the reader, valid until the next record
+
+} KmsDetectixRecord;
+
+
+typedef struct _KmsDetectixCapture       KmsDetectixCapture;
+typedef struct _KmsDetectixCaptureReader KmsDetectixCaptureReader;
+
+
+KmsDetectixCapture * kms_detectix_capture_new(void);
+
+void kms_detectix_capture_free(KmsDetectixCapture * aCapturePtr);
+
+// starts a new file, closing the previous one --- NULL or an empty path only closes
+gboolean kms_detectix_capture_open(KmsDetectixCapture * aCapturePtr, const gchar * aPathPtr);
+
+gboolean kms_detectix_capture_is_open(KmsDetectixCapture * aCapturePtr);
+
+void kms_detectix_capture_flush(KmsDetectixCapture * aCapturePtr);
+
+// any thread --- records are written whole, in the order the calls take the capture lock
+void kms_detectix_capture_frame(KmsDetectixCapture * aCapturePtr, const GstVideoFrame * aFramePtr);
+
+void kms_detectix_capture_property(KmsDetectixCapture * aCapturePtr, const gchar * aNamePtr, const GValue * aValuePtr);
+
+void kms_detectix_capture_action(KmsDetectixCapture * aCapturePtr, const gchar * aNamePtr);
+
+void kms_detectix_capture_message(KmsDetectixCapture * aCapturePtr, const GstStructure * aStructurePtr);
+
+
+KmsDetectixCaptureReader * kms_detectix_capture_reader_new(const gchar * aPathPtr);
+
+void kms_detectix_capture_reader_free(KmsDetectixCaptureReader * aReaderPtr);
+
+// FALSE at the end of the file, or at a truncated record
+gboolean kms_detectix_capture_reader_next(KmsDetectixCaptureReader * aReaderPtr, KmsDetectixRecord * aRecordPtr);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,276 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixcv.h"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+
+#define CALIBRATION_DEVIATIONS  2.5     // accepted spread around the calibrated mean
+#define CALIBRATION_TOLERANCE   20.0    // minimum spread for very uniform areas
+
+
+struct _KmsDetectixCv
+{
+    const KmsDetectixPixel    * pixel;      // layout of the caps and its kernels
+    void                     (* blend_row) (guint8 *, const guint8 *, gint, guint);
+};
+
+
+// header only --- no pixel is copied
+static cv::Mat wrap_pixels(const KmsDetectixCv * aCvPtr, guint8 * aPixelsPtr, gint aStride, gint aWidth, gint aHeight)
+{
+    return cv::Mat(aHeight, aWidth, CV_8UC((int) aCvPtr->pixel->size), aPixelsPtr, (size_t) aStride);
+}
+
+
+static KmsDetectixImage * new_image(const cv::Mat & aBgra, gint aWidth, gint aHeight)
+{
+    KmsDetectixImage * image_ptr = g_new0(KmsDetectixImage, 1);
+
+    image_ptr->ref_count = 1;
+    image_ptr->width     = aWidth;
+    image_ptr->height    = aHeight;
+    image_ptr->stride    = aWidth * 4;
+    image_ptr->data      = (guint8 *) g_malloc((gsize) image_ptr->stride * aHeight);
+
+    // resize straight into the icon storage, the header already has the target size
+    cv::Mat sized(aHeight, aWidth, CV_8UC4, image_ptr->data, (size_t) image_ptr->stride);
+
+    cv::resize(aBgra, sized, sized.size(), 0, 0, cv::INTER_AREA);
+
+    return image_ptr;
+}
+
+
+KmsDetectixImage * kms_detectix_image_decode(const guint8 * aBytesPtr, gsize aLength, gint aWidth, gint aHeight)
+{
+    if ((aBytesPtr == NULL) || (aLength == 0) || (aWidth < 0) || (aHeight < 0))
+    {
+        return NULL;
+    }
+
+    cv::Mat encoded(1, (int) aLength, CV_8UC1, (void *) aBytesPtr);
+    cv::Mat decoded = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+    cv::Mat bgra;
+
+    if (decoded.empty())
+    {
+        return NULL;
+    }
+
+    if (decoded.depth() != CV_8U)
+    {
+        decoded.convertTo(decoded, CV_8U, 1.0 / 256.0);
+    }
+
+    switch (decoded.channels())
+    {
+        case 1:
+            cv::cvtColor(decoded, bgra, cv::COLOR_GRAY2BGRA);
+            break;
+
+        case 3:
+            cv::cvtColor(decoded, bgra, cv::COLOR_BGR2BGRA);
+            break;
+
+        case 4:
+            bgra = decoded;
+            break;
+
+        default:
+            return NULL;
+    }
+
+    return new_image(bgra, (aWidth > 0) ? aWidth : bgra.cols, (aHeight > 0) ? aHeight : bgra.rows);
+}
+
+
+KmsDetectixImage * kms_detectix_image_scale(KmsDetectixImage * aImagePtr, gint aWidth, gint aHeight)
+{
+    if ((aImagePtr == NULL) || (aWidth <= 0) || (aHeight <= 0))
+    {
+        return NULL;
+    }
+
+    if ((aWidth == aImagePtr->width) && (aHeight == aImagePtr->height))
+    {
+        return kms_detectix_image_ref(aImagePtr);
+    }
+
+    cv::Mat bgra(aImagePtr->height, aImagePtr->width, CV_8UC4, aImagePtr->data, (size_t) aImagePtr->stride);
+
+    return new_image(bgra, aWidth, aHeight);
+}
+
+
+KmsDetectixImage * kms_detectix_image_ref(KmsDetectixImage * aImagePtr)
+{
+    if (aImagePtr != NULL)
+    {
+        g_atomic_int_inc(&aImagePtr->ref_count);
+    }
+
+    return aImagePtr;
+}
+
+
+void kms_detectix_image_unref(KmsDetectixImage * aImagePtr)
+{
+    if ((aImagePtr != NULL) && g_atomic_int_dec_and_test(&aImagePtr->ref_count))
+    {
+        g_free(aImagePtr->data);
+        g_free(aImagePtr);
+    }
+
+    return;
+}
+
+
+// the variants of the frame kernels for one layout, out of the set picked at plugin load
+static void select_layout(KmsDetectixCv * aCvPtr, KmsDetectixLayout aLayout)
+{
+    const KmsDetectixKernels * kernels_ptr = kms_detectix_kernels();
+
+    aCvPtr->pixel     = kms_detectix_layout_pixel(aLayout);
+    aCvPtr->blend_row = kernels_ptr->blend_row[aLayout];
+
+    return;
+}
+
+
+KmsDetectixCv * kms_detectix_cv_new(void)
+{
+    KmsDetectixCv * cv_ptr = new _KmsDetectixCv();
+
+    select_layout(cv_ptr, KMS_DETECTIX_LAYOUT_BGR);
+
+    return cv_ptr;
+}
+
+
+void kms_detectix_cv_free(KmsDetectixCv * aCvPtr)
+{
+    delete aCvPtr;
+}
+
+
+gboolean kms_detectix_cv_set_layout(KmsDetectixCv * aCvPtr, KmsDetectixLayout aLayout)
+{
+    if (aLayout >= KMS_DETECTIX_LAYOUTS)
+    {
+        return FALSE;
+    }
+
+    select_layout(aCvPtr, aLayout);
+
+    return TRUE;
+}
+
+
+void kms_detectix_cv_calibrate(const KmsDetectixCv     * aCvPtr,
+                               guint8                  * aPixelsPtr,
+                               gint                      aStride,
+                               gint                      aWidth,
+                               gint                      aHeight,
+                               const GstVideoRectangle * aAreaPtr,
+                               KmsDetectixColorRange   * aRangePtr)
+{
+    cv::Rect area = cv::Rect(aAreaPtr->x, aAreaPtr->y, aAreaPtr->w, aAreaPtr->h) & cv::Rect(0, 0, aWidth, aHeight);
+
+    if (area.area() == 0)
+    {
+        return;
+    }
+
+    cv::Mat    frame      = wrap_pixels(aCvPtr, aPixelsPtr, aStride, aWidth, aHeight);
+    guint      offsets[3] = { aCvPtr->pixel->blue, aCvPtr->pixel->green, aCvPtr->pixel->red };
+    cv::Scalar mean;
+    cv::Scalar deviation;
+
+    cv::meanStdDev(frame(area), mean, deviation);
+
+    // the range is kept as B, G, R whatever the layout
+    for (gint channel = 0; channel < 3; channel++)
+    {
+        guint   offset = offsets[channel];
+        gdouble spread = MAX(deviation[offset] * CALIBRATION_DEVIATIONS, CALIBRATION_TOLERANCE);
+
+        aRangePtr->low[channel]  = cv::saturate_cast<guint8>(mean[offset] - spread);
+        aRangePtr->high[channel] = cv::saturate_cast<guint8>(mean[offset] + spread);
+    }
+
+    return;
+}
+
+
+void kms_detectix_cv_draw_image(const KmsDetectixCv    * aCvPtr,
+                                guint8                 * aPixelsPtr,
+                                gint                     aStride,
+                                gint                     aWidth,
+                                gint                     aHeight,
+                                const KmsDetectixImage * aImagePtr,
+                                gint                     aLeft,
+                                gint                     aTop,
+                                gdouble                  aTransparency)
+{
+    cv::Rect visible = cv::Rect(aLeft, aTop, aImagePtr->width, aImagePtr->height) & cv::Rect(0, 0, aWidth, aHeight);
+    guint    opacity = (guint) ((1.0 - CLAMP(aTransparency, 0.0, 1.0)) * 255.0 + 0.5);
+
+    if (visible.area() == 0)
+    {
+        return;
+    }
+
+    cv::Mat frame = wrap_pixels(aCvPtr, aPixelsPtr, aStride, aWidth, aHeight);
+    cv::Mat icon(aImagePtr->height, aImagePtr->width, CV_8UC4, aImagePtr->data, (size_t) aImagePtr->stride);
+
+    for (gint row = 0; row < visible.height; row++)
+    {
+        guint8       * dst_ptr = frame.ptr<guint8>(visible.y + row) + visible.x * aCvPtr->pixel->size;
+        const guint8 * src_ptr = icon.ptr<guint8>(visible.y - aTop + row) + (visible.x - aLeft) * 4;
+
+        aCvPtr->blend_row(dst_ptr, src_ptr, visible.width, opacity);
+    }
+
+    return;
+}
+
+
+void kms_detectix_cv_draw_rectangle(const KmsDetectixCv     * aCvPtr,
+                                    guint8                  * aPixelsPtr,
+                                    gint                      aStride,
+                                    gint                      aWidth,
+                                    gint                      aHeight,
+                                    const GstVideoRectangle * aRectPtr,
+                                    guint32                   aColorRGB)
+{
+    cv::Mat    frame = wrap_pixels(aCvPtr, aPixelsPtr, aStride, aWidth, aHeight);
+    cv::Scalar color = cv::Scalar::all(255);    // the pad byte of 4 byte layouts ends up opaque
+
+    color[aCvPtr->pixel->blue]  = aColorRGB & 0xFF;
+    color[aCvPtr->pixel->green] = (aColorRGB >> 8) & 0xFF;
+    color[aCvPtr->pixel->red]   = (aColorRGB >> 16) & 0xFF;
+
+    cv::rectangle(frame, cv::Rect(aRectPtr->x, aRectPtr->y, aRectPtr->w, aRectPtr->h), color, 2);
+
+    return;
+}
+
+// ends file:  "kmsdetectixcv.cpp"
@@ -0,0 +1,94 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_CV_H_
+#define _KMS_DETECTIX_CV_H_
+
+#include <gst/video/video.h>
+
+#include "kmsdetectixanalysis.h"
+
+G_BEGIN_DECLS
+
+/*
+ * C interface of the OpenCV code used by pointerdetectix.
+ *
+ * Frames are never copied: every call wraps the mapped plane of the
+ * GstVideoFrame (pixels plus stride) in a cv::Mat header. The pointer
+ * search itself lives in kmsdetectixanalysis, without OpenCV; set_layout
+ * picks the pixel kernels of the frame layout once per caps.
+ */
+
+typedef struct _KmsDetectixImage
+{
+    gint        ref_count;
+    gint        width;
+    gint        height;
+    gint        stride;
+    guint8    * data;       // BGRA, alpha is not premultiplied
+
+} KmsDetectixImage;
+
+
+typedef struct _KmsDetectixCv KmsDetectixCv;
+
+
+// a size of 0 keeps the size of the encoded image
+KmsDetectixImage * kms_detectix_image_decode(const guint8 * aBytesPtr, gsize aLength, gint aWidth, gint aHeight);
+
+// a resized copy, or a new reference when the size already matches --- never decodes again
+KmsDetectixImage * kms_detectix_image_scale(KmsDetectixImage * aImagePtr, gint aWidth, gint aHeight);
+
+KmsDetectixImage * kms_detectix_image_ref(KmsDetectixImage * aImagePtr);
+
+void kms_detectix_image_unref(KmsDetectixImage * aImagePtr);
+
+
+KmsDetectixCv * kms_detectix_cv_new(void);
+
+void kms_detectix_cv_free(KmsDetectixCv * aCvPtr);
+
+gboolean kms_detectix_cv_set_layout(KmsDetectixCv * aCvPtr, KmsDetectixLayout aLayout);
+
+void kms_detectix_cv_calibrate(const KmsDetectixCv     * aCvPtr,
+                               guint8                  * aPixelsPtr,
+                               gint                      aStride,
+                               gint                      aWidth,
+                               gint                      aHeight,
+                               const GstVideoRectangle * aAreaPtr,
+                               KmsDetectixColorRange   * aRangePtr);
+
+void kms_detectix_cv_draw_image(const KmsDetectixCv    * aCvPtr,
+                                guint8                 * aPixelsPtr,
+                                gint                     aStride,
+                                gint                     aWidth,
+                                gint                     aHeight,
+                                const KmsDetectixImage * aImagePtr,
+                                gint                     aLeft,
+                                gint                     aTop,
+                                gdouble                  aTransparency);
+
+void kms_detectix_cv_draw_rectangle(const KmsDetectixCv     * aCvPtr,
+                                    guint8                  * aPixelsPtr,
+                                    gint                      aStride,
+                                    gint                      aWidth,
+                                    gint                      aHeight,
+                                    const GstVideoRectangle * aRectPtr,
+                                    guint32                   aColorRGB);
+
+G_END_DECLS
+
+#endif
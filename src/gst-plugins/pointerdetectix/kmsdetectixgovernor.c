@@ -0,0 +1,332 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixgovernor.h"
+
+
+#define GOVERNOR_PERIOD_MS      500     // how often the slots are rebalanced
+#define GOVERNOR_SAVING_RATIO   0.4     // expected cost saved by one more level
+#define GOVERNOR_RESTORE_RATIO  0.75    // load below budget*ratio restores one level
+
+
+struct _KmsDetectixGovernorSlot
+{
+    gpointer    owner;
+    gint        priority;       // higher value is degraded later --- atomic
+    gint        level;          // index into The_Governor_Levels --- atomic
+    guint       min_rate;       // frames per second never to go below --- atomic
+    gint        cost_micros;    // analysis cost during the current period --- atomic
+    guint64     last_cost_ns;   // analysis cost during the previous period
+};
+
+
+static const struct
+{
+    guint   interval_ms;
+    guint   scale_shift;
+
+} The_Governor_Levels[KMS_DETECTIX_GOVERNOR_MAX_LEVEL + 1] =
+{
+    {   0, 0 },     // every frame, full resolution
+    {   0, 1 },     // every frame, half resolution
+    {  66, 1 },     // ~15 fps, half resolution
+    { 125, 1 },     // ~8 fps, half resolution
+    { 125, 2 },     // ~8 fps, quarter resolution
+    { 250, 2 },     // ~4 fps, quarter resolution
+    { 500, 3 }      // ~2 fps, eighth resolution
+};
+
+
+static GMutex    The_Governor_Mutex;
+static GList   * The_Governor_Slots         = NULL;
+static guint64   The_Governor_Period_Start  = 0;    // protected by The_Governor_Mutex
+static gint      The_Governor_Next_Ms       = 0;    // atomic --- monotonic milliseconds as guint32, wrapping
+static gint      The_Governor_Budget        = 0;    // atomic
+static gint      The_Governor_Load_Permille = 0;    // atomic
+
+
+KmsDetectixGovernorSlot * kms_detectix_governor_register(gpointer aOwnerPtr)
+{
+    KmsDetectixGovernorSlot * slot_ptr = g_new0(KmsDetectixGovernorSlot, 1);
+
+    slot_ptr->owner    = aOwnerPtr;
+    slot_ptr->min_rate = 2;
+
+    g_mutex_lock(&The_Governor_Mutex);
+
+    The_Governor_Slots = g_list_prepend(The_Governor_Slots, slot_ptr);
+
+    g_mutex_unlock(&The_Governor_Mutex);
+
+    return slot_ptr;
+}
+
+
+void kms_detectix_governor_unregister(KmsDetectixGovernorSlot * aSlotPtr)
+{
+    if (aSlotPtr == NULL)
+    {
+        return;
+    }
+
+    g_mutex_lock(&The_Governor_Mutex);
+
+    The_Governor_Slots = g_list_remove(The_Governor_Slots, aSlotPtr);
+
+    g_mutex_unlock(&The_Governor_Mutex);
+
+    g_free(aSlotPtr);
+
+    return;
+}
+
+
+void kms_detectix_governor_set_priority(KmsDetectixGovernorSlot * aSlotPtr, gint aPriority)
+{
+    g_atomic_int_set(&aSlotPtr->priority, aPriority);
+}
+
+
+gint kms_detectix_governor_get_priority(KmsDetectixGovernorSlot * aSlotPtr)
+{
+    return g_atomic_int_get(&aSlotPtr->priority);
+}
+
+
+void kms_detectix_governor_set_min_rate(KmsDetectixGovernorSlot * aSlotPtr, guint aFramesPerSec)
+{
+    g_atomic_int_set((gint *) &aSlotPtr->min_rate, (gint) aFramesPerSec);
+}
+
+
+guint kms_detectix_governor_get_min_rate(KmsDetectixGovernorSlot * aSlotPtr)
+{
+    return (guint) g_atomic_int_get((gint *) &aSlotPtr->min_rate);
+}
+
+
+void kms_detectix_governor_get_plan(KmsDetectixGovernorSlot * aSlotPtr, KmsDetectixGovernorPlan * aPlanPtr)
+{
+    guint level    = (guint) g_atomic_int_get(&aSlotPtr->level);
+    guint min_rate = kms_detectix_governor_get_min_rate(aSlotPtr);
+    guint interval = The_Governor_Levels[level].interval_ms;
+
+    if ((min_rate > 0) && (interval > 1000 / min_rate))
+    {
+        interval = 1000 / min_rate;
+    }
+
+    aPlanPtr->level       = level;
+    aPlanPtr->interval_ns = (guint64) interval * 1000 * 1000;
+    aPlanPtr->scale_shift = The_Governor_Levels[level].scale_shift;
+
+    return;
+}
+
+
+void kms_detectix_governor_set_budget(guint aPercent)
+{
+    g_atomic_int_set(&The_Governor_Budget, (gint) MIN(aPercent, 100));
+}
+
+
+guint kms_detectix_governor_get_budget(void)
+{
+    return (guint) g_atomic_int_get(&The_Governor_Budget);
+}
+
+
+gdouble kms_detectix_governor_get_load(void)
+{
+    return g_atomic_int_get(&The_Governor_Load_Permille) / 10.0;
+}
+
+
+// share of all host cores used by one slot during the last period, in percent
+static gdouble slot_load(KmsDetectixGovernorSlot * aSlotPtr, gdouble aCapacityNanos)
+{
+    return (aSlotPtr->last_cost_ns * 100.0) / aCapacityNanos;
+}
+
+
+// lowest priority first, then the most expensive one --- idle slots are useless to degrade
+static KmsDetectixGovernorSlot * pick_slot_to_degrade()
+{
+    KmsDetectixGovernorSlot * found_ptr = NULL;
+    GList                   * item_ptr;
+
+    for (item_ptr = The_Governor_Slots; item_ptr != NULL; item_ptr = item_ptr->next)
+    {
+        KmsDetectixGovernorSlot * slot_ptr = item_ptr->data;
+
+        if ((slot_ptr->last_cost_ns == 0) || (slot_ptr->level >= KMS_DETECTIX_GOVERNOR_MAX_LEVEL))
+        {
+            continue;
+        }
+
+        if ((found_ptr == NULL) ||
+            (slot_ptr->priority < found_ptr->priority) ||
+            ((slot_ptr->priority == found_ptr->priority) && (slot_ptr->last_cost_ns > found_ptr->last_cost_ns)))
+        {
+            found_ptr = slot_ptr;
+        }
+    }
+
+    return found_ptr;
+}
+
+
+// highest priority first, then the cheapest one
+static KmsDetectixGovernorSlot * pick_slot_to_restore()
+{
+    KmsDetectixGovernorSlot * found_ptr = NULL;
+    GList                   * item_ptr;
+
+    for (item_ptr = The_Governor_Slots; item_ptr != NULL; item_ptr = item_ptr->next)
+    {
+        KmsDetectixGovernorSlot * slot_ptr = item_ptr->data;
+
+        if (slot_ptr->level == 0)
+        {
+            continue;
+        }
+
+        if ((found_ptr == NULL) ||
+            (slot_ptr->priority > found_ptr->priority) ||
+            ((slot_ptr->priority == found_ptr->priority) && (slot_ptr->last_cost_ns < found_ptr->last_cost_ns)))
+        {
+            found_ptr = slot_ptr;
+        }
+    }
+
+    return found_ptr;
+}
+
+
+// must be called with The_Governor_Mutex held
+static void rebalance_slots(guint64 aNowNanos)
+{
+    guint64  period_ns = aNowNanos - The_Governor_Period_Start;
+    gdouble  capacity  = (gdouble) period_ns * g_get_num_processors();
+    guint    budget    = kms_detectix_governor_get_budget();
+    guint64  total_ns  = 0;
+    gdouble  load;
+    GList  * item_ptr;
+
+    The_Governor_Period_Start = aNowNanos;
+
+    if (period_ns == 0)
+    {
+        return;
+    }
+
+    for (item_ptr = The_Governor_Slots; item_ptr != NULL; item_ptr = item_ptr->next)
+    {
+        KmsDetectixGovernorSlot * slot_ptr = item_ptr->data;
+
+        slot_ptr->last_cost_ns = (guint64) g_atomic_int_and((guint *) &slot_ptr->cost_micros, 0) * 1000;
+
+        total_ns += slot_ptr->last_cost_ns;
+    }
+
+    load = (total_ns * 100.0) / capacity;
+
+    g_atomic_int_set(&The_Governor_Load_Permille, (gint) (load * 10.0));
+
+    if (budget == 0)
+    {
+        for (item_ptr = The_Governor_Slots; item_ptr != NULL; item_ptr = item_ptr->next)
+        {
+            g_atomic_int_set(&((KmsDetectixGovernorSlot *) item_ptr->data)->level, 0);
+        }
+    }
+    else if (load > budget)
+    {
+        gdouble expected = load;
+
+        while (expected > budget)
+        {
+            KmsDetectixGovernorSlot * slot_ptr = pick_slot_to_degrade();
+
+            if (slot_ptr == NULL)
+            {
+                break;
+            }
+
+            expected -= slot_load(slot_ptr, capacity) * GOVERNOR_SAVING_RATIO;
+
+            slot_ptr->last_cost_ns = (guint64) (slot_ptr->last_cost_ns * (1.0 - GOVERNOR_SAVING_RATIO));
+
+            g_atomic_int_inc(&slot_ptr->level);
+        }
+    }
+    else if (load < budget * GOVERNOR_RESTORE_RATIO)
+    {
+        KmsDetectixGovernorSlot * slot_ptr = pick_slot_to_restore();
+
+        if (slot_ptr != NULL)
+        {
+            g_atomic_int_add(&slot_ptr->level, -1);
+        }
+    }
+
+    return;
+}
+
+
+/*
+ * the milliseconds wrap every 49.7 days of uptime, so only the distance to the deadline is
+ * compared, unsigned --- at most a period ahead until it passes, anything else is overdue or
+ * was never set
+ */
+static gboolean is_rebalance_due(guint32 aNowMs)
+{
+    guint32 next_ms = (guint32) g_atomic_int_get(&The_Governor_Next_Ms);
+
+    return (guint32) (next_ms - aNowMs) > GOVERNOR_PERIOD_MS;
+}
+
+
+void kms_detectix_governor_account(KmsDetectixGovernorSlot * aSlotPtr, guint64 aCostNanos)
+{
+    guint64 now_ns = (guint64) g_get_monotonic_time() * 1000;
+    guint32 now_ms = (guint32) (now_ns / (1000 * 1000));
+
+    g_atomic_int_add(&aSlotPtr->cost_micros, (gint) (aCostNanos / 1000));
+
+    if (! is_rebalance_due(now_ms))
+    {
+        return;
+    }
+
+    // whichever streaming thread gets here first does the rebalancing for all slots
+    if (g_mutex_trylock(&The_Governor_Mutex))
+    {
+        if (is_rebalance_due(now_ms))
+        {
+            rebalance_slots(now_ns);
+
+            g_atomic_int_set(&The_Governor_Next_Ms, (gint) (now_ms + GOVERNOR_PERIOD_MS));
+        }
+
+        g_mutex_unlock(&The_Governor_Mutex);
+    }
+
+    return;
+}
+
+// ends file:  "kmsdetectixgovernor.c"
@@ -0,0 +1,73 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_GOVERNOR_H_
+#define _KMS_DETECTIX_GOVERNOR_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Process-global governor shared by every pointerdetectix instance.
+ *
+ * Each instance owns one slot. The streaming thread reports how long each
+ * analysis took, and asks the slot how often and at which resolution it may
+ * analyze. When the sum of all slots exceeds the CPU budget, the lowest
+ * priority sessions are degraded first; when load clears they are restored
+ * highest priority first. A slot never drops below its minimum analysis rate.
+ */
+
+#define KMS_DETECTIX_GOVERNOR_MAX_LEVEL    6
+
+typedef struct _KmsDetectixGovernorSlot KmsDetectixGovernorSlot;
+
+typedef struct _KmsDetectixGovernorPlan
+{
+    guint       level;          // 0 is full quality
+    guint64     interval_ns;    // minimum time between two analyzed frames
+    guint       scale_shift;    // analysis runs on (width >> shift, height >> shift)
+
+} KmsDetectixGovernorPlan;
+
+
+KmsDetectixGovernorSlot * kms_detectix_governor_register(gpointer aOwnerPtr);
+
+void kms_detectix_governor_unregister(KmsDetectixGovernorSlot * aSlotPtr);
+
+void kms_detectix_governor_set_priority(KmsDetectixGovernorSlot * aSlotPtr, gint aPriority);
+
+gint kms_detectix_governor_get_priority(KmsDetectixGovernorSlot * aSlotPtr);
+
+void kms_detectix_governor_set_min_rate(KmsDetectixGovernorSlot * aSlotPtr, guint aFramesPerSec);
+
+guint kms_detectix_governor_get_min_rate(KmsDetectixGovernorSlot * aSlotPtr);
+
+void kms_detectix_governor_get_plan(KmsDetectixGovernorSlot * aSlotPtr, KmsDetectixGovernorPlan * aPlanPtr);
+
+void kms_detectix_governor_account(KmsDetectixGovernorSlot * aSlotPtr, guint64 aCostNanos);
+
+/* process-wide budget in percent of all host cores --- 0 disables the governor */
+void kms_detectix_governor_set_budget(guint aPercent);
+
+guint kms_detectix_governor_get_budget(void);
+
+/* percent of all host cores used by analysis during the last period */
+gdouble kms_detectix_governor_get_load(void);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,303 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixkernelsimpl.h"
+
+#include <string.h>
+
+#if defined(DETECTIX_KERNELS_NEON) && defined(__arm__)
+    #include <sys/auxv.h>
+    #include <asm/hwcap.h>
+#endif
+
+
+static const KmsDetectixKernels * The_Kernels = &Kms_Detectix_Kernels_Scalar;
+
+
+// one word of a row with the pixels left and right of each folded in, aOutside stands for those past both ends
+static inline guint64 morph_across(const guint64 * aRowPtr, gint aWord, gint aWords, guint64 aLastValid, guint64 aOutside,
+                                   gboolean aIsErode)
+{
+    guint64 word = aRowPtr[aWord];
+    guint64 prev = (aWord > 0)          ? aRowPtr[aWord - 1] : aOutside;
+    guint64 next = (aWord + 1 < aWords) ? aRowPtr[aWord + 1] : aOutside;
+    guint64 left;
+    guint64 right;
+
+    if (aWord + 1 == aWords)
+    {
+        word = (word & aLastValid) | (aOutside & ~aLastValid);
+    }
+
+    left  = (word << 1) | (prev >> 63);
+    right = (word >> 1) | (next << 63);
+
+    return aIsErode ? (word & left & right) : (word | left | right);
+}
+
+
+// separable: across the words of each row with shifts, then down the three rows with one and / or per word
+static void morph_words(const guint64 * aSrcPtr, gint aSrcStride, guint64 * aDstPtr, gint aDstStride,
+                        gint aWidth, gint aHeight, gboolean aIsErode)
+{
+    gint    words      = KMS_DETECTIX_MASK_WORDS(aWidth);
+    guint64 last_valid = G_MAXUINT64 >> ((64 - aWidth % 64) % 64);
+    guint64 outside    = aIsErode ? G_MAXUINT64 : 0;
+    gint    row, word;
+
+    for (row = 0; row < aHeight; row++)
+    {
+        const guint64 * row_ptr = aSrcPtr + row * aSrcStride;
+        guint64       * dst_ptr = aDstPtr + row * aDstStride;
+
+        for (word = 0; word < words; word++)
+        {
+            guint64 value = morph_across(row_ptr, word, words, last_valid, outside, aIsErode);
+
+            if (row > 0)
+            {
+                guint64 above = morph_across(row_ptr - aSrcStride, word, words, last_valid, outside, aIsErode);
+
+                value = aIsErode ? (value & above) : (value | above);
+            }
+
+            if (row < aHeight - 1)
+            {
+                guint64 below = morph_across(row_ptr + aSrcStride, word, words, last_valid, outside, aIsErode);
+
+                value = aIsErode ? (value & below) : (value | below);
+            }
+
+            dst_ptr[word] = (word + 1 == words) ? (value & last_valid) : value;
+        }
+    }
+
+    return;
+}
+
+
+void kms_detectix_erode_words(const guint64 * aSrcPtr, gint aSrcStride, guint64 * aDstPtr, gint aDstStride, gint aWidth, gint aHeight)
+{
+    morph_words(aSrcPtr, aSrcStride, aDstPtr, aDstStride, aWidth, aHeight, TRUE);
+}
+
+
+void kms_detectix_dilate_words(const guint64 * aSrcPtr, gint aSrcStride, guint64 * aDstPtr, gint aDstStride, gint aWidth, gint aHeight)
+{
+    morph_words(aSrcPtr, aSrcStride, aDstPtr, aDstStride, aWidth, aHeight, FALSE);
+}
+
+
+void kms_detectix_downscale_reduce(const guint16 * aSumsPtr, guint8 * aDstPtr, gint aWidth, guint aShift, guint aSize)
+{
+    guint block = 1u << aShift;
+    guint half  = 1u << (2 * aShift - 1);
+    gint  col;
+    guint index, channel;
+
+    for (col = 0; col < aWidth; col++, aSumsPtr += block * aSize)
+    {
+        for (channel = 0; channel < aSize; channel++)
+        {
+            guint total = 0;
+
+            for (index = 0; index < block; index++)
+            {
+                total += aSumsPtr[index * aSize + channel];
+            }
+
+            aDstPtr[col * aSize + channel] = (guint8) ((total + half) >> (2 * aShift));
+        }
+    }
+
+    return;
+}
+
+
+const KmsDetectixPixel * kms_detectix_layout_pixel(KmsDetectixLayout aLayout)
+{
+    #define PIXEL_ENTRY(aSuffix, aSize, aBlue, aGreen, aRed)    { aSize, aBlue, aGreen, aRed },
+
+    static const KmsDetectixPixel The_Pixels[KMS_DETECTIX_LAYOUTS] = { KMS_DETECTIX_FOR_EACH_LAYOUT(PIXEL_ENTRY) };
+
+    #undef PIXEL_ENTRY
+
+    return &The_Pixels[aLayout];
+}
+
+
+KMS_DETECTIX_SPECIALIZE void scalar_classify(const guint8 * aSrcPtr, gint aSrcStride, guint64 * aMaskPtr, gint aMaskStride,
+                                             gint aWidth, gint aHeight, const guint8 * aLowPtr, const guint8 * aHighPtr,
+                                             guint aSize, guint aBlue, guint aGreen, guint aRed)
+{
+    gint row, col;
+
+    for (row = 0; row < aHeight; row++)
+    {
+        const guint8 * src_ptr  = aSrcPtr  + row * aSrcStride;
+        guint64      * mask_ptr = aMaskPtr + row * aMaskStride;
+
+        for (col = 0; col < aWidth; col += 64)
+        {
+            mask_ptr[col / 64] = kms_detectix_classify_bits(src_ptr + col * aSize, MIN(64, aWidth - col), aLowPtr, aHighPtr,
+                                                            aSize, aBlue, aGreen, aRed);
+        }
+    }
+
+    return;
+}
+
+
+KMS_DETECTIX_SPECIALIZE void scalar_downscale(const guint8 * aSrcPtr, gint aSrcStride, guint8 * aDstPtr, gint aDstStride,
+                                              gint aWidth, gint aHeight, guint aShift, guint16 * aSumsPtr, guint aSize)
+{
+    gint  length = (aWidth << aShift) * (gint) aSize;
+    gint  row, index;
+    guint block;
+
+    for (row = 0; row < aHeight; row++)
+    {
+        memset(aSumsPtr, 0, (gsize) length * sizeof(guint16));
+
+        for (block = 0; block < (1u << aShift); block++)
+        {
+            const guint8 * src_ptr = aSrcPtr + ((row << aShift) + (gint) block) * aSrcStride;
+
+            for (index = 0; index < length; index++)
+            {
+                aSumsPtr[index] += src_ptr[index];
+            }
+        }
+
+        kms_detectix_downscale_reduce(aSumsPtr, aDstPtr + row * aDstStride, aWidth, aShift, aSize);
+    }
+
+    return;
+}
+
+
+KMS_DETECTIX_SPECIALIZE void scalar_blend_row(guint8 * aDstPtr, const guint8 * aSrcPtr, gint aWidth, guint aOpacity,
+                                              guint aSize, guint aBlue, guint aGreen, guint aRed)
+{
+    gint col;
+
+    for (col = 0; col < aWidth; col++)
+    {
+        kms_detectix_blend_pixel(aDstPtr + col * aSize, aSrcPtr + col * 4, aOpacity, aBlue, aGreen, aRed);
+    }
+
+    return;
+}
+
+
+#define SCALAR_LAYOUT(aSuffix, aSize, aBlue, aGreen, aRed)                                                              \
+    static void scalar_classify_##aSuffix(const guint8 * aSrcPtr, gint aSrcStride, guint64 * aMaskPtr,                 \
+                                          gint aMaskStride, gint aWidth, gint aHeight,                                  \
+                                          const guint8 * aLowPtr, const guint8 * aHighPtr)                              \
+    {                                                                                                                   \
+        scalar_classify(aSrcPtr, aSrcStride, aMaskPtr, aMaskStride, aWidth, aHeight, aLowPtr, aHighPtr,                 \
+                        aSize, aBlue, aGreen, aRed);                                                                    \
+    }                                                                                                                   \
+    static void scalar_downscale_##aSuffix(const guint8 * aSrcPtr, gint aSrcStride, guint8 * aDstPtr, gint aDstStride,  \
+                                           gint aWidth, gint aHeight, guint aShift, guint16 * aSumsPtr)                 \
+    {                                                                                                                   \
+        scalar_downscale(aSrcPtr, aSrcStride, aDstPtr, aDstStride, aWidth, aHeight, aShift, aSumsPtr, aSize);           \
+    }                                                                                                                   \
+    static void scalar_blend_row_##aSuffix(guint8 * aDstPtr, const guint8 * aSrcPtr, gint aWidth, guint aOpacity)      \
+    {                                                                                                                   \
+        scalar_blend_row(aDstPtr, aSrcPtr, aWidth, aOpacity, aSize, aBlue, aGreen, aRed);                               \
+    }
+
+KMS_DETECTIX_FOR_EACH_LAYOUT(SCALAR_LAYOUT)
+
+#define CLASSIFY_ENTRY(aSuffix, ...)    scalar_classify_##aSuffix,
+#define DOWNSCALE_ENTRY(aSuffix, ...)   scalar_downscale_##aSuffix,
+#define BLEND_ENTRY(aSuffix, ...)       scalar_blend_row_##aSuffix,
+
+const KmsDetectixKernels Kms_Detectix_Kernels_Scalar =
+{
+    "scalar",
+    { KMS_DETECTIX_FOR_EACH_LAYOUT(CLASSIFY_ENTRY) },
+    { KMS_DETECTIX_FOR_EACH_LAYOUT(DOWNSCALE_ENTRY) },
+    { KMS_DETECTIX_FOR_EACH_LAYOUT(BLEND_ENTRY) },
+    kms_detectix_erode_words,
+    kms_detectix_dilate_words
+};
+
+
+// every set the CPU supports, best last
+static guint get_supported(const KmsDetectixKernels ** aKernelsPtr)
+{
+    guint count = 0;
+
+    aKernelsPtr[count++] = &Kms_Detectix_Kernels_Scalar;
+
+#ifdef DETECTIX_KERNELS_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("sse2"))
+    {
+        aKernelsPtr[count++] = &Kms_Detectix_Kernels_Sse2;
+    }
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+        aKernelsPtr[count++] = &Kms_Detectix_Kernels_Avx2;
+    }
+#endif
+
+#ifdef DETECTIX_KERNELS_NEON
+    #ifdef __arm__
+        if (getauxval(AT_HWCAP) & HWCAP_NEON)
+    #endif
+        {
+            aKernelsPtr[count++] = &Kms_Detectix_Kernels_Neon;
+        }
+#endif
+
+    return count;
+}
+
+
+void kms_detectix_kernels_init(void)
+{
+    const KmsDetectixKernels * supported[4];
+    guint                      count = get_supported(supported);
+
+    The_Kernels = supported[count - 1];
+
+    g_print("pointerdetectix --- pixel kernels: %s \n", supported[count - 1]->name);
+
+    return;
+}
+
+
+const KmsDetectixKernels * kms_detectix_kernels(void)
+{
+    return The_Kernels;
+}
+
+
+const KmsDetectixKernels * kms_detectix_kernels_nth(guint aIndex)
+{
+    const KmsDetectixKernels * supported[4];
+    guint                      count = get_supported(supported);
+
+    return (aIndex < count) ? supported[aIndex] : NULL;
+}
+
+// ends file:  "kmsdetectixkernels.c"
@@ -0,0 +1,106 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_KERNELS_H_
+#define _KMS_DETECTIX_KERNELS_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Pixel kernels of the pointer analysis.
+ *
+ * Every instruction set provides the same table and must give results bit
+ * identical to the scalar reference, test_detectixkernels checks it. The
+ * best set supported by the host is chosen once when the plugin is loaded,
+ * so a single build runs on every CPU generation of the fleet.
+ *
+ * Frames come in any of the packed layouts below, the frame kernels have a
+ * variant per layout with the pixel size and channel offsets fixed at
+ * compile time. Icons are BGRA.
+ *
+ * Masks hold one bit per pixel, the first pixel of a row in the lowest bit
+ * of its first 64 bit word, and their strides count words. Bits past the
+ * width of a row are always 0, so the morphology works a word at a time.
+ */
+
+// 64 bit words of a mask row aWidth pixels wide
+#define KMS_DETECTIX_MASK_WORDS(aWidth)     (((aWidth) + 63) / 64)
+
+typedef enum _KmsDetectixLayout
+{
+    KMS_DETECTIX_LAYOUT_BGR,
+    KMS_DETECTIX_LAYOUT_BGRx,
+    KMS_DETECTIX_LAYOUT_RGBx,
+    KMS_DETECTIX_LAYOUT_RGBA,
+    KMS_DETECTIX_LAYOUT_xRGB,
+
+    KMS_DETECTIX_LAYOUTS
+
+} KmsDetectixLayout;
+
+
+typedef struct _KmsDetectixPixel
+{
+    guint       size;       // bytes per pixel
+    guint       blue;       // offsets of the channels, the fourth byte of a 4 byte layout is never written
+    guint       green;
+    guint       red;
+
+} KmsDetectixPixel;
+
+
+typedef struct _KmsDetectixKernels
+{
+    const gchar * name;
+
+    // mask bit set where the three channels are inside [aLowPtr, aHighPtr], both given as B, G, R
+    void (*classify[KMS_DETECTIX_LAYOUTS]) (const guint8 * aSrcPtr, gint aSrcStride, guint64 * aMaskPtr, gint aMaskStride,
+                                            gint aWidth, gint aHeight, const guint8 * aLowPtr, const guint8 * aHighPtr);
+
+    /*
+     * rounded mean of every block of 1 << aShift pixels by side, aShift from 1 to 3, into the
+     * same layout --- aWidth and aHeight are those of the destination, aSumsPtr holds aWidth << aShift pixels
+     */
+    void (*downscale[KMS_DETECTIX_LAYOUTS]) (const guint8 * aSrcPtr, gint aSrcStride, guint8 * aDstPtr, gint aDstStride,
+                                             gint aWidth, gint aHeight, guint aShift, guint16 * aSumsPtr);
+
+    // one row of BGRA icon over frame pixels, aOpacity from 0 to 255 scales the icon alpha
+    void (*blend_row[KMS_DETECTIX_LAYOUTS]) (guint8 * aDstPtr, const guint8 * aSrcPtr, gint aWidth, guint aOpacity);
+
+    // 3x3 minimum and maximum of masks, the border of the image is left out of the neighbourhood
+    void (*erode)  (const guint64 * aSrcPtr, gint aSrcStride, guint64 * aDstPtr, gint aDstStride, gint aWidth, gint aHeight);
+    void (*dilate) (const guint64 * aSrcPtr, gint aSrcStride, guint64 * aDstPtr, gint aDstStride, gint aWidth, gint aHeight);
+
+} KmsDetectixKernels;
+
+
+// size and channel offsets of a layout
+const KmsDetectixPixel * kms_detectix_layout_pixel(KmsDetectixLayout aLayout);
+
+// picks the best set for this CPU, called once from plugin_init
+void kms_detectix_kernels_init(void);
+
+// the set picked by kms_detectix_kernels_init, scalar until then
+const KmsDetectixKernels * kms_detectix_kernels(void);
+
+// every set this CPU can run, the scalar reference first --- NULL past the last one
+const KmsDetectixKernels * kms_detectix_kernels_nth(guint aIndex);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,302 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// built with -mavx2, only reached through the table when the CPU has it
+
+#include "kmsdetectixkernelsimpl.h"
+
+#include <string.h>
+#include <immintrin.h>
+
+
+// x / 255 rounded to nearest for x + 127 up to 65534, as (x + 127) / 255 in the reference
+static inline __m256i div255_round(__m256i aValue)
+{
+    __m256i biased = _mm256_add_epi16(aValue, _mm256_set1_epi16(127));
+
+    return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(biased, _mm256_set1_epi16(1)), _mm256_srli_epi16(biased, 8)), 8);
+}
+
+
+// byte in [low, high] as 0xFF
+static inline __m256i in_range(__m256i aValue, __m256i aLow, __m256i aHigh)
+{
+    return _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(aValue, aLow), aValue),
+                            _mm256_cmpeq_epi8(_mm256_min_epu8(aValue, aHigh), aValue));
+}
+
+
+// icon lanes B, G, R, A of each pixel moved to the channel offsets of the layout, RGB layouts have blue at 2, xRGB at 3
+static inline __m256i to_layout(__m256i aIcon, guint aBlue)
+{
+    if (aBlue == 2)
+    {
+        return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(aIcon, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+    }
+
+    if (aBlue == 3)
+    {
+        return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(aIcon, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+    }
+
+    return aIcon;
+}
+
+
+KMS_DETECTIX_SPECIALIZE void avx2_classify(const guint8 * aSrcPtr, gint aSrcStride, guint64 * aMaskPtr, gint aMaskStride,
+                                           gint aWidth, gint aHeight, const guint8 * aLowPtr, const guint8 * aHighPtr,
+                                           guint aSize, guint aBlue, guint aGreen, guint aRed)
+{
+    __m256i ones  = _mm256_set1_epi8(-1);
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    guint8  low_pixel[4];
+    guint8  high_pixel[4];
+    guint8  low_bytes[96];
+    guint8  high_bytes[96];
+    __m256i low[3];
+    __m256i high[3];
+    gint    row, col, index;
+
+    kms_detectix_layout_bounds(low_pixel, high_pixel, aLowPtr, aHighPtr, aBlue, aGreen, aRed);
+
+    for (index = 0; index < 96; index++)
+    {
+        low_bytes[index]  = low_pixel[index % aSize];
+        high_bytes[index] = high_pixel[index % aSize];
+    }
+
+    for (index = 0; index < 3; index++)
+    {
+        low[index]  = _mm256_loadu_si256((const __m256i *) (low_bytes  + index * 32));
+        high[index] = _mm256_loadu_si256((const __m256i *) (high_bytes + index * 32));
+    }
+
+    for (row = 0; row < aHeight; row++)
+    {
+        const guint8 * src_ptr  = aSrcPtr  + row * aSrcStride;
+        guint64      * mask_ptr = aMaskPtr + row * aMaskStride;
+
+        // whole words of 64 pixels, in blocks of 32
+        for (col = 0; col + 64 <= aWidth; col += 64)
+        {
+            guint64 word = 0;
+            gint    block;
+
+            for (block = 0; block < 64; block += 32)
+            {
+                const guint8 * block_ptr = src_ptr + (col + block) * aSize;
+                guint64        bits;
+
+                if (aSize == 3)
+                {
+                    // two halves of 48 channel bits
+                    guint64 channels[3];
+
+                    for (index = 0; index < 3; index++)
+                    {
+                        __m256i value = _mm256_loadu_si256((const __m256i *) (block_ptr + index * 32));
+
+                        channels[index] = (guint32) _mm256_movemask_epi8(in_range(value, low[index], high[index]));
+                    }
+
+                    bits = kms_detectix_pack_triples(channels[0] | ((channels[1] & 0xFFFF) << 32)) |
+                           ((guint64) kms_detectix_pack_triples((channels[1] >> 16) | (channels[2] << 16)) << 16);
+                }
+                else
+                {
+                    // a pixel is in when its four bytes are, the packs work per 128 bit lane and the permute restores the order
+                    __m256i words[4];
+
+                    for (index = 0; index < 4; index++)
+                    {
+                        __m256i value = _mm256_loadu_si256((const __m256i *) (block_ptr + index * 32));
+
+                        words[index] = _mm256_cmpeq_epi32(in_range(value, low[0], high[0]), ones);
+                    }
+
+                    bits = (guint32) _mm256_movemask_epi8(_mm256_permutevar8x32_epi32(
+                                         _mm256_packs_epi16(_mm256_packs_epi32(words[0], words[1]),
+                                                            _mm256_packs_epi32(words[2], words[3])), order));
+                }
+
+                word |= bits << block;
+            }
+
+            mask_ptr[col / 64] = word;
+        }
+
+        if (col < aWidth)
+        {
+            mask_ptr[col / 64] = kms_detectix_classify_bits(src_ptr + col * aSize, aWidth - col, aLowPtr, aHighPtr,
+                                                            aSize, aBlue, aGreen, aRed);
+        }
+    }
+
+    return;
+}
+
+
+KMS_DETECTIX_SPECIALIZE void avx2_downscale(const guint8 * aSrcPtr, gint aSrcStride, guint8 * aDstPtr, gint aDstStride,
+                                            gint aWidth, gint aHeight, guint aShift, guint16 * aSumsPtr, guint aSize)
+{
+    gint  length = (aWidth << aShift) * (gint) aSize;
+    gint  row, index;
+    guint block;
+
+    for (row = 0; row < aHeight; row++)
+    {
+        memset(aSumsPtr, 0, (gsize) length * sizeof(guint16));
+
+        for (block = 0; block < (1u << aShift); block++)
+        {
+            const guint8 * src_ptr = aSrcPtr + ((row << aShift) + (gint) block) * aSrcStride;
+
+            for (index = 0; index + 16 <= length; index += 16)
+            {
+                __m256i value = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (src_ptr + index)));
+                __m256i sums  = _mm256_loadu_si256((const __m256i *) (aSumsPtr + index));
+
+                _mm256_storeu_si256((__m256i *) (aSumsPtr + index), _mm256_add_epi16(sums, value));
+            }
+
+            for (; index < length; index++)
+            {
+                aSumsPtr[index] += src_ptr[index];
+            }
+        }
+
+        kms_detectix_downscale_reduce(aSumsPtr, aDstPtr + row * aDstStride, aWidth, aShift, aSize);
+    }
+
+    return;
+}
+
+
+// four pixels in sixteen 16 bit lanes, the icon as BGRA and the frame in its layout with the pad lanes kept
+KMS_DETECTIX_SPECIALIZE __m128i blend_quad(__m128i aSrc, __m128i aDst, __m256i aOpacity, __m256i aKeep, guint aBlue)
+{
+    __m256i src     = _mm256_cvtepu8_epi16(aSrc);
+    __m256i dst     = _mm256_cvtepu8_epi16(aDst);
+    __m256i alpha   = div255_round(_mm256_mullo_epi16(src, aOpacity));
+    __m256i inverse;
+    __m256i blended;
+
+    alpha   = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(alpha, 0xFF), 0xFF);
+    inverse = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+    blended = div255_round(_mm256_add_epi16(_mm256_mullo_epi16(to_layout(src, aBlue), alpha), _mm256_mullo_epi16(dst, inverse)));
+    blended = _mm256_or_si256(_mm256_and_si256(aKeep, blended), _mm256_andnot_si256(aKeep, dst));
+
+    return _mm_packus_epi16(_mm256_castsi256_si128(blended), _mm256_extracti128_si256(blended, 1));
+}
+
+
+KMS_DETECTIX_SPECIALIZE void avx2_blend_row(guint8 * aDstPtr, const guint8 * aSrcPtr, gint aWidth, guint aOpacity,
+                                            guint aSize, guint aBlue, guint aGreen, guint aRed)
+{
+    // BGR to BGRx and back, 0x80 clears the byte
+    __m128i widen   = _mm_setr_epi8(0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128);
+    __m128i narrow  = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -128, -128, -128, -128);
+    guint   pad     = KMS_DETECTIX_PAD_OFFSET(aBlue, aGreen, aRed);
+    __m256i opacity = _mm256_set1_epi16((gint16) aOpacity);
+    __m256i keep;
+    gint16  keep_lanes[16];
+    gint    col, index;
+
+    for (index = 0; index < 16; index++)
+    {
+        keep_lanes[index] = ((guint) index % 4 == pad) ? 0 : -1;
+    }
+
+    keep = _mm256_loadu_si256((const __m256i *) keep_lanes);
+
+    // 8 pixels, for 3 byte layouts the 16 byte loads of the frame read 4 bytes beyond the 12 blended
+    for (col = 0; (col + 8) * (gint) aSize + 4 * (aSize == 3) <= aWidth * (gint) aSize; col += 8)
+    {
+        guint8  * dst_ptr = aDstPtr + col * aSize;
+        __m256i   src     = _mm256_loadu_si256((const __m256i *) (aSrcPtr + col * 4));
+        __m128i   first;
+        __m128i   second;
+
+        if (aSize == 3)
+        {
+            guint8 packed[32];
+
+            first  = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) dst_ptr), widen);
+            second = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (dst_ptr + 12)), widen);
+
+            first  = blend_quad(_mm256_castsi256_si128(src),      first,  opacity, keep, aBlue);
+            second = blend_quad(_mm256_extracti128_si256(src, 1), second, opacity, keep, aBlue);
+
+            _mm_storeu_si128((__m128i *) packed,        _mm_shuffle_epi8(first,  narrow));
+            _mm_storeu_si128((__m128i *) (packed + 16), _mm_shuffle_epi8(second, narrow));
+
+            memcpy(dst_ptr,      packed,      12);
+            memcpy(dst_ptr + 12, packed + 16, 12);
+        }
+        else
+        {
+            first  = blend_quad(_mm256_castsi256_si128(src),      _mm_loadu_si128((const __m128i *) dst_ptr),        opacity, keep, aBlue);
+            second = blend_quad(_mm256_extracti128_si256(src, 1), _mm_loadu_si128((const __m128i *) (dst_ptr + 16)), opacity, keep, aBlue);
+
+            _mm_storeu_si128((__m128i *) dst_ptr,        first);
+            _mm_storeu_si128((__m128i *) (dst_ptr + 16), second);
+        }
+    }
+
+    for (; col < aWidth; col++)
+    {
+        kms_detectix_blend_pixel(aDstPtr + col * aSize, aSrcPtr + col * 4, aOpacity, aBlue, aGreen, aRed);
+    }
+
+    return;
+}
+
+
+#define AVX2_LAYOUT(aSuffix, aSize, aBlue, aGreen, aRed)                                                                \
+    static void avx2_classify_##aSuffix(const guint8 * aSrcPtr, gint aSrcStride, guint64 * aMaskPtr, gint aMaskStride,  \
+                                        gint aWidth, gint aHeight, const guint8 * aLowPtr, const guint8 * aHighPtr)     \
+    {                                                                                                                   \
+        avx2_classify(aSrcPtr, aSrcStride, aMaskPtr, aMaskStride, aWidth, aHeight, aLowPtr, aHighPtr,                   \
+                      aSize, aBlue, aGreen, aRed);                                                                      \
+    }                                                                                                                   \
+    static void avx2_downscale_##aSuffix(const guint8 * aSrcPtr, gint aSrcStride, guint8 * aDstPtr, gint aDstStride,    \
+                                         gint aWidth, gint aHeight, guint aShift, guint16 * aSumsPtr)                   \
+    {                                                                                                                   \
+        avx2_downscale(aSrcPtr, aSrcStride, aDstPtr, aDstStride, aWidth, aHeight, aShift, aSumsPtr, aSize);             \
+    }                                                                                                                   \
+    static void avx2_blend_row_##aSuffix(guint8 * aDstPtr, const guint8 * aSrcPtr, gint aWidth, guint aOpacity)        \
+    {                                                                                                                   \
+        avx2_blend_row(aDstPtr, aSrcPtr, aWidth, aOpacity, aSize, aBlue, aGreen, aRed);                                 \
+    }
+
+KMS_DETECTIX_FOR_EACH_LAYOUT(AVX2_LAYOUT)
+
+#define CLASSIFY_ENTRY(aSuffix, ...)    avx2_classify_##aSuffix,
+#define DOWNSCALE_ENTRY(aSuffix, ...)   avx2_downscale_##aSuffix,
+#define BLEND_ENTRY(aSuffix, ...)       avx2_blend_row_##aSuffix,
+
+const KmsDetectixKernels Kms_Detectix_Kernels_Avx2 =
+{
+    "avx2",
+    { KMS_DETECTIX_FOR_EACH_LAYOUT(CLASSIFY_ENTRY) },
+    { KMS_DETECTIX_FOR_EACH_LAYOUT(DOWNSCALE_ENTRY) },
+    { KMS_DETECTIX_FOR_EACH_LAYOUT(BLEND_ENTRY) },
+    kms_detectix_erode_words,
+    kms_detectix_dilate_words
+};
+
+// ends file:  "kmsdetectixkernels_avx2.c"
@@ -0,0 +1,249 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// built with -mfpu=neon on 32 bit ARM, only reached through the table when the CPU has it
+
+#include "kmsdetectixkernelsimpl.h"
+
+#include <string.h>
+#include <arm_neon.h>
+
+
+// x / 255 rounded to nearest for x + 127 up to 65534, as (x + 127) / 255 in the reference
+static inline uint8x8_t div255_round(uint16x8_t aValue)
+{
+    uint16x8_t biased = vaddq_u16(aValue, vdupq_n_u16(127));
+
+    return vshrn_n_u16(vaddq_u16(vaddq_u16(biased, vdupq_n_u16(1)), vshrq_n_u16(biased, 8)), 8);
+}
+
+
+// bytes of 0 or 0xFF as 16 bits, the first byte in the lowest --- there is no movemask, the pairwise adds gather the weighted bits
+static inline guint to_bits(uint8x16_t aMask)
+{
+    static const guint8 weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t          bits        = vandq_u8(aMask, vld1q_u8(weights));
+    uint8x8_t           sums        = vpadd_u8(vget_low_u8(bits), vget_high_u8(bits));
+
+    sums = vpadd_u8(sums, sums);
+    sums = vpadd_u8(sums, sums);
+
+    return (guint) vget_lane_u8(sums, 0) | ((guint) vget_lane_u8(sums, 1) << 8);
+}
+
+
+// the channels come deinterleaved, the layout only picks which of them are compared and blended
+KMS_DETECTIX_SPECIALIZE void neon_classify(const guint8 * aSrcPtr, gint aSrcStride, guint64 * aMaskPtr, gint aMaskStride,
+                                           gint aWidth, gint aHeight, const guint8 * aLowPtr, const guint8 * aHighPtr,
+                                           guint aSize, guint aBlue, guint aGreen, guint aRed)
+{
+    guint      offsets[3] = { aBlue, aGreen, aRed };
+    uint8x16_t low[3];
+    uint8x16_t high[3];
+    gint       row, col, channel;
+
+    for (channel = 0; channel < 3; channel++)
+    {
+        low[channel]  = vdupq_n_u8(aLowPtr[channel]);
+        high[channel] = vdupq_n_u8(aHighPtr[channel]);
+    }
+
+    for (row = 0; row < aHeight; row++)
+    {
+        const guint8 * src_ptr  = aSrcPtr  + row * aSrcStride;
+        guint64      * mask_ptr = aMaskPtr + row * aMaskStride;
+
+        // whole words of 64 pixels, in blocks of 16
+        for (col = 0; col + 64 <= aWidth; col += 64)
+        {
+            guint64 word = 0;
+            gint    block;
+
+            for (block = 0; block < 64; block += 16)
+            {
+                uint8x16_t pixels[4];
+                uint8x16_t mask = vdupq_n_u8(0xFF);
+
+                if (aSize == 3)
+                {
+                    uint8x16x3_t loaded = vld3q_u8(src_ptr + (col + block) * 3);
+
+                    pixels[0] = loaded.val[0];
+                    pixels[1] = loaded.val[1];
+                    pixels[2] = loaded.val[2];
+                }
+                else
+                {
+                    uint8x16x4_t loaded = vld4q_u8(src_ptr + (col + block) * 4);
+
+                    pixels[0] = loaded.val[0];
+                    pixels[1] = loaded.val[1];
+                    pixels[2] = loaded.val[2];
+                    pixels[3] = loaded.val[3];
+                }
+
+                for (channel = 0; channel < 3; channel++)
+                {
+                    uint8x16_t value = pixels[offsets[channel]];
+
+                    mask = vandq_u8(mask, vandq_u8(vcgeq_u8(value, low[channel]), vcleq_u8(value, high[channel])));
+                }
+
+                word |= (guint64) to_bits(mask) << block;
+            }
+
+            mask_ptr[col / 64] = word;
+        }
+
+        if (col < aWidth)
+        {
+            mask_ptr[col / 64] = kms_detectix_classify_bits(src_ptr + col * aSize, aWidth - col, aLowPtr, aHighPtr,
+                                                            aSize, aBlue, aGreen, aRed);
+        }
+    }
+
+    return;
+}
+
+
+KMS_DETECTIX_SPECIALIZE void neon_downscale(const guint8 * aSrcPtr, gint aSrcStride, guint8 * aDstPtr, gint aDstStride,
+                                            gint aWidth, gint aHeight, guint aShift, guint16 * aSumsPtr, guint aSize)
+{
+    gint  length = (aWidth << aShift) * (gint) aSize;
+    gint  row, index;
+    guint block;
+
+    for (row = 0; row < aHeight; row++)
+    {
+        memset(aSumsPtr, 0, (gsize) length * sizeof(guint16));
+
+        for (block = 0; block < (1u << aShift); block++)
+        {
+            const guint8 * src_ptr = aSrcPtr + ((row << aShift) + (gint) block) * aSrcStride;
+
+            for (index = 0; index + 16 <= length; index += 16)
+            {
+                uint8x16_t value = vld1q_u8(src_ptr + index);
+
+                vst1q_u16(aSumsPtr + index,     vaddw_u8(vld1q_u16(aSumsPtr + index),     vget_low_u8(value)));
+                vst1q_u16(aSumsPtr + index + 8, vaddw_u8(vld1q_u16(aSumsPtr + index + 8), vget_high_u8(value)));
+            }
+
+            for (; index < length; index++)
+            {
+                aSumsPtr[index] += src_ptr[index];
+            }
+        }
+
+        kms_detectix_downscale_reduce(aSumsPtr, aDstPtr + row * aDstStride, aWidth, aShift, aSize);
+    }
+
+    return;
+}
+
+
+// the pad channel of 4 byte layouts is stored back as loaded
+KMS_DETECTIX_SPECIALIZE void neon_blend_row(guint8 * aDstPtr, const guint8 * aSrcPtr, gint aWidth, guint aOpacity,
+                                            guint aSize, guint aBlue, guint aGreen, guint aRed)
+{
+    guint     offsets[3] = { aBlue, aGreen, aRed };
+    uint8x8_t opacity    = vdup_n_u8((guint8) aOpacity);
+    gint      col, channel;
+
+    for (col = 0; col + 8 <= aWidth; col += 8)
+    {
+        uint8x8x4_t src     = vld4_u8(aSrcPtr + col * 4);
+        uint8x8_t   alpha   = div255_round(vmull_u8(src.val[3], opacity));
+        uint8x8_t   inverse = vsub_u8(vdup_n_u8(255), alpha);
+        uint8x8x4_t dst;
+
+        if (aSize == 3)
+        {
+            uint8x8x3_t loaded = vld3_u8(aDstPtr + col * 3);
+
+            dst.val[0] = loaded.val[0];
+            dst.val[1] = loaded.val[1];
+            dst.val[2] = loaded.val[2];
+            dst.val[3] = vdup_n_u8(0);
+        }
+        else
+        {
+            dst = vld4_u8(aDstPtr + col * 4);
+        }
+
+        for (channel = 0; channel < 3; channel++)
+        {
+            guint offset = offsets[channel];
+
+            dst.val[offset] = div255_round(vmlal_u8(vmull_u8(src.val[channel], alpha), dst.val[offset], inverse));
+        }
+
+        if (aSize == 3)
+        {
+            uint8x8x3_t stored = { { dst.val[0], dst.val[1], dst.val[2] } };
+
+            vst3_u8(aDstPtr + col * 3, stored);
+        }
+        else
+        {
+            vst4_u8(aDstPtr + col * 4, dst);
+        }
+    }
+
+    for (; col < aWidth; col++)
+    {
+        kms_detectix_blend_pixel(aDstPtr + col * aSize, aSrcPtr + col * 4, aOpacity, aBlue, aGreen, aRed);
+    }
+
+    return;
+}
+
+
+#define NEON_LAYOUT(aSuffix, aSize, aBlue, aGreen, aRed)                                                                \
+    static void neon_classify_##aSuffix(const guint8 * aSrcPtr, gint aSrcStride, guint64 * aMaskPtr, gint aMaskStride,  \
+                                        gint aWidth, gint aHeight, const guint8 * aLowPtr, const guint8 * aHighPtr)     \
+    {                                                                                                                   \
+        neon_classify(aSrcPtr, aSrcStride, aMaskPtr, aMaskStride, aWidth, aHeight, aLowPtr, aHighPtr,                   \
+                      aSize, aBlue, aGreen, aRed);                                                                      \
+    }                                                                                                                   \
+    static void neon_downscale_##aSuffix(const guint8 * aSrcPtr, gint aSrcStride, guint8 * aDstPtr, gint aDstStride,    \
+                                         gint aWidth, gint aHeight, guint aShift, guint16 * aSumsPtr)                   \
+    {                                                                                                                   \
+        neon_downscale(aSrcPtr, aSrcStride, aDstPtr, aDstStride, aWidth, aHeight, aShift, aSumsPtr, aSize);             \
+    }                                                                                                                   \
+    static void neon_blend_row_##aSuffix(guint8 * aDstPtr, const guint8 * aSrcPtr, gint aWidth, guint aOpacity)        \
+    {                                                                                                                   \
+        neon_blend_row(aDstPtr, aSrcPtr, aWidth, aOpacity, aSize, aBlue, aGreen, aRed);                                 \
+    }
+
+KMS_DETECTIX_FOR_EACH_LAYOUT(NEON_LAYOUT)
+
+#define CLASSIFY_ENTRY(aSuffix, ...)    neon_classify_##aSuffix,
+#define DOWNSCALE_ENTRY(aSuffix, ...)   neon_downscale_##aSuffix,
+#define BLEND_ENTRY(aSuffix, ...)       neon_blend_row_##aSuffix,
+
+const KmsDetectixKernels Kms_Detectix_Kernels_Neon =
+{
+    "neon",
+    { KMS_DETECTIX_FOR_EACH_LAYOUT(CLASSIFY_ENTRY) },
+    { KMS_DETECTIX_FOR_EACH_LAYOUT(DOWNSCALE_ENTRY) },
+    { KMS_DETECTIX_FOR_EACH_LAYOUT(BLEND_ENTRY) },
+    kms_detectix_erode_words,
+    kms_detectix_dilate_words
+};
+
+// ends file:  "kmsdetectixkernels_neon.c"
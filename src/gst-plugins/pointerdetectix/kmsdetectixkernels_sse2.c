@@ -0,0 +1,303 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// built with -msse2, only reached through the table when the CPU has it
+
+#include "kmsdetectixkernelsimpl.h"
+
+#include <string.h>
+#include <emmintrin.h>
+
+
+// x / 255 rounded to nearest for x + 127 up to 65534, as (x + 127) / 255 in the reference
+static inline __m128i div255_round(__m128i aValue)
+{
+    __m128i biased = _mm_add_epi16(aValue, _mm_set1_epi16(127));
+
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(biased, _mm_set1_epi16(1)), _mm_srli_epi16(biased, 8)), 8);
+}
+
+
+// byte in [low, high] as 0xFF
+static inline __m128i in_range(__m128i aValue, __m128i aLow, __m128i aHigh)
+{
+    return _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(aValue, aLow), aValue),
+                         _mm_cmpeq_epi8(_mm_min_epu8(aValue, aHigh), aValue));
+}
+
+
+// icon lanes B, G, R, A of each pixel moved to the channel offsets of the layout, RGB layouts have blue at 2, xRGB at 3
+static inline __m128i to_layout(__m128i aIcon, guint aBlue)
+{
+    if (aBlue == 2)
+    {
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(aIcon, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+    }
+
+    if (aBlue == 3)
+    {
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(aIcon, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+    }
+
+    return aIcon;
+}
+
+
+KMS_DETECTIX_SPECIALIZE void sse2_classify(const guint8 * aSrcPtr, gint aSrcStride, guint64 * aMaskPtr, gint aMaskStride,
+                                           gint aWidth, gint aHeight, const guint8 * aLowPtr, const guint8 * aHighPtr,
+                                           guint aSize, guint aBlue, guint aGreen, guint aRed)
+{
+    __m128i ones = _mm_set1_epi8(-1);
+    guint8  low_pixel[4];
+    guint8  high_pixel[4];
+    guint8  low_bytes[48];
+    guint8  high_bytes[48];
+    __m128i low[3];
+    __m128i high[3];
+    gint    row, col, index;
+
+    kms_detectix_layout_bounds(low_pixel, high_pixel, aLowPtr, aHighPtr, aBlue, aGreen, aRed);
+
+    for (index = 0; index < 48; index++)
+    {
+        low_bytes[index]  = low_pixel[index % aSize];
+        high_bytes[index] = high_pixel[index % aSize];
+    }
+
+    for (index = 0; index < 3; index++)
+    {
+        low[index]  = _mm_loadu_si128((const __m128i *) (low_bytes  + index * 16));
+        high[index] = _mm_loadu_si128((const __m128i *) (high_bytes + index * 16));
+    }
+
+    for (row = 0; row < aHeight; row++)
+    {
+        const guint8 * src_ptr  = aSrcPtr  + row * aSrcStride;
+        guint64      * mask_ptr = aMaskPtr + row * aMaskStride;
+
+        // whole words of 64 pixels, in blocks of 16
+        for (col = 0; col + 64 <= aWidth; col += 64)
+        {
+            guint64 word = 0;
+            gint    block;
+
+            for (block = 0; block < 64; block += 16)
+            {
+                const guint8 * block_ptr = src_ptr + (col + block) * aSize;
+                guint          bits;
+
+                if (aSize == 3)
+                {
+                    // one bit per channel in 48, a pixel is in when its three bits are
+                    guint64 channels = 0;
+
+                    for (index = 0; index < 3; index++)
+                    {
+                        __m128i value = _mm_loadu_si128((const __m128i *) (block_ptr + index * 16));
+
+                        channels |= (guint64) (guint) _mm_movemask_epi8(in_range(value, low[index], high[index])) << (index * 16);
+                    }
+
+                    bits = kms_detectix_pack_triples(channels);
+                }
+                else
+                {
+                    // a pixel is in when its four bytes are, the pad byte always is
+                    __m128i words[4];
+
+                    for (index = 0; index < 4; index++)
+                    {
+                        __m128i value = _mm_loadu_si128((const __m128i *) (block_ptr + index * 16));
+
+                        words[index] = _mm_cmpeq_epi32(in_range(value, low[0], high[0]), ones);
+                    }
+
+                    bits = (guint) _mm_movemask_epi8(_mm_packs_epi16(_mm_packs_epi32(words[0], words[1]),
+                                                                     _mm_packs_epi32(words[2], words[3])));
+                }
+
+                word |= (guint64) bits << block;
+            }
+
+            mask_ptr[col / 64] = word;
+        }
+
+        if (col < aWidth)
+        {
+            mask_ptr[col / 64] = kms_detectix_classify_bits(src_ptr + col * aSize, aWidth - col, aLowPtr, aHighPtr,
+                                                            aSize, aBlue, aGreen, aRed);
+        }
+    }
+
+    return;
+}
+
+
+KMS_DETECTIX_SPECIALIZE void sse2_downscale(const guint8 * aSrcPtr, gint aSrcStride, guint8 * aDstPtr, gint aDstStride,
+                                            gint aWidth, gint aHeight, guint aShift, guint16 * aSumsPtr, guint aSize)
+{
+    gint    length = (aWidth << aShift) * (gint) aSize;
+    __m128i zero   = _mm_setzero_si128();
+    gint    row, index;
+    guint   block;
+
+    for (row = 0; row < aHeight; row++)
+    {
+        memset(aSumsPtr, 0, (gsize) length * sizeof(guint16));
+
+        for (block = 0; block < (1u << aShift); block++)
+        {
+            const guint8 * src_ptr = aSrcPtr + ((row << aShift) + (gint) block) * aSrcStride;
+
+            for (index = 0; index + 16 <= length; index += 16)
+            {
+                __m128i value = _mm_loadu_si128((const __m128i *) (src_ptr + index));
+                __m128i low   = _mm_loadu_si128((const __m128i *) (aSumsPtr + index));
+                __m128i high  = _mm_loadu_si128((const __m128i *) (aSumsPtr + index + 8));
+
+                _mm_storeu_si128((__m128i *) (aSumsPtr + index),     _mm_add_epi16(low,  _mm_unpacklo_epi8(value, zero)));
+                _mm_storeu_si128((__m128i *) (aSumsPtr + index + 8), _mm_add_epi16(high, _mm_unpackhi_epi8(value, zero)));
+            }
+
+            for (; index < length; index++)
+            {
+                aSumsPtr[index] += src_ptr[index];
+            }
+        }
+
+        kms_detectix_downscale_reduce(aSumsPtr, aDstPtr + row * aDstStride, aWidth, aShift, aSize);
+    }
+
+    return;
+}
+
+
+// two pixels in eight 16 bit lanes, the icon as BGRA and the frame in its layout with the pad lanes kept
+KMS_DETECTIX_SPECIALIZE __m128i blend_pair(__m128i aSrc, __m128i aDst, __m128i aOpacity, __m128i aKeep, guint aBlue)
+{
+    __m128i alpha   = div255_round(_mm_mullo_epi16(aSrc, aOpacity));
+    __m128i inverse;
+    __m128i blended;
+
+    alpha   = _mm_shufflehi_epi16(_mm_shufflelo_epi16(alpha, 0xFF), 0xFF);
+    inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+    blended = div255_round(_mm_add_epi16(_mm_mullo_epi16(to_layout(aSrc, aBlue), alpha), _mm_mullo_epi16(aDst, inverse)));
+
+    return _mm_or_si128(_mm_and_si128(aKeep, blended), _mm_andnot_si128(aKeep, aDst));
+}
+
+
+KMS_DETECTIX_SPECIALIZE void sse2_blend_row(guint8 * aDstPtr, const guint8 * aSrcPtr, gint aWidth, guint aOpacity,
+                                            guint aSize, guint aBlue, guint aGreen, guint aRed)
+{
+    guint   pad     = KMS_DETECTIX_PAD_OFFSET(aBlue, aGreen, aRed);
+    __m128i opacity = _mm_set1_epi16((gint16) aOpacity);
+    __m128i zero    = _mm_setzero_si128();
+    __m128i keep;
+    gint16  keep_lanes[8];
+    guint8  wide[16];
+    gint    col, index;
+
+    for (index = 0; index < 8; index++)
+    {
+        keep_lanes[index] = ((guint) index % 4 == pad) ? 0 : -1;
+    }
+
+    keep = _mm_loadu_si128((const __m128i *) keep_lanes);
+
+    for (col = 0; col + 4 <= aWidth; col += 4)
+    {
+        guint8  * dst_ptr = aDstPtr + col * aSize;
+        __m128i   src     = _mm_loadu_si128((const __m128i *) (aSrcPtr + col * 4));
+        __m128i   dst;
+
+        if (aSize == 3)
+        {
+            for (index = 0; index < 4; index++)
+            {
+                memcpy(wide + index * 4, dst_ptr + index * 3, 3);
+                wide[index * 4 + 3] = 0;
+            }
+
+            dst = _mm_loadu_si128((const __m128i *) wide);
+        }
+        else
+        {
+            dst = _mm_loadu_si128((const __m128i *) dst_ptr);
+        }
+
+        dst = _mm_packus_epi16(blend_pair(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero), opacity, keep, aBlue),
+                               blend_pair(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero), opacity, keep, aBlue));
+
+        if (aSize == 3)
+        {
+            _mm_storeu_si128((__m128i *) wide, dst);
+
+            for (index = 0; index < 4; index++)
+            {
+                memcpy(dst_ptr + index * 3, wide + index * 4, 3);
+            }
+        }
+        else
+        {
+            _mm_storeu_si128((__m128i *) dst_ptr, dst);
+        }
+    }
+
+    for (; col < aWidth; col++)
+    {
+        kms_detectix_blend_pixel(aDstPtr + col * aSize, aSrcPtr + col * 4, aOpacity, aBlue, aGreen, aRed);
+    }
+
+    return;
+}
+
+
+#define SSE2_LAYOUT(aSuffix, aSize, aBlue, aGreen, aRed)                                                                \
+    static void sse2_classify_##aSuffix(const guint8 * aSrcPtr, gint aSrcStride, guint64 * aMaskPtr, gint aMaskStride,  \
+                                        gint aWidth, gint aHeight, const guint8 * aLowPtr, const guint8 * aHighPtr)     \
+    {                                                                                                                   \
+        sse2_classify(aSrcPtr, aSrcStride, aMaskPtr, aMaskStride, aWidth, aHeight, aLowPtr, aHighPtr,                   \
+                      aSize, aBlue, aGreen, aRed);                                                                      \
+    }                                                                                                                   \
+    static void sse2_downscale_##aSuffix(const guint8 * aSrcPtr, gint aSrcStride, guint8 * aDstPtr, gint aDstStride,    \
+                                         gint aWidth, gint aHeight, guint aShift, guint16 * aSumsPtr)                   \
+    {                                                                                                                   \
+        sse2_downscale(aSrcPtr, aSrcStride, aDstPtr, aDstStride, aWidth, aHeight, aShift, aSumsPtr, aSize);             \
+    }                                                                                                                   \
+    static void sse2_blend_row_##aSuffix(guint8 * aDstPtr, const guint8 * aSrcPtr, gint aWidth, guint aOpacity)        \
+    {                                                                                                                   \
+        sse2_blend_row(aDstPtr, aSrcPtr, aWidth, aOpacity, aSize, aBlue, aGreen, aRed);                                 \
+    }
+
+KMS_DETECTIX_FOR_EACH_LAYOUT(SSE2_LAYOUT)
+
+#define CLASSIFY_ENTRY(aSuffix, ...)    sse2_classify_##aSuffix,
+#define DOWNSCALE_ENTRY(aSuffix, ...)   sse2_downscale_##aSuffix,
+#define BLEND_ENTRY(aSuffix, ...)       sse2_blend_row_##aSuffix,
+
+const KmsDetectixKernels Kms_Detectix_Kernels_Sse2 =
+{
+    "sse2",
+    { KMS_DETECTIX_FOR_EACH_LAYOUT(CLASSIFY_ENTRY) },
+    { KMS_DETECTIX_FOR_EACH_LAYOUT(DOWNSCALE_ENTRY) },
+    { KMS_DETECTIX_FOR_EACH_LAYOUT(BLEND_ENTRY) },
+    kms_detectix_erode_words,
+    kms_detectix_dilate_words
+};
+
+// ends file:  "kmsdetectixkernels_sse2.c"
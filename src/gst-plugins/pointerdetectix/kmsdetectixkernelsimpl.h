@@ -0,0 +1,145 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_KERNELS_IMPL_H_
+#define _KMS_DETECTIX_KERNELS_IMPL_H_
+
+#include "kmsdetectixkernels.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Shared by the kernel sets --- the vector code handles the bulk of a row
+ * and leaves borders and tails to these scalar pieces, so the results
+ * cannot drift from the reference.
+ */
+
+extern const KmsDetectixKernels Kms_Detectix_Kernels_Scalar;
+
+#ifdef DETECTIX_KERNELS_X86
+extern const KmsDetectixKernels Kms_Detectix_Kernels_Sse2;
+extern const KmsDetectixKernels Kms_Detectix_Kernels_Avx2;
+#endif
+
+#ifdef DETECTIX_KERNELS_NEON
+extern const KmsDetectixKernels Kms_Detectix_Kernels_Neon;
+#endif
+
+
+/*
+ * every KmsDetectixLayout in enum order as
+ * LAYOUT(suffix, bytes per pixel, blue offset, green offset, red offset)
+ */
+#define KMS_DETECTIX_FOR_EACH_LAYOUT(LAYOUT)    \
+    LAYOUT(bgr,  3, 0, 1, 2)                    \
+    LAYOUT(bgrx, 4, 0, 1, 2)                    \
+    LAYOUT(rgbx, 4, 2, 1, 0)                    \
+    LAYOUT(rgba, 4, 2, 1, 0)                    \
+    LAYOUT(xrgb, 4, 3, 2, 1)
+
+// byte of a 4 byte layout holding no colour, 3 for the 3 byte one
+#define KMS_DETECTIX_PAD_OFFSET(aBlue, aGreen, aRed)    (6 - (aBlue) - (aGreen) - (aRed))
+
+/*
+ * generic bodies taking the layout as arguments are forced inline into one wrapper
+ * per layout, where the arguments are constants --- also at -O0
+ */
+#define KMS_DETECTIX_SPECIALIZE     static inline __attribute__((always_inline))
+
+
+static inline guint kms_detectix_classify_pixel(const guint8 * aPixelPtr, const guint8 * aLowPtr, const guint8 * aHighPtr,
+                                                guint aBlue, guint aGreen, guint aRed)
+{
+    return ((aPixelPtr[aBlue]  >= aLowPtr[0]) && (aPixelPtr[aBlue]  <= aHighPtr[0]) &&
+            (aPixelPtr[aGreen] >= aLowPtr[1]) && (aPixelPtr[aGreen] <= aHighPtr[1]) &&
+            (aPixelPtr[aRed]   >= aLowPtr[2]) && (aPixelPtr[aRed]   <= aHighPtr[2])) ? 1 : 0;
+}
+
+
+// mask bits of aCount pixels up to 64, the first in the lowest bit
+static inline guint64 kms_detectix_classify_bits(const guint8 * aSrcPtr, gint aCount, const guint8 * aLowPtr, const guint8 * aHighPtr,
+                                                 guint aSize, guint aBlue, guint aGreen, guint aRed)
+{
+    guint64 bits = 0;
+    gint    index;
+
+    for (index = 0; index < aCount; index++)
+    {
+        bits |= (guint64) kms_detectix_classify_pixel(aSrcPtr + index * aSize, aLowPtr, aHighPtr, aBlue, aGreen, aRed) << index;
+    }
+
+    return bits;
+}
+
+
+// mask bits of 16 pixels of a 3 byte layout out of one bit per channel in 48, a pixel is in when its three bits are
+static inline guint kms_detectix_pack_triples(guint64 aBits)
+{
+    guint bits = 0;
+    gint  index;
+
+    aBits &= (aBits >> 1) & (aBits >> 2);
+
+    for (index = 0; index < 16; index++)
+    {
+        bits |= (guint) ((aBits >> (index * 3)) & 1) << index;
+    }
+
+    return bits;
+}
+
+
+static inline void kms_detectix_blend_pixel(guint8 * aDstPtr, const guint8 * aSrcPtr, guint aOpacity,
+                                            guint aBlue, guint aGreen, guint aRed)
+{
+    guint alpha = (aSrcPtr[3] * aOpacity + 127) / 255;
+
+    aDstPtr[aBlue]  = (guint8) ((aSrcPtr[0] * alpha + aDstPtr[aBlue]  * (255 - alpha) + 127) / 255);
+    aDstPtr[aGreen] = (guint8) ((aSrcPtr[1] * alpha + aDstPtr[aGreen] * (255 - alpha) + 127) / 255);
+    aDstPtr[aRed]   = (guint8) ((aSrcPtr[2] * alpha + aDstPtr[aRed]   * (255 - alpha) + 127) / 255);
+}
+
+
+// the bounds of the three channels at their offsets in a 4 byte pixel, the pad byte accepts anything
+static inline void kms_detectix_layout_bounds(guint8 * aLowPixelPtr, guint8 * aHighPixelPtr,
+                                              const guint8 * aLowPtr, const guint8 * aHighPtr,
+                                              guint aBlue, guint aGreen, guint aRed)
+{
+    aLowPixelPtr[KMS_DETECTIX_PAD_OFFSET(aBlue, aGreen, aRed)]  = 0;
+    aHighPixelPtr[KMS_DETECTIX_PAD_OFFSET(aBlue, aGreen, aRed)] = 255;
+
+    aLowPixelPtr[aBlue]   = aLowPtr[0];
+    aLowPixelPtr[aGreen]  = aLowPtr[1];
+    aLowPixelPtr[aRed]    = aLowPtr[2];
+    aHighPixelPtr[aBlue]  = aHighPtr[0];
+    aHighPixelPtr[aGreen] = aHighPtr[1];
+    aHighPixelPtr[aRed]   = aHighPtr[2];
+}
+
+
+/*
+ * the morphology of every set --- a 64 bit word already holds 64 pixels, so the sets
+ * share one word parallel body rather than each vectorizing its own
+ */
+void kms_detectix_erode_words(const guint64 * aSrcPtr, gint aSrcStride, guint64 * aDstPtr, gint aDstStride, gint aWidth, gint aHeight);
+void kms_detectix_dilate_words(const guint64 * aSrcPtr, gint aSrcStride, guint64 * aDstPtr, gint aDstStride, gint aWidth, gint aHeight);
+
+// blocks of the row sums into destination pixels of aSize bytes, aSumsPtr holds aWidth << aShift pixels
+void kms_detectix_downscale_reduce(const guint16 * aSumsPtr, guint8 * aDstPtr, gint aWidth, guint aShift, guint aSize);
+
+G_END_DECLS
+
+#endif
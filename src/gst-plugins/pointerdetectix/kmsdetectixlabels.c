@@ -0,0 +1,344 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "kmsdetectixlabels.h"
+
+#include <string.h>
+
+
+#define LABELS_MAX_SETS     G_MAXUINT16
+
+
+struct _KmsDetectixLabels
+{
+    gint        width;          // frame pixels
+    gint        height;
+    gint        shift;          // cells are 1 << shift pixels square
+    gint        columns;
+    gint        rows;
+    gint        margin;
+    guint16   * cells;          // label per cell, 0 is no window
+    GArray    * starts;         // guint32 per label, first of its entries
+    GArray    * lengths;        // guint32 per label
+    GArray    * entries;        // guint32, window index << 1 | inside
+};
+
+
+static gboolean is_inside(const KmsDetectixShape * aShapePtr, gdouble aX, gdouble aY)
+{
+    const GstVideoRectangle * rect_ptr = &aShapePtr->rect;
+
+    if ((aX < rect_ptr->x) || (aY < rect_ptr->y) || (aX >= rect_ptr->x + rect_ptr->w) || (aY >= rect_ptr->y + rect_ptr->h))
+    {
+        return FALSE;
+    }
+
+    switch (aShapePtr->type)
+    {
+        case KMS_DETECTIX_SHAPE_ELLIPSE:
+            {
+                gdouble dx = (aX - rect_ptr->x) / rect_ptr->w * 2.0 - 1.0;
+                gdouble dy = (aY - rect_ptr->y) / rect_ptr->h * 2.0 - 1.0;
+
+                return (dx * dx + dy * dy) <= 1.0;
+            }
+
+        case KMS_DETECTIX_SHAPE_POLYGON:
+            {
+                gdouble  u         = (aX - rect_ptr->x) / rect_ptr->w;
+                gdouble  v         = (aY - rect_ptr->y) / rect_ptr->h;
+                gboolean is_odd    = FALSE;
+                guint    index;
+                guint    previous;
+
+                // even-odd rule, a crossing is counted for every edge that spans v right of u
+                for (index = 0, previous = aShapePtr->num_points - 1; index < aShapePtr->num_points; previous = index++)
+                {
+                    gdouble u0 = aShapePtr->points[2 * previous];
+                    gdouble v0 = aShapePtr->points[2 * previous + 1];
+                    gdouble u1 = aShapePtr->points[2 * index];
+                    gdouble v1 = aShapePtr->points[2 * index + 1];
+
+                    if (((v0 > v) != (v1 > v)) && (u < u0 + (v - v0) * (u1 - u0) / (v1 - v0)))
+                    {
+                        is_odd = ! is_odd;
+                    }
+                }
+
+                return is_odd;
+            }
+
+        case KMS_DETECTIX_SHAPE_MASK:
+            {
+                const guint8 * pixel_ptr = aShapePtr->mask + (gint) (aY - rect_ptr->y) * aShapePtr->mask_stride + (gint) (aX - rect_ptr->x) * 4;
+                guint          luma      = (pixel_ptr[0] * 29 + pixel_ptr[1] * 150 + pixel_ptr[2] * 77) >> 8;
+
+                return (pixel_ptr[3] >= 128) && (luma >= 128);
+            }
+
+        case KMS_DETECTIX_SHAPE_RECTANGLE:
+        default:
+            return TRUE;
+    }
+}
+
+
+// the label of the set of aLabel plus aEntry, made once per window for every label it meets
+static guint16 add_to_set(KmsDetectixLabels * aLabelsPtr, guint32 * aRemapPtr, guint16 aLabel, guint32 aEntry)
+{
+    guint32 * slot_ptr = &aRemapPtr[aLabel * 2 + (aEntry & 1)];
+    guint32   start;
+    guint32   length;
+    guint32   position;
+    guint32 * entries_ptr;
+
+    if (*slot_ptr != 0)
+    {
+        return (guint16) (*slot_ptr - 1);
+    }
+
+    if (aLabelsPtr->starts->len > LABELS_MAX_SETS)
+    {
+        GST_WARNING ("windows overlap in more than %u ways, window %u is left out where they do", LABELS_MAX_SETS, aEntry >> 1);
+
+        *slot_ptr = aLabel + 1u;
+
+        return aLabel;
+    }
+
+    start    = g_array_index(aLabelsPtr->starts,  guint32, aLabel);
+    length   = g_array_index(aLabelsPtr->lengths, guint32, aLabel);
+    position = aLabelsPtr->entries->len;
+
+    // the set grows out of the same array, so it is copied after the resize
+    g_array_set_size(aLabelsPtr->entries, position + length + 1);
+
+    entries_ptr = (guint32 *) aLabelsPtr->entries->data;
+
+    memcpy(&entries_ptr[position], &entries_ptr[start], length * sizeof(guint32));
+    entries_ptr[position + length] = aEntry;
+
+    length++;
+
+    g_array_append_val(aLabelsPtr->starts,  position);
+    g_array_append_val(aLabelsPtr->lengths, length);
+
+    *slot_ptr = aLabelsPtr->starts->len;
+
+    return (guint16) (aLabelsPtr->starts->len - 1);
+}
+
+
+// a cell is set when any cell of the core within aReach columns and rows is
+static void dilate(const guint8 * aCorePtr, guint8 * aGrownPtr, gint aWidth, gint aHeight, gint aReach)
+{
+    guint8  * rows_ptr = g_malloc((gsize) aWidth * aHeight);
+    guint32 * sums_ptr = g_new(guint32, MAX(aWidth, aHeight) + 1);
+    gint      x;
+    gint      y;
+
+    for (y = 0; y < aHeight; y++)
+    {
+        for (x = 0, sums_ptr[0] = 0; x < aWidth; x++)
+        {
+            sums_ptr[x + 1] = sums_ptr[x] + (aCorePtr[y * aWidth + x] != 0);
+        }
+
+        for (x = 0; x < aWidth; x++)
+        {
+            rows_ptr[y * aWidth + x] = sums_ptr[MIN(aWidth, x + aReach + 1)] != sums_ptr[MAX(0, x - aReach)];
+        }
+    }
+
+    for (x = 0; x < aWidth; x++)
+    {
+        for (y = 0, sums_ptr[0] = 0; y < aHeight; y++)
+        {
+            sums_ptr[y + 1] = sums_ptr[y] + rows_ptr[y * aWidth + x];
+        }
+
+        for (y = 0; y < aHeight; y++)
+        {
+            aGrownPtr[y * aWidth + x] = sums_ptr[MIN(aHeight, y + aReach + 1)] != sums_ptr[MAX(0, y - aReach)];
+        }
+    }
+
+    g_free(sums_ptr);
+    g_free(rows_ptr);
+
+    return;
+}
+
+
+static void add_window(KmsDetectixLabels * aLabelsPtr, const KmsDetectixShape * aShapePtr, guint aIndex)
+{
+    const GstVideoRectangle * rect_ptr = &aShapePtr->rect;
+    gint                      size     = 1 << aLabelsPtr->shift;
+    gint                      reach    = (aLabelsPtr->margin + size - 1) >> aLabelsPtr->shift;
+    gint                      left     = MAX(0, rect_ptr->x / size);
+    gint                      top      = MAX(0, rect_ptr->y / size);
+    gint                      right    = MIN(aLabelsPtr->columns, (rect_ptr->x + rect_ptr->w) / size + 1);
+    gint                      bottom   = MIN(aLabelsPtr->rows,    (rect_ptr->y + rect_ptr->h) / size + 1);
+    gint                      width;
+    gint                      height;
+    guint8                  * core_ptr;
+    guint8                  * grown_ptr;
+    guint32                 * remap_ptr;
+    gint                      column;
+    gint                      row;
+
+    if ((rect_ptr->w <= 0) || (rect_ptr->h <= 0) || (left >= right) || (top >= bottom) ||
+        ((aShapePtr->type == KMS_DETECTIX_SHAPE_POLYGON) && (aShapePtr->num_points < 3)) ||
+        ((aShapePtr->type == KMS_DETECTIX_SHAPE_MASK) && (aShapePtr->mask == NULL)))
+    {
+        return;
+    }
+
+    // the core is laid out over the bounds grown by the margin, where the dilation may reach
+    left   = MAX(0, left - reach);
+    top    = MAX(0, top  - reach);
+    right  = MIN(aLabelsPtr->columns, right  + reach);
+    bottom = MIN(aLabelsPtr->rows,    bottom + reach);
+    width  = right - left;
+    height = bottom - top;
+
+    core_ptr  = g_malloc((gsize) width * height);
+    grown_ptr = g_malloc((gsize) width * height);
+    remap_ptr = g_new0(guint32, aLabelsPtr->starts->len * 2);
+
+    for (row = 0; row < height; row++)
+    {
+        gdouble y = ((top + row) << aLabelsPtr->shift) + size * 0.5;
+
+        for (column = 0; column < width; column++)
+        {
+            gdouble x = ((left + column) << aLabelsPtr->shift) + size * 0.5;
+
+            core_ptr[row * width + column] = is_inside(aShapePtr, x, y);
+        }
+    }
+
+    if (reach > 0)
+    {
+        dilate(core_ptr, grown_ptr, width, height, reach);
+    }
+    else
+    {
+        memcpy(grown_ptr, core_ptr, (gsize) width * height);
+    }
+
+    for (row = 0; row < height; row++)
+    {
+        guint16 * cells_ptr = &aLabelsPtr->cells[(top + row) * aLabelsPtr->columns + left];
+
+        for (column = 0; column < width; column++)
+        {
+            if (grown_ptr[row * width + column])
+            {
+                cells_ptr[column] = add_to_set(aLabelsPtr, remap_ptr, cells_ptr[column], (aIndex << 1) | core_ptr[row * width + column]);
+            }
+        }
+    }
+
+    g_free(remap_ptr);
+    g_free(grown_ptr);
+    g_free(core_ptr);
+
+    return;
+}
+
+
+KmsDetectixLabels * kms_detectix_labels_new(gint                     aWidth,
+                                            gint                     aHeight,
+                                            const KmsDetectixShape * aShapesPtr,
+                                            guint                    aNumShapes,
+                                            gint                     aMargin)
+{
+    KmsDetectixLabels * labels_ptr = g_new0(KmsDetectixLabels, 1);
+    guint32             empty      = 0;
+    guint               index;
+
+    labels_ptr->width   = MAX(0, aWidth);
+    labels_ptr->height  = MAX(0, aHeight);
+    labels_ptr->margin  = MAX(0, aMargin);
+    labels_ptr->starts  = g_array_new(FALSE, FALSE, sizeof(guint32));
+    labels_ptr->lengths = g_array_new(FALSE, FALSE, sizeof(guint32));
+    labels_ptr->entries = g_array_new(FALSE, FALSE, sizeof(guint32));
+
+    do
+    {
+        gint size = 1 << labels_ptr->shift;
+
+        labels_ptr->columns = (labels_ptr->width  + size - 1) >> labels_ptr->shift;
+        labels_ptr->rows    = (labels_ptr->height + size - 1) >> labels_ptr->shift;
+    }
+    while (((gint64) labels_ptr->columns * labels_ptr->rows > KMS_DETECTIX_LABELS_MAX_CELLS) && (++labels_ptr->shift < 16));
+
+    labels_ptr->cells = g_new0(guint16, (gsize) labels_ptr->columns * labels_ptr->rows);
+
+    // label 0 is the empty set
+    g_array_append_val(labels_ptr->starts,  empty);
+    g_array_append_val(labels_ptr->lengths, empty);
+
+    for (index = 0; index < aNumShapes; index++)
+    {
+        add_window(labels_ptr, &aShapesPtr[index], index);
+    }
+
+    return labels_ptr;
+}
+
+
+void kms_detectix_labels_free(KmsDetectixLabels * aLabelsPtr)
+{
+    if (aLabelsPtr != NULL)
+    {
+        g_free(aLabelsPtr->cells);
+        g_array_unref(aLabelsPtr->starts);
+        g_array_unref(aLabelsPtr->lengths);
+        g_array_unref(aLabelsPtr->entries);
+        g_free(aLabelsPtr);
+    }
+
+    return;
+}
+
+
+gint kms_detectix_labels_get_margin(const KmsDetectixLabels * aLabelsPtr)
+{
+    return aLabelsPtr->margin;
+}
+
+
+guint kms_detectix_labels_hit(const KmsDetectixLabels * aLabelsPtr, gint aX, gint aY, const guint32 ** aEntriesPtr)
+{
+    guint16 label;
+
+    if ((aX < 0) || (aY < 0) || (aX >= aLabelsPtr->width) || (aY >= aLabelsPtr->height))
+    {
+        *aEntriesPtr = NULL;
+        return 0;
+    }
+
+    label = aLabelsPtr->cells[(aY >> aLabelsPtr->shift) * aLabelsPtr->columns + (aX >> aLabelsPtr->shift)];
+
+    *aEntriesPtr = &g_array_index(aLabelsPtr->entries, guint32, g_array_index(aLabelsPtr->starts, guint32, label));
+
+    return g_array_index(aLabelsPtr->lengths, guint32, label);
+}
+
+
+// ends file:  "kmsdetectixlabels.c"
@@ -0,0 +1,85 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_LABELS_H_
+#define _KMS_DETECTIX_LABELS_H_
+
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Label map of the windows layout.
+ *
+ * Every window, whatever its shape, is rasterized once per layout, frame
+ * size and margin into a map of cells of the frame, each holding the label
+ * of the set of windows that cover it. A set lists the windows in layout
+ * order, each one marked when the cell is inside the window itself rather
+ * than only inside its margin. Hit testing is then one load from the map,
+ * however many windows there are and however they are shaped. Frames larger
+ * than KMS_DETECTIX_LABELS_MAX_CELLS pixels are mapped in square blocks of
+ * 2, 4 ... pixels, each labeled by the windows covering its center.
+ */
+
+#define KMS_DETECTIX_LABELS_MAX_CELLS   (1 << 19)
+
+
+typedef enum
+{
+    KMS_DETECTIX_SHAPE_RECTANGLE,
+    KMS_DETECTIX_SHAPE_ELLIPSE,     // inscribed in the rectangle
+    KMS_DETECTIX_SHAPE_POLYGON,
+    KMS_DETECTIX_SHAPE_MASK
+
+} KmsDetectixShapeType;
+
+
+typedef struct _KmsDetectixShape
+{
+    KmsDetectixShapeType    type;
+    GstVideoRectangle       rect;           // frame pixels, the bounds of every shape
+    const gdouble         * points;         // polygon: x, y pairs as fractions of the rectangle
+    guint                   num_points;
+    const guint8          * mask;           // mask: BGRA of the rectangle size, inside where opaque and bright
+    gint                    mask_stride;
+
+} KmsDetectixShape;
+
+
+typedef struct _KmsDetectixLabels KmsDetectixLabels;
+
+
+// aMargin grows every window by that many pixels, as a square around each of its pixels
+KmsDetectixLabels * kms_detectix_labels_new(gint                     aWidth,
+                                            gint                     aHeight,
+                                            const KmsDetectixShape * aShapesPtr,
+                                            guint                    aNumShapes,
+                                            gint                     aMargin);
+
+void kms_detectix_labels_free(KmsDetectixLabels * aLabelsPtr);
+
+gint kms_detectix_labels_get_margin(const KmsDetectixLabels * aLabelsPtr);
+
+/*
+ * the windows at aX, aY, in layout order, as the index of the window shifted left
+ * by one, plus one when the point is inside the window and not only in its margin
+ * --- points off the frame hit nothing
+ */
+guint kms_detectix_labels_hit(const KmsDetectixLabels * aLabelsPtr, gint aX, gint aY, const guint32 ** aEntriesPtr);
+
+G_END_DECLS
+
+#endif
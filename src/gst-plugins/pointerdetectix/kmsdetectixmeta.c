@@ -0,0 +1,139 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixmetaimpl.h"
+
+#include <string.h>
+
+
+GType kms_detectix_meta_api_get_type(void)
+{
+    static volatile GType  The_Api_Type = 0;
+    static const gchar   * The_Tags[]   = { GST_META_TAG_VIDEO_STR, NULL };
+
+    if (g_once_init_enter(&The_Api_Type))
+    {
+        GType api_type = gst_meta_api_type_register(KMS_DETECTIX_META_API_NAME, The_Tags);
+
+        g_once_init_leave(&The_Api_Type, api_type);
+    }
+
+    return The_Api_Type;
+}
+
+
+static gboolean kms_detectix_meta_init(GstMeta * aMetaPtr, gpointer aParamsPtr, GstBuffer * aBufferPtr)
+{
+    KmsDetectixMeta * meta_ptr = (KmsDetectixMeta *) aMetaPtr;
+
+    meta_ptr->found          = FALSE;
+    meta_ptr->x              = 0;
+    meta_ptr->y              = 0;
+    meta_ptr->confidence     = 0.0;
+    meta_ptr->active_windows = NULL;
+
+    memset(&meta_ptr->bounds, 0, sizeof(meta_ptr->bounds));
+
+    return TRUE;
+}
+
+
+static void kms_detectix_meta_free(GstMeta * aMetaPtr, GstBuffer * aBufferPtr)
+{
+    KmsDetectixMeta * meta_ptr = (KmsDetectixMeta *) aMetaPtr;
+
+    g_strfreev(meta_ptr->active_windows);
+    meta_ptr->active_windows = NULL;
+
+    return;
+}
+
+
+// only plain copies keep the meta --- coordinates are meaningless once the frame is scaled or cropped
+static gboolean kms_detectix_meta_transform(GstBuffer * aDestPtr,
+                                            GstMeta   * aMetaPtr,
+                                            GstBuffer * aBufferPtr,
+                                            GQuark      aType,
+                                            gpointer    aDataPtr)
+{
+    KmsDetectixMeta * meta_ptr = (KmsDetectixMeta *) aMetaPtr;
+
+    if (! GST_META_TRANSFORM_IS_COPY (aType))
+    {
+        return FALSE;
+    }
+
+    return gst_buffer_add_kms_detectix_meta(aDestPtr,
+                                            meta_ptr->found,
+                                            meta_ptr->x,
+                                            meta_ptr->y,
+                                            &meta_ptr->bounds,
+                                            meta_ptr->confidence,
+                                            g_strdupv(meta_ptr->active_windows)) != NULL;
+}
+
+
+const GstMetaInfo * kms_detectix_meta_get_info(void)
+{
+    static const GstMetaInfo * The_Meta_Info = NULL;
+
+    if (g_once_init_enter((GstMetaInfo **) &The_Meta_Info))
+    {
+        const GstMetaInfo * meta_info = gst_meta_register(KMS_DETECTIX_META_API_TYPE,
+                                                          "KmsDetectixMeta",
+                                                          sizeof(KmsDetectixMeta),
+                                                          kms_detectix_meta_init,
+                                                          kms_detectix_meta_free,
+                                                          kms_detectix_meta_transform);
+
+        g_once_init_leave((GstMetaInfo **) &The_Meta_Info, (GstMetaInfo *) meta_info);
+    }
+
+    return The_Meta_Info;
+}
+
+
+/*
+ * the meta takes ownership of aActiveWindows
+ */
+KmsDetectixMeta * gst_buffer_add_kms_detectix_meta(GstBuffer               * aBufferPtr,
+                                                   gboolean                  aFound,
+                                                   gint                      aX,
+                                                   gint                      aY,
+                                                   const GstVideoRectangle * aBoundsPtr,
+                                                   gdouble                   aConfidence,
+                                                   gchar                  ** aActiveWindows)
+{
+    KmsDetectixMeta * meta_ptr = (KmsDetectixMeta *) gst_buffer_add_meta(aBufferPtr, KMS_DETECTIX_META_INFO, NULL);
+
+    if (meta_ptr == NULL)
+    {
+        g_strfreev(aActiveWindows);
+        return NULL;
+    }
+
+    meta_ptr->found          = aFound;
+    meta_ptr->x              = aX;
+    meta_ptr->y              = aY;
+    meta_ptr->bounds         = *aBoundsPtr;
+    meta_ptr->confidence     = aConfidence;
+    meta_ptr->active_windows = aActiveWindows;
+
+    return meta_ptr;
+}
+
+// ends file:  "kmsdetectixmeta.c"
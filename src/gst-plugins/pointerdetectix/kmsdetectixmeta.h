@@ -0,0 +1,64 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_META_H_
+#define _KMS_DETECTIX_META_H_
+
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Result of the pointer analysis carried by every buffer leaving pointerdetectix.
+ *
+ * Downstream elements of the same pipeline read it with
+ * gst_buffer_get_kms_detectix_meta() instead of listening to bus messages,
+ * so the position always matches the frame it was found in.  The element is a
+ * plugin module nobody links against, so this header only needs GStreamer: the
+ * API type is looked up by name and is 0 until the plugin has been loaded.
+ */
+
+#define KMS_DETECTIX_META_API_NAME  "KmsDetectixMetaAPI"
+
+typedef struct _KmsDetectixMeta
+{
+    GstMeta             meta;
+
+    gboolean            found;
+    gint                x;                  // centroid, frame coordinates
+    gint                y;
+    GstVideoRectangle   bounds;
+    gdouble             confidence;
+    gchar            ** active_windows;     // ids of the entered windows, NULL terminated
+
+} KmsDetectixMeta;
+
+
+static inline KmsDetectixMeta * gst_buffer_get_kms_detectix_meta(GstBuffer * aBufferPtr)
+{
+    GType api_type = g_type_from_name(KMS_DETECTIX_META_API_NAME);
+
+    if (api_type == 0)
+    {
+        return NULL;
+    }
+
+    return (KmsDetectixMeta *) gst_buffer_get_meta(aBufferPtr, api_type);
+}
+
+G_END_DECLS
+
+#endif
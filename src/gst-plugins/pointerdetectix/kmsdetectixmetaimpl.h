@@ -0,0 +1,45 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_META_IMPL_H_
+#define _KMS_DETECTIX_META_IMPL_H_
+
+#include "kmsdetectixmeta.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Registration and writer side of the meta, compiled into the plugin only.
+ */
+
+#define KMS_DETECTIX_META_API_TYPE  (kms_detectix_meta_api_get_type())
+#define KMS_DETECTIX_META_INFO      (kms_detectix_meta_get_info())
+
+GType kms_detectix_meta_api_get_type(void);
+
+const GstMetaInfo * kms_detectix_meta_get_info(void);
+
+KmsDetectixMeta * gst_buffer_add_kms_detectix_meta(GstBuffer               * aBufferPtr,
+                                                   gboolean                  aFound,
+                                                   gint                      aX,
+                                                   gint                      aY,
+                                                   const GstVideoRectangle * aBoundsPtr,
+                                                   gdouble                   aConfidence,
+                                                   gchar                  ** aActiveWindows);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,330 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixmetricsimpl.h"
+
+#include <gst/gst.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+#define METRICS_ALIGN           64      // slots never share a cache line
+#define METRICS_FIRST_BOUND_NS  32000   // bucket i ends at 32 us << i
+
+
+static GMutex       The_Metrics_Mutex;
+static gboolean     The_Metrics_Tried = FALSE;      // protected by The_Metrics_Mutex
+static guint8     * The_Metrics_Base  = NULL;       // protected by The_Metrics_Mutex
+static gchar      * The_Metrics_Name  = NULL;       // set once, with The_Metrics_Base
+
+
+static gsize align_up(gsize aSize)
+{
+    return (aSize + METRICS_ALIGN - 1) & ~((gsize) METRICS_ALIGN - 1);
+}
+
+
+static KmsDetectixMetricsSlot * slot_at(guint aIndex)
+{
+    const KmsDetectixMetricsHeader * header_ptr = (const KmsDetectixMetricsHeader *) The_Metrics_Base;
+
+    return (KmsDetectixMetricsSlot *) (The_Metrics_Base + header_ptr->slots_offset + (gsize) aIndex * header_ptr->slot_size);
+}
+
+
+/*
+ * a segment that already exists belongs to a live process unless the pid in its header is
+ * gone or is ours --- this process maps its segment once, so ours was left by a crashed
+ * predecessor with the same ID
+ */
+static gboolean is_segment_stale(const gchar * aNamePtr)
+{
+    KmsDetectixMetricsHeader * header_ptr;
+    struct stat                status;
+    gboolean                   is_stale = FALSE;
+    gint                       fd       = shm_open(aNamePtr, O_RDONLY, 0);
+
+    if (fd < 0)
+    {
+        return (errno == ENOENT);
+    }
+
+    if ((fstat(fd, &status) != 0) || (status.st_size < (off_t) sizeof(KmsDetectixMetricsHeader)))
+    {
+        close(fd);
+        return FALSE;
+    }
+
+    header_ptr = mmap(NULL, sizeof(KmsDetectixMetricsHeader), PROT_READ, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (header_ptr == MAP_FAILED)
+    {
+        return FALSE;
+    }
+
+    if (header_ptr->pid != 0)
+    {
+        pid_t pid = (pid_t) header_ptr->pid;
+
+        is_stale = (pid == getpid()) || ((kill(pid, 0) != 0) && (errno == ESRCH));
+    }
+
+    munmap(header_ptr, sizeof(KmsDetectixMetricsHeader));
+
+    return is_stale;
+}
+
+
+static void unlink_segment(void)
+{
+    shm_unlink(The_Metrics_Name);
+}
+
+
+// once per process, with The_Metrics_Mutex held --- a failure disables the metrics for good
+static gboolean map_segment(void)
+{
+    const gchar              * env_ptr      = g_getenv("DETECTIX_METRICS_SEGMENT");
+    gsize                      slots_offset = align_up(sizeof(KmsDetectixMetricsHeader));
+    gsize                      slot_size    = align_up(sizeof(KmsDetectixMetricsSlot));
+    gsize                      size         = slots_offset + slot_size * KMS_DETECTIX_METRICS_SLOTS;
+    KmsDetectixMetricsHeader * header_ptr;
+    gchar                    * name_ptr;
+    gpointer                   base_ptr;
+    gint                       fd;
+    guint                      index;
+
+    if (The_Metrics_Tried)
+    {
+        return (The_Metrics_Base != NULL);
+    }
+
+    The_Metrics_Tried = TRUE;
+
+    name_ptr = ((env_ptr != NULL) && (*env_ptr != '\0')) ? g_strdup(env_ptr)
+                                                         : g_strdup_printf("%s%u", KMS_DETECTIX_METRICS_PREFIX, (guint) getpid());
+
+    // a segment left behind by a dead process is replaced, one of a live process is not ours
+    fd = shm_open(name_ptr, O_RDWR | O_CREAT | O_EXCL, 0644);
+
+    if ((fd < 0) && (errno == EEXIST) && is_segment_stale(name_ptr))
+    {
+        shm_unlink(name_ptr);
+
+        fd = shm_open(name_ptr, O_RDWR | O_CREAT | O_EXCL, 0644);
+    }
+
+    if ((fd < 0) || (ftruncate(fd, (off_t) size) != 0))
+    {
+        GST_WARNING ("no metrics segment %s", name_ptr);
+
+        if (fd >= 0)
+        {
+            close(fd);
+            shm_unlink(name_ptr);
+        }
+
+        g_free(name_ptr);
+        return FALSE;
+    }
+
+    base_ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (base_ptr == MAP_FAILED)
+    {
+        GST_WARNING ("no metrics segment %s", name_ptr);
+
+        shm_unlink(name_ptr);
+        g_free(name_ptr);
+        return FALSE;
+    }
+
+    // the pages come zeroed, so every slot is free
+    header_ptr = (KmsDetectixMetricsHeader *) base_ptr;
+
+    header_ptr->version      = KMS_DETECTIX_METRICS_VERSION;
+    header_ptr->slot_count   = KMS_DETECTIX_METRICS_SLOTS;
+    header_ptr->slot_size    = (guint32) slot_size;
+    header_ptr->slots_offset = (guint32) slots_offset;
+    header_ptr->bucket_count = KMS_DETECTIX_METRICS_BUCKETS;
+    header_ptr->pid          = (guint32) getpid();
+
+    for (index = 0; index < KMS_DETECTIX_METRICS_BUCKETS - 1; index++)
+    {
+        header_ptr->bucket_bounds_ns[index] = (guint64) METRICS_FIRST_BOUND_NS << index;
+    }
+
+    header_ptr->bucket_bounds_ns[KMS_DETECTIX_METRICS_BUCKETS - 1] = G_MAXUINT64;
+
+    // scrapers only trust the layout once the magic is there
+    __sync_synchronize();
+
+    header_ptr->magic = KMS_DETECTIX_METRICS_MAGIC;
+
+    The_Metrics_Base = base_ptr;
+    The_Metrics_Name = name_ptr;
+
+    atexit(unlink_segment);
+
+    return TRUE;
+}
+
+
+KmsDetectixMetricsSlot * kms_detectix_metrics_acquire(const gchar * aIdPtr)
+{
+    KmsDetectixMetricsSlot * slot_ptr = NULL;
+    guint                    index;
+
+    g_mutex_lock(&The_Metrics_Mutex);
+
+    if (map_segment())
+    {
+        for (index = 0; (slot_ptr == NULL) && (index < KMS_DETECTIX_METRICS_SLOTS); index++)
+        {
+            if (slot_at(index)->in_use == 0)
+            {
+                slot_ptr = slot_at(index);
+            }
+        }
+    }
+
+    if (slot_ptr != NULL)
+    {
+        kms_detectix_metrics_begin(slot_ptr);
+
+        slot_ptr->in_use = 1;
+
+        kms_detectix_metrics_set_id(slot_ptr, aIdPtr);
+
+        kms_detectix_metrics_end(slot_ptr);
+    }
+    else if (The_Metrics_Base != NULL)
+    {
+        GST_WARNING ("all %u metrics slots are taken", KMS_DETECTIX_METRICS_SLOTS);
+    }
+
+    g_mutex_unlock(&The_Metrics_Mutex);
+
+    return slot_ptr;
+}
+
+
+void kms_detectix_metrics_release(KmsDetectixMetricsSlot * aSlotPtr)
+{
+    if (aSlotPtr == NULL)
+    {
+        return;
+    }
+
+    g_mutex_lock(&The_Metrics_Mutex);
+
+    kms_detectix_metrics_begin(aSlotPtr);
+
+    memset((guint8 *) aSlotPtr + sizeof(aSlotPtr->sequence), 0, sizeof(*aSlotPtr) - sizeof(aSlotPtr->sequence));
+
+    kms_detectix_metrics_end(aSlotPtr);
+
+    g_mutex_unlock(&The_Metrics_Mutex);
+
+    return;
+}
+
+
+void kms_detectix_metrics_begin(KmsDetectixMetricsSlot * aSlotPtr)
+{
+    if (aSlotPtr != NULL)
+    {
+        g_atomic_int_inc((gint *) &aSlotPtr->sequence);
+
+        // no write of the slot may be seen before the odd sequence
+        __sync_synchronize();
+    }
+
+    return;
+}
+
+
+void kms_detectix_metrics_end(KmsDetectixMetricsSlot * aSlotPtr)
+{
+    if (aSlotPtr != NULL)
+    {
+        aSlotPtr->updated_ns = (guint64) g_get_monotonic_time() * 1000;
+
+        __sync_synchronize();
+
+        g_atomic_int_inc((gint *) &aSlotPtr->sequence);
+    }
+
+    return;
+}
+
+
+void kms_detectix_metrics_set_id(KmsDetectixMetricsSlot * aSlotPtr, const gchar * aIdPtr)
+{
+    if (aSlotPtr != NULL)
+    {
+        memset(aSlotPtr->id, 0, sizeof(aSlotPtr->id));
+
+        g_strlcpy(aSlotPtr->id, (aIdPtr != NULL) ? aIdPtr : "", sizeof(aSlotPtr->id));
+    }
+
+    return;
+}
+
+
+void kms_detectix_metrics_observe(guint64 * aHistogramPtr, guint64 aNanos)
+{
+    guint   bucket = 0;
+    guint64 bound  = METRICS_FIRST_BOUND_NS;
+
+    while ((bucket < KMS_DETECTIX_METRICS_BUCKETS - 1) && (aNanos >= bound))
+    {
+        bucket++;
+        bound <<= 1;
+    }
+
+    aHistogramPtr[bucket]++;
+
+    return;
+}
+
+
+const gchar * kms_detectix_metrics_segment_name(void)
+{
+    const gchar * name_ptr;
+
+    g_mutex_lock(&The_Metrics_Mutex);
+
+    name_ptr = The_Metrics_Name;
+
+    g_mutex_unlock(&The_Metrics_Mutex);
+
+    return name_ptr;
+}
+
+
+// ends file:  "kmsdetectixmetrics.c"
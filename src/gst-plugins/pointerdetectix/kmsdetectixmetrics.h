@@ -0,0 +1,123 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_METRICS_H_
+#define _KMS_DETECTIX_METRICS_H_
+
+#include <glib.h>
+#include <string.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Process-wide shared-memory segment with the counters of every instance.
+ *
+ * The segment is a KmsDetectixMetricsHeader and, from slots_offset on,
+ * slot_count slots of slot_size bytes, all in host byte order. It is named
+ * KMS_DETECTIX_METRICS_PREFIX and the process ID unless the environment
+ * variable DETECTIX_METRICS_SEGMENT names it, is created by the first
+ * instance and unlinked when the process exits. A segment of that name is
+ * only replaced when the process in its header is gone. Each instance owns
+ * one slot, keyed by its id, and is its only writer.
+ *
+ * A slot is published under a seqlock: the sequence is odd while the slot is
+ * written. A reader copies the slot between two reads of an even sequence and
+ * retries when they differ. Counters only grow while the slot is in use; a
+ * released slot is zeroed and may be taken by another instance.
+ */
+
+#define KMS_DETECTIX_METRICS_PREFIX     "/kms-pointerdetectix-"
+#define KMS_DETECTIX_METRICS_MAGIC      0x4D585444u     // "DTXM"
+#define KMS_DETECTIX_METRICS_VERSION    1
+#define KMS_DETECTIX_METRICS_SLOTS      512
+#define KMS_DETECTIX_METRICS_ID_SIZE    128
+#define KMS_DETECTIX_METRICS_BUCKETS    16              // the last one has no upper bound
+#define KMS_DETECTIX_METRICS_READ_ATTEMPTS  64
+
+typedef struct _KmsDetectixMetricsHeader
+{
+    guint32     magic;
+    guint32     version;
+    guint32     slot_count;
+    guint32     slot_size;
+    guint32     slots_offset;       // bytes from the start of the segment to the first slot
+    guint32     bucket_count;
+    guint32     pid;
+    guint32     reserved;
+    guint64     bucket_bounds_ns[KMS_DETECTIX_METRICS_BUCKETS];    // exclusive upper bound of each bucket
+
+} KmsDetectixMetricsHeader;
+
+
+typedef struct _KmsDetectixMetricsSlot
+{
+    guint32     sequence;           // seqlock --- odd while the slot is written
+    guint32     in_use;
+    gchar       id[KMS_DETECTIX_METRICS_ID_SIZE];   // NUL terminated
+    guint64     updated_ns;         // monotonic clock of the last write
+
+    guint64     frames;             // every frame processed
+    guint64     analyzed;           // frames searched for the pointer
+    guint64     skipped;            // frames the governor let through unanalyzed
+    guint64     found;              // analyses that found the pointer
+    guint64     window_in;          // window-in events
+    guint64     window_out;         // window-out events
+    guint64     moved;              // pointer-moved messages
+    guint32     level;              // degradation level of the last frame
+    guint32     scale_shift;
+
+    guint64     analysis_ns[KMS_DETECTIX_METRICS_BUCKETS];     // histogram of the analysis cost
+    guint64     frame_ns[KMS_DETECTIX_METRICS_BUCKETS];        // histogram of the whole frame
+
+} KmsDetectixMetricsSlot;
+
+
+/*
+ * consistent copy of a slot of a mapped segment, FALSE while it keeps changing --- inline,
+ * so scrapers only need this header and the segment
+ */
+static inline gboolean kms_detectix_metrics_read(const KmsDetectixMetricsSlot * aSlotPtr, KmsDetectixMetricsSlot * aCopyPtr)
+{
+    guint attempt;
+
+    for (attempt = 0; attempt < KMS_DETECTIX_METRICS_READ_ATTEMPTS; attempt++)
+    {
+        guint32 before = (guint32) g_atomic_int_get((const gint *) &aSlotPtr->sequence);
+
+        if ((before & 1) != 0)
+        {
+            g_thread_yield();
+            continue;
+        }
+
+        memcpy(aCopyPtr, (const void *) aSlotPtr, sizeof(*aCopyPtr));
+
+        // the copy must be complete before the sequence is read again
+        __sync_synchronize();
+
+        if ((guint32) g_atomic_int_get((const gint *) &aSlotPtr->sequence) == before)
+        {
+            aCopyPtr->id[KMS_DETECTIX_METRICS_ID_SIZE - 1] = '\0';
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_METRICS_IMPL_H_
+#define _KMS_DETECTIX_METRICS_IMPL_H_
+
+#include "kmsdetectixmetrics.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Writer side of the segment, used by the element only.
+ */
+
+// a zeroed slot of the segment, or NULL when shared memory is not available
+KmsDetectixMetricsSlot * kms_detectix_metrics_acquire(const gchar * aIdPtr);
+
+void kms_detectix_metrics_release(KmsDetectixMetricsSlot * aSlotPtr);
+
+/*
+ * the writer brackets every change with begin and end --- calls on one slot must not
+ * overlap, NULL slots are ignored
+ */
+void kms_detectix_metrics_begin(KmsDetectixMetricsSlot * aSlotPtr);
+
+void kms_detectix_metrics_end(KmsDetectixMetricsSlot * aSlotPtr);
+
+// inside begin and end
+void kms_detectix_metrics_set_id(KmsDetectixMetricsSlot * aSlotPtr, const gchar * aIdPtr);
+
+void kms_detectix_metrics_observe(guint64 * aHistogramPtr, guint64 aNanos);
+
+// name of the segment of this process, NULL until the first slot is acquired
+const gchar * kms_detectix_metrics_segment_name(void);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,288 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixoverlay.h"
+
+#include <string.h>
+
+
+#define OUTLINE_WIDTH       2           // pixels, as drawn into the frame by kms_detectix_cv_draw_rectangle
+#define OUTLINE_INACTIVE    0xFFFFFF    // RGB
+#define OUTLINE_ACTIVE      0x00FF00
+
+
+struct _KmsDetectixOverlay
+{
+    GPtrArray                   * buttons;          // layout the cache belongs to, a reference
+    GPtrArray                   * rectangles;       // inactive and active rectangle per button, NULL until shown
+    guint8                      * is_active;        // per button, as in composition
+    GstVideoOverlayComposition  * composition;
+};
+
+
+KmsDetectixOverlay * kms_detectix_overlay_new(void)
+{
+    return g_slice_new0(KmsDetectixOverlay);
+}
+
+
+void kms_detectix_overlay_reset(KmsDetectixOverlay * aOverlayPtr)
+{
+    guint index;
+
+    if (aOverlayPtr->composition != NULL)
+    {
+        gst_video_overlay_composition_unref(aOverlayPtr->composition);
+        aOverlayPtr->composition = NULL;
+    }
+
+    if (aOverlayPtr->rectangles != NULL)
+    {
+        for (index = 0; index < aOverlayPtr->rectangles->len; index++)
+        {
+            GstVideoOverlayRectangle * rectangle_ptr = g_ptr_array_index(aOverlayPtr->rectangles, index);
+
+            if (rectangle_ptr != NULL)
+            {
+                gst_video_overlay_rectangle_unref(rectangle_ptr);
+            }
+        }
+
+        g_ptr_array_unref(aOverlayPtr->rectangles);
+        aOverlayPtr->rectangles = NULL;
+    }
+
+    if (aOverlayPtr->buttons != NULL)
+    {
+        g_ptr_array_unref(aOverlayPtr->buttons);
+        aOverlayPtr->buttons = NULL;
+    }
+
+    g_free(aOverlayPtr->is_active);
+    aOverlayPtr->is_active = NULL;
+
+    return;
+}
+
+
+void kms_detectix_overlay_free(KmsDetectixOverlay * aOverlayPtr)
+{
+    if (aOverlayPtr == NULL)
+    {
+        return;
+    }
+
+    kms_detectix_overlay_reset(aOverlayPtr);
+
+    g_slice_free(KmsDetectixOverlay, aOverlayPtr);
+
+    return;
+}
+
+
+// BGRA in memory is the RGB composition format on little endian hosts, ARGB on big endian ones
+static void copy_pixel(guint8 * aDestPtr, const guint8 * aSourcePtr)
+{
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    memcpy(aDestPtr, aSourcePtr, 4);
+#else
+    aDestPtr[0] = aSourcePtr[3];
+    aDestPtr[1] = aSourcePtr[2];
+    aDestPtr[2] = aSourcePtr[1];
+    aDestPtr[3] = aSourcePtr[0];
+#endif
+}
+
+
+static GstBuffer * new_pixels(gint aWidth, gint aHeight)
+{
+    GstBuffer * buffer_ptr = gst_buffer_new_allocate(NULL, (gsize) aWidth * aHeight * 4, NULL);
+
+    gst_buffer_add_video_meta(buffer_ptr, GST_VIDEO_FRAME_FLAG_NONE, GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_RGB, aWidth, aHeight);
+
+    return buffer_ptr;
+}
+
+
+static GstBuffer * icon_pixels(const KmsDetectixImage * aIconPtr)
+{
+    GstBuffer  * buffer_ptr = new_pixels(aIconPtr->width, aIconPtr->height);
+    GstMapInfo   map;
+    gint         row, col;
+
+    gst_buffer_map(buffer_ptr, &map, GST_MAP_WRITE);
+
+    for (row = 0; row < aIconPtr->height; row++)
+    {
+        guint8       * dst_ptr = map.data + (gsize) row * aIconPtr->width * 4;
+        const guint8 * src_ptr = aIconPtr->data + (gsize) row * aIconPtr->stride;
+
+        for (col = 0; col < aIconPtr->width; col++, dst_ptr += 4, src_ptr += 4)
+        {
+            copy_pixel(dst_ptr, src_ptr);
+        }
+    }
+
+    gst_buffer_unmap(buffer_ptr, &map);
+
+    return buffer_ptr;
+}
+
+
+// transparent but for an opaque border, the way windows without icon are drawn into the frame
+static GstBuffer * outline_pixels(gint aWidth, gint aHeight, guint32 aColorRGB)
+{
+    GstBuffer  * buffer_ptr = new_pixels(aWidth, aHeight);
+    GstMapInfo   map;
+    guint8       color[4]   = { aColorRGB & 0xFF, (aColorRGB >> 8) & 0xFF, (aColorRGB >> 16) & 0xFF, 0xFF };
+    gint         row, col;
+
+    gst_buffer_map(buffer_ptr, &map, GST_MAP_WRITE);
+
+    memset(map.data, 0, map.size);
+
+    for (row = 0; row < aHeight; row++)
+    {
+        guint8   * dst_ptr   = map.data + (gsize) row * aWidth * 4;
+        gboolean   is_border = (row < OUTLINE_WIDTH) || (row >= aHeight - OUTLINE_WIDTH);
+
+        for (col = 0; col < aWidth; col++, dst_ptr += 4)
+        {
+            if (is_border || (col < OUTLINE_WIDTH) || (col >= aWidth - OUTLINE_WIDTH))
+            {
+                copy_pixel(dst_ptr, color);
+            }
+        }
+    }
+
+    gst_buffer_unmap(buffer_ptr, &map);
+
+    return buffer_ptr;
+}
+
+
+// drawn where the window is placed for the current caps, with its icons at that size
+static GstVideoOverlayRectangle * new_rectangle(const ButtonStruct * aButtonPtr, const WindowState * aStatePtr, gboolean aIsActive)
+{
+    const KmsDetectixImage   * icon_ptr      = (aIsActive && aStatePtr->active_icon) ? aStatePtr->active_icon : aStatePtr->inactive_icon;
+    GstVideoOverlayRectangle * rectangle_ptr;
+    GstBuffer                * buffer_ptr;
+    gint                       width;
+    gint                       height;
+
+    if (icon_ptr != NULL)
+    {
+        width      = icon_ptr->width;
+        height     = icon_ptr->height;
+        buffer_ptr = icon_pixels(icon_ptr);
+    }
+    else
+    {
+        width      = aStatePtr->rect.w;
+        height     = aStatePtr->rect.h;
+        buffer_ptr = outline_pixels(width, height, aIsActive ? OUTLINE_ACTIVE : OUTLINE_INACTIVE);
+    }
+
+    rectangle_ptr = gst_video_overlay_rectangle_new_raw(buffer_ptr, aStatePtr->rect.x, aStatePtr->rect.y,
+                                                        (guint) width, (guint) height, GST_VIDEO_OVERLAY_FORMAT_FLAG_NONE);
+
+    if (icon_ptr != NULL)
+    {
+        gst_video_overlay_rectangle_set_global_alpha(rectangle_ptr, (gfloat) (1.0 - CLAMP(aButtonPtr->transparency, 0.0, 1.0)));
+    }
+
+    gst_buffer_unref(buffer_ptr);
+
+    return rectangle_ptr;
+}
+
+
+GstVideoOverlayComposition * kms_detectix_overlay_compose(KmsDetectixOverlay * aOverlayPtr,
+                                                          GPtrArray          * aButtonsPtr,
+                                                          GArray             * aStatesPtr)
+{
+    gboolean is_changed = FALSE;
+    guint    index;
+
+    if (aButtonsPtr != aOverlayPtr->buttons)
+    {
+        kms_detectix_overlay_reset(aOverlayPtr);
+
+        aOverlayPtr->buttons    = g_ptr_array_ref(aButtonsPtr);
+        aOverlayPtr->rectangles = g_ptr_array_new();
+        aOverlayPtr->is_active  = g_new0(guint8, MAX(aButtonsPtr->len, 1));
+
+        g_ptr_array_set_size(aOverlayPtr->rectangles, (gint) aButtonsPtr->len * 2);
+
+        is_changed = TRUE;
+    }
+
+    if (aButtonsPtr->len == 0)
+    {
+        return NULL;
+    }
+
+    for (index = 0; index < aButtonsPtr->len; index++)
+    {
+        const WindowState * state_ptr = &g_array_index(aStatesPtr, WindowState, index);
+        guint8              is_active = (state_ptr->state == BUTTON_INSIDE) || (state_ptr->state == BUTTON_LEAVING);
+
+        if (is_active != aOverlayPtr->is_active[index])
+        {
+            aOverlayPtr->is_active[index] = is_active;
+            is_changed = TRUE;
+        }
+    }
+
+    if (! is_changed && (aOverlayPtr->composition != NULL))
+    {
+        return aOverlayPtr->composition;
+    }
+
+    if (aOverlayPtr->composition != NULL)
+    {
+        gst_video_overlay_composition_unref(aOverlayPtr->composition);
+        aOverlayPtr->composition = NULL;
+    }
+
+    for (index = 0; index < aButtonsPtr->len; index++)
+    {
+        guint                      slot          = index * 2 + aOverlayPtr->is_active[index];
+        GstVideoOverlayRectangle * rectangle_ptr = g_ptr_array_index(aOverlayPtr->rectangles, slot);
+
+        if (rectangle_ptr == NULL)
+        {
+            rectangle_ptr = new_rectangle(g_ptr_array_index(aButtonsPtr, index), &g_array_index(aStatesPtr, WindowState, index),
+                                          aOverlayPtr->is_active[index]);
+
+            g_ptr_array_index(aOverlayPtr->rectangles, slot) = rectangle_ptr;
+        }
+
+        if (aOverlayPtr->composition == NULL)
+        {
+            aOverlayPtr->composition = gst_video_overlay_composition_new(rectangle_ptr);
+        }
+        else
+        {
+            gst_video_overlay_composition_add_rectangle(aOverlayPtr->composition, rectangle_ptr);
+        }
+    }
+
+    return aOverlayPtr->composition;
+}
+
+// ends file:  "kmsdetectixoverlay.c"
@@ -0,0 +1,57 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_OVERLAY_H_
+#define _KMS_DETECTIX_OVERLAY_H_
+
+#include <gst/video/video.h>
+
+#include "kmspointerdetectix.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Windows layout as a GstVideoOverlayComposition.
+ *
+ * One overlay rectangle per window and state is built the first time it
+ * is shown and kept until the layout changes. The composition itself only
+ * changes when a window enters or leaves, so consecutive frames usually
+ * share the same composition by reference. Windows are drawn as placed in
+ * their WindowState; a new placement must reset the cache. Owned by the
+ * streaming thread.
+ */
+
+typedef struct _KmsDetectixOverlay KmsDetectixOverlay;
+
+
+KmsDetectixOverlay * kms_detectix_overlay_new(void);
+
+void kms_detectix_overlay_free(KmsDetectixOverlay * aOverlayPtr);
+
+// drops every cached rectangle, e.g. when streaming stops
+void kms_detectix_overlay_reset(KmsDetectixOverlay * aOverlayPtr);
+
+/*
+ * composition of aButtonsPtr drawn as aStatesPtr says --- owned by the overlay,
+ * NULL when there is no window, valid until the next call
+ */
+GstVideoOverlayComposition * kms_detectix_overlay_compose(KmsDetectixOverlay * aOverlayPtr,
+                                                          GPtrArray          * aButtonsPtr,
+                                                          GArray             * aStatesPtr);
+
+G_END_DECLS
+
+#endif
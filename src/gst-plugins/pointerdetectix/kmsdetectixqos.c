@@ -0,0 +1,120 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixqos.h"
+
+
+#define QOS_STEP_MS         500     // reports need this long to act on the previous step
+#define QOS_RESTORE_MS      3000    // on time for this long, and as long since the last step, restores one level
+#define QOS_MAX_SCALE_SHIFT 3       // coarsest pyramid level the analysis runs on
+
+
+static const struct
+{
+    guint       scale_shift;    // added to the plan
+    guint       interval_ms;    // the plan's interval is at least this
+    gboolean    draws;
+
+} The_Qos_Levels[KMS_DETECTIX_QOS_MAX_LEVEL + 1] =
+{
+    { 0,   0, TRUE  },      // as planned
+    { 1,   0, TRUE  },      // half the resolution
+    { 2,   0, TRUE  },      // quarter of the resolution
+    { 2,  66, TRUE  },      // ~15 fps
+    { 2, 250, TRUE  },      // ~4 fps
+    { 2, 250, FALSE }       // no overlay either
+};
+
+
+void kms_detectix_qos_reset(KmsDetectixQos * aQosPtr)
+{
+    g_atomic_int_set(&aQosPtr->level, 0);
+
+    aQosPtr->changed_ns = 0;
+    aQosPtr->late_ns    = 0;
+
+    return;
+}
+
+
+gboolean kms_detectix_qos_update(KmsDetectixQos * aQosPtr, gdouble aProportion, GstClockTimeDiff aDiff, guint64 aNowNs)
+{
+    gint     level   = g_atomic_int_get(&aQosPtr->level);
+    gboolean is_late = (aDiff > 0) || (aProportion > 1.0);
+
+    if (is_late)
+    {
+        aQosPtr->late_ns = aNowNs;
+    }
+
+    // a step only shows in the reports once the frames it changed reach the sink
+    if ((aQosPtr->changed_ns != 0) && (aNowNs - aQosPtr->changed_ns < QOS_STEP_MS * G_GUINT64_CONSTANT(1000000)))
+    {
+        return FALSE;
+    }
+
+    if (is_late && (level < KMS_DETECTIX_QOS_MAX_LEVEL))
+    {
+        level++;
+    }
+    else if (! is_late && (level > 0) && (aNowNs - MAX(aQosPtr->late_ns, aQosPtr->changed_ns) >= QOS_RESTORE_MS * G_GUINT64_CONSTANT(1000000)))
+    {
+        level--;
+    }
+    else
+    {
+        return FALSE;
+    }
+
+    aQosPtr->changed_ns = aNowNs;
+
+    g_atomic_int_set(&aQosPtr->level, level);
+
+    return TRUE;
+}
+
+
+guint kms_detectix_qos_get_level(KmsDetectixQos * aQosPtr)
+{
+    return (guint) g_atomic_int_get(&aQosPtr->level);
+}
+
+
+void kms_detectix_qos_apply(guint aLevel, guint aMinRate, KmsDetectixGovernorPlan * aPlanPtr)
+{
+    guint   level       = MIN(aLevel, KMS_DETECTIX_QOS_MAX_LEVEL);
+    guint64 interval_ns = (guint64) The_Qos_Levels[level].interval_ms * G_GUINT64_CONSTANT(1000000);
+
+    aPlanPtr->scale_shift = MIN(aPlanPtr->scale_shift + The_Qos_Levels[level].scale_shift, QOS_MAX_SCALE_SHIFT);
+
+    if ((aMinRate > 0) && (interval_ns > G_GUINT64_CONSTANT(1000000000) / aMinRate))
+    {
+        interval_ns = G_GUINT64_CONSTANT(1000000000) / aMinRate;
+    }
+
+    aPlanPtr->interval_ns = MAX(aPlanPtr->interval_ns, interval_ns);
+
+    return;
+}
+
+
+gboolean kms_detectix_qos_draws(guint aLevel)
+{
+    return The_Qos_Levels[MIN(aLevel, KMS_DETECTIX_QOS_MAX_LEVEL)].draws;
+}
+
+// ends file:  "kmsdetectixqos.c"
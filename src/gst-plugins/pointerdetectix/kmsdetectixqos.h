@@ -0,0 +1,67 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_QOS_H_
+#define _KMS_DETECTIX_QOS_H_
+
+#include <gst/gst.h>
+
+#include "kmsdetectixgovernor.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Degradation driven by the QoS events of downstream.
+ *
+ * Where the governor shares a CPU budget between sessions, this reacts to
+ * one session's own video arriving late. While downstream reports late
+ * frames the analysis steps down one level at a time: first a coarser
+ * pyramid level, then a lower analysis rate, and last no overlay at all.
+ * Once the reports have been on time for a while it steps back up, one
+ * level at a time. Levels are applied on top of the governor plan and never
+ * go below the minimum analysis rate of the slot.
+ */
+
+#define KMS_DETECTIX_QOS_MAX_LEVEL  5
+
+typedef struct _KmsDetectixQos
+{
+    gint        level;          // atomic --- read by the streaming thread
+    guint64     changed_ns;     // monotonic time of the last step
+    guint64     late_ns;        // monotonic time of the last late report
+
+} KmsDetectixQos;
+
+
+void kms_detectix_qos_reset(KmsDetectixQos * aQosPtr);
+
+/*
+ * one QoS report, as in gst_event_parse_qos --- TRUE when the level changed;
+ * callers serialize updates, the level may be read meanwhile
+ */
+gboolean kms_detectix_qos_update(KmsDetectixQos * aQosPtr, gdouble aProportion, GstClockTimeDiff aDiff, guint64 aNowNs);
+
+guint kms_detectix_qos_get_level(KmsDetectixQos * aQosPtr);
+
+// aPlanPtr made cheaper as aLevel asks
+void kms_detectix_qos_apply(guint aLevel, guint aMinRate, KmsDetectixGovernorPlan * aPlanPtr);
+
+// FALSE when the overlay is neither drawn nor composed at aLevel
+gboolean kms_detectix_qos_draws(guint aLevel);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,186 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixrecorder.h"
+
+#include <gst/gst.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+
+#define RECORDER_MASK   (KMS_DETECTIX_RECORDER_FRAMES - 1)
+
+
+struct _KmsDetectixRecorder
+{
+    gint                ref_count;
+    guint64             num_frames;     // writer only
+    KmsDetectixFlight   ring[KMS_DETECTIX_RECORDER_FRAMES];
+};
+
+
+KmsDetectixRecorder * kms_detectix_recorder_new(void)
+{
+    KmsDetectixRecorder * recorder_ptr = g_new0(KmsDetectixRecorder, 1);
+
+    recorder_ptr->ref_count = 1;
+
+    return recorder_ptr;
+}
+
+
+KmsDetectixRecorder * kms_detectix_recorder_ref(KmsDetectixRecorder * aRecorderPtr)
+{
+    g_atomic_int_inc(&aRecorderPtr->ref_count);
+
+    return aRecorderPtr;
+}
+
+
+void kms_detectix_recorder_unref(KmsDetectixRecorder * aRecorderPtr)
+{
+    if ((aRecorderPtr != NULL) && g_atomic_int_dec_and_test(&aRecorderPtr->ref_count))
+    {
+        g_free(aRecorderPtr);
+    }
+
+    return;
+}
+
+
+void kms_detectix_recorder_add(KmsDetectixRecorder * aRecorderPtr, const KmsDetectixFlight * aFlightPtr)
+{
+    KmsDetectixFlight * entry_ptr = &aRecorderPtr->ring[aRecorderPtr->num_frames & RECORDER_MASK];
+    guint32             sequence  = entry_ptr->sequence;
+
+    g_atomic_int_set((gint *) &entry_ptr->sequence, (gint) (sequence + 1));
+
+    // no write of the entry may be seen before the odd sequence
+    __sync_synchronize();
+
+    memcpy((guint8 *) entry_ptr + sizeof(entry_ptr->sequence),
+           (const guint8 *) aFlightPtr + sizeof(aFlightPtr->sequence),
+           sizeof(*entry_ptr) - sizeof(entry_ptr->sequence));
+
+    entry_ptr->frame = ++aRecorderPtr->num_frames;
+
+    __sync_synchronize();
+
+    g_atomic_int_set((gint *) &entry_ptr->sequence, (gint) (sequence + 2));
+
+    return;
+}
+
+
+static gint compare_frames(gconstpointer aLeftPtr, gconstpointer aRightPtr)
+{
+    guint64 left  = ((const KmsDetectixFlight *) aLeftPtr)->frame;
+    guint64 right = ((const KmsDetectixFlight *) aRightPtr)->frame;
+
+    return (left < right) ? -1 : (left > right);
+}
+
+
+guint kms_detectix_recorder_snapshot(KmsDetectixRecorder * aRecorderPtr, KmsDetectixFlight * aFlightsPtr)
+{
+    guint count = 0;
+    guint index;
+
+    // entries the writer is in, or overwrites while copied, are left out
+    for (index = 0; index < KMS_DETECTIX_RECORDER_FRAMES; index++)
+    {
+        const KmsDetectixFlight * entry_ptr = &aRecorderPtr->ring[index];
+        guint32                   before    = (guint32) g_atomic_int_get((const gint *) &entry_ptr->sequence);
+
+        if ((before == 0) || ((before & 1) != 0))
+        {
+            continue;
+        }
+
+        memcpy(&aFlightsPtr[count], entry_ptr, sizeof(*entry_ptr));
+
+        __sync_synchronize();
+
+        if ((guint32) g_atomic_int_get((const gint *) &entry_ptr->sequence) == before)
+        {
+            count++;
+        }
+    }
+
+    qsort(aFlightsPtr, count, sizeof(*aFlightsPtr), compare_frames);
+
+    return count;
+}
+
+
+gboolean kms_detectix_recorder_dump(KmsDetectixRecorder * aRecorderPtr, const gchar * aPathPtr)
+{
+    KmsDetectixFlight * flights_ptr = g_new(KmsDetectixFlight, KMS_DETECTIX_RECORDER_FRAMES);
+    guint               count       = kms_detectix_recorder_snapshot(aRecorderPtr, flights_ptr);
+    FILE              * file_ptr    = g_fopen(aPathPtr, "w");
+    gboolean            is_ok       = (file_ptr != NULL);
+    guint               index;
+
+    if (is_ok)
+    {
+        fprintf(file_ptr, "frame,pts,start_ns,total_ns,analysis_ns,overlay_ns,posting_ns,analyzed,found,branch,slow,"
+                          "level,qos,scale,roi_width,roi_height,blobs,window_in,window_out,moved\n");
+
+        for (index = 0; index < count; index++)
+        {
+            const KmsDetectixFlight * flight_ptr = &flights_ptr[index];
+
+            fprintf(file_ptr, "%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%u,%u,%u,%u,%d,%d,%d,%d,"
+                              "%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+                    flight_ptr->frame,
+                    flight_ptr->pts,
+                    flight_ptr->start_ns,
+                    flight_ptr->analysis_ns + flight_ptr->overlay_ns + flight_ptr->posting_ns,
+                    flight_ptr->analysis_ns,
+                    flight_ptr->overlay_ns,
+                    flight_ptr->posting_ns,
+                    (flight_ptr->flags & KMS_DETECTIX_FLIGHT_ANALYZED) != 0,
+                    (flight_ptr->flags & KMS_DETECTIX_FLIGHT_FOUND) != 0,
+                    (flight_ptr->flags & KMS_DETECTIX_FLIGHT_BRANCH) != 0,
+                    (flight_ptr->flags & KMS_DETECTIX_FLIGHT_SLOW) != 0,
+                    flight_ptr->level,
+                    flight_ptr->qos_level,
+                    flight_ptr->scale_shift,
+                    flight_ptr->roi_width,
+                    flight_ptr->roi_height,
+                    flight_ptr->blobs,
+                    flight_ptr->window_in,
+                    flight_ptr->window_out,
+                    flight_ptr->moved);
+        }
+
+        is_ok = (fclose(file_ptr) == 0);
+    }
+
+    if (! is_ok)
+    {
+        GST_WARNING ("flight record not written to %s", aPathPtr);
+    }
+
+    g_free(flights_ptr);
+
+    return is_ok;
+}
+
+// ends file:  "kmsdetectixrecorder.c"
@@ -0,0 +1,94 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_RECORDER_H_
+#define _KMS_DETECTIX_RECORDER_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Flight recorder of the most recent frames.
+ *
+ * A fixed ring of KMS_DETECTIX_RECORDER_FRAMES entries, one per processed
+ * frame, with the time spent in each stage and what the frame decided. The
+ * streaming thread is the only writer and never waits: each entry carries a
+ * sequence that is odd while it is written, and readers on any thread keep
+ * only the entries they copied between two reads of the same even sequence.
+ * A dump is the ring as it was around the moment it was asked for, oldest
+ * frame first, written as CSV.
+ */
+
+#define KMS_DETECTIX_RECORDER_FRAMES    4096    // a power of two
+
+typedef enum
+{
+    KMS_DETECTIX_FLIGHT_ANALYZED    = 1 << 0,   // searched for the pointer, else skipped by the governor
+    KMS_DETECTIX_FLIGHT_FOUND       = 1 << 1,
+    KMS_DETECTIX_FLIGHT_BRANCH      = 1 << 2,   // analyzed on the tee branch
+    KMS_DETECTIX_FLIGHT_SLOW        = 1 << 3    // over the latency threshold
+
+} KmsDetectixFlightFlags;
+
+
+typedef struct _KmsDetectixFlight
+{
+    guint32     sequence;       // odd while written, set by the recorder
+    guint32     flags;          // KmsDetectixFlightFlags
+    guint64     frame;          // counted from 1 by the recorder
+    guint64     pts;
+    guint64     start_ns;       // monotonic clock when the frame came in
+    guint32     analysis_ns;
+    guint32     overlay_ns;
+    guint32     posting_ns;
+    guint16     roi_width;      // area searched, frame pixels
+    guint16     roi_height;
+    guint16     blobs;          // components in the pointer mask
+    guint8      level;          // governor degradation level
+    guint8      qos_level;      // degradation asked by downstream QoS
+    guint8      scale_shift;
+    guint8      window_in;      // events of this frame
+    guint8      window_out;
+    guint8      moved;
+
+} KmsDetectixFlight;
+
+
+typedef struct _KmsDetectixRecorder KmsDetectixRecorder;
+
+
+KmsDetectixRecorder * kms_detectix_recorder_new(void);
+
+KmsDetectixRecorder * kms_detectix_recorder_ref(KmsDetectixRecorder * aRecorderPtr);
+
+void kms_detectix_recorder_unref(KmsDetectixRecorder * aRecorderPtr);
+
+// one writer --- sequence and frame of aFlightPtr are filled in by the recorder
+void kms_detectix_recorder_add(KmsDetectixRecorder * aRecorderPtr, const KmsDetectixFlight * aFlightPtr);
+
+/*
+ * any thread --- copies up to KMS_DETECTIX_RECORDER_FRAMES entries into aFlightsPtr,
+ * oldest first, and returns how many
+ */
+guint kms_detectix_recorder_snapshot(KmsDetectixRecorder * aRecorderPtr, KmsDetectixFlight * aFlightsPtr);
+
+// any thread --- a snapshot written to aPathPtr, FALSE with a warning when it cannot be written
+gboolean kms_detectix_recorder_dump(KmsDetectixRecorder * aRecorderPtr, const gchar * aPathPtr);
+
+G_END_DECLS
+
+#endif
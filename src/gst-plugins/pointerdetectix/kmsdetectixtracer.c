@@ -0,0 +1,183 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixtracer.h"
+#include "kmspointerdetectix.h"
+
+
+static gint The_Num_Tracers = 0;     // atomic --- live tracer instances
+
+
+gboolean kms_detectix_tracer_is_active(void)
+{
+    return g_atomic_int_get(&The_Num_Tracers) > 0;
+}
+
+
+#if GST_CHECK_VERSION(1, 8, 0)
+
+#include <gst/gsttracer.h>
+#include <gst/gsttracerrecord.h>
+
+
+typedef struct _KmsDetectixTracer
+{
+    GstTracer   parent;
+
+} KmsDetectixTracer;
+
+
+typedef struct _KmsDetectixTracerClass
+{
+    GstTracerClass  parent_class;
+
+} KmsDetectixTracerClass;
+
+
+G_DEFINE_TYPE (KmsDetectixTracer, kms_detectix_tracer, GST_TYPE_TRACER);
+
+
+static GstTracerRecord * The_Record = NULL;
+
+
+static KmsPointerDetectix * detectix_of_pad(GstPad * aPadPtr, GstPadDirection aDirection)
+{
+    GstObject * parent_ptr = (aPadPtr != NULL) ? GST_OBJECT_PARENT (aPadPtr) : NULL;
+
+    if ((parent_ptr == NULL) || (GST_PAD_DIRECTION (aPadPtr) != aDirection) || ! KMS_IS_POINTER_DETECTOR (parent_ptr))
+    {
+        return NULL;
+    }
+
+    return KMS_POINTER_DETECTOR (parent_ptr);
+}
+
+
+/*
+ * a buffer enters the element when its upstream peer pushes it, and has been fully
+ * handled once the element pushes it on --- both on the streaming thread of the element
+ */
+static void on_pad_push_pre(GObject * aTracerPtr, GstClockTime aTs, GstPad * aPadPtr, GstBuffer * aBufferPtr)
+{
+    KmsPointerDetectix * detectix_ptr = detectix_of_pad(GST_PAD_PEER (aPadPtr), GST_PAD_SINK);
+    KmsDetectixTimings * timings_ptr;
+    GstClockTime         pts;
+    gchar              * name_ptr;
+
+    if (detectix_ptr != NULL)
+    {
+        kms_pointer_detectix_get_timings(detectix_ptr)->entry_ts = aTs;
+        return;
+    }
+
+    if ((detectix_ptr = detectix_of_pad(aPadPtr, GST_PAD_SRC)) == NULL)
+    {
+        return;
+    }
+
+    timings_ptr = kms_pointer_detectix_get_timings(detectix_ptr);
+    pts         = GST_BUFFER_PTS (aBufferPtr);
+
+    if (! GST_CLOCK_TIME_IS_VALID (timings_ptr->entry_ts))
+    {
+        return;
+    }
+
+    name_ptr = gst_object_get_name(GST_OBJECT (detectix_ptr));
+
+    // phases timed on another frame, i.e. on the branch, are not this buffer's
+    if (timings_ptr->pts == pts)
+    {
+        gst_tracer_record_log(The_Record, name_ptr, pts, aTs - timings_ptr->entry_ts,
+                              timings_ptr->analysis_ns, timings_ptr->overlay_ns, timings_ptr->posting_ns);
+    }
+    else
+    {
+        gst_tracer_record_log(The_Record, name_ptr, pts, aTs - timings_ptr->entry_ts,
+                              (guint64) 0, (guint64) 0, (guint64) 0);
+    }
+
+    timings_ptr->entry_ts = GST_CLOCK_TIME_NONE;
+
+    g_free(name_ptr);
+
+    return;
+}
+
+
+static GstStructure * new_field(GType aType, const gchar * aDescriptionPtr)
+{
+    return gst_structure_new("value",
+                             "type",        G_TYPE_GTYPE,                 aType,
+                             "related-to",  GST_TYPE_TRACER_VALUE_SCOPE,  GST_TRACER_VALUE_SCOPE_ELEMENT,
+                             "description", G_TYPE_STRING,                aDescriptionPtr,
+                             NULL);
+}
+
+
+static void kms_detectix_tracer_finalize(GObject * aObjectPtr)
+{
+    g_atomic_int_add(&The_Num_Tracers, -1);
+
+    G_OBJECT_CLASS (kms_detectix_tracer_parent_class)->finalize(aObjectPtr);
+
+    return;
+}
+
+
+static void kms_detectix_tracer_class_init(KmsDetectixTracerClass * aClassPtr)
+{
+    G_OBJECT_CLASS (aClassPtr)->finalize = kms_detectix_tracer_finalize;
+
+    The_Record = gst_tracer_record_new("detectixlatency.class",
+                                       "element",     GST_TYPE_STRUCTURE, new_field(G_TYPE_STRING, "pointerdetectix element"),
+                                       "pts",         GST_TYPE_STRUCTURE, new_field(G_TYPE_UINT64, "buffer PTS"),
+                                       "time",        GST_TYPE_STRUCTURE, new_field(G_TYPE_UINT64, "ns from the push in to the push out"),
+                                       "analysis",    GST_TYPE_STRUCTURE, new_field(G_TYPE_UINT64, "ns finding the pointer and updating the windows"),
+                                       "overlay",     GST_TYPE_STRUCTURE, new_field(G_TYPE_UINT64, "ns drawing, composing and attaching meta"),
+                                       "posting",     GST_TYPE_STRUCTURE, new_field(G_TYPE_UINT64, "ns posting window and pointer messages"),
+                                       NULL);
+
+    return;
+}
+
+
+static void kms_detectix_tracer_init(KmsDetectixTracer * aTracerPtr)
+{
+    gst_tracing_register_hook(GST_TRACER (aTracerPtr), "pad-push-pre", G_CALLBACK (on_pad_push_pre));
+
+    g_atomic_int_inc(&The_Num_Tracers);
+
+    return;
+}
+
+
+gboolean kms_detectix_tracer_register(GstPlugin * aPluginPtr)
+{
+    return gst_tracer_register(aPluginPtr, "detectixlatency", kms_detectix_tracer_get_type());
+}
+
+#else
+
+gboolean kms_detectix_tracer_register(GstPlugin * aPluginPtr)
+{
+    return FALSE;
+}
+
+#endif
+
+// ends file:  "kmsdetectixtracer.c"
@@ -0,0 +1,51 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_TRACER_H_
+#define _KMS_DETECTIX_TRACER_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/*
+ * detectixlatency, a GstTracer loaded with GST_TRACERS=detectixlatency and logged to
+ * GST_TRACER at level 7 --- for every buffer through a pointerdetectix element, the time
+ * from its push into the element to the push out of it, with the PTS and the share spent
+ * in analysis, overlay and message posting. The element only times its phases while a
+ * tracer is active; frames analyzed on the branch report their total with empty phases.
+ */
+
+typedef struct _KmsDetectixTimings
+{
+    GstClockTime    entry_ts;       // set by the tracer when the buffer is pushed in
+    GstClockTime    pts;            // frame the phases below were timed on
+    guint64         analysis_ns;
+    guint64         overlay_ns;     // drawing, composition and meta
+    guint64         posting_ns;
+
+} KmsDetectixTimings;
+
+
+// FALSE and a no-op before GStreamer 1.8, which made GstTracer public
+gboolean kms_detectix_tracer_register(GstPlugin * aPluginPtr);
+
+// one atomic read, for the element to skip the extra timestamps while nothing traces
+gboolean kms_detectix_tracer_is_active(void);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,152 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "kmsdetectixtracker.h"
+
+
+#define TRACKER_ALPHA           0.7     // position gain
+#define TRACKER_BETA            0.377   // velocity gain, Benedict-Bordner for alpha 0.7
+#define TRACKER_MAX_MISSES      3       // analyses without pointer before the lock is lost
+#define TRACKER_MIN_MARGIN      48      // pixels around the predicted pointer
+#define TRACKER_MAX_SPEED       8000.0  // pixels per second, filters out jumps between blobs
+
+#define NANOS_PER_SEC           1000000000.0
+
+#define ROUND_TO_INT(value)     ((gint) ((value) < 0.0 ? (value) - 0.5 : (value) + 0.5))
+
+
+void kms_detectix_tracker_reset(KmsDetectixTracker * aTrackerPtr)
+{
+    aTrackerPtr->is_locked  = FALSE;
+    aTrackerPtr->num_misses = 0;
+    aTrackerPtr->x          = 0.0;
+    aTrackerPtr->y          = 0.0;
+    aTrackerPtr->vx         = 0.0;
+    aTrackerPtr->vy         = 0.0;
+    aTrackerPtr->size       = 0;
+    aTrackerPtr->last_ns    = 0;
+
+    return;
+}
+
+
+void kms_detectix_tracker_update(KmsDetectixTracker * aTrackerPtr, gboolean aFound, gint aX, gint aY, gint aSize, guint64 aTimeNs)
+{
+    gdouble dt;
+    gdouble residual_x;
+    gdouble residual_y;
+
+    if (! aFound)
+    {
+        if (++aTrackerPtr->num_misses > TRACKER_MAX_MISSES)
+        {
+            kms_detectix_tracker_reset(aTrackerPtr);
+        }
+
+        return;
+    }
+
+    if ((! aTrackerPtr->is_locked) || (aTimeNs <= aTrackerPtr->last_ns))
+    {
+        aTrackerPtr->is_locked = TRUE;
+        aTrackerPtr->x         = aX;
+        aTrackerPtr->y         = aY;
+        aTrackerPtr->vx        = 0.0;
+        aTrackerPtr->vy        = 0.0;
+    }
+    else
+    {
+        dt = (aTimeNs - aTrackerPtr->last_ns) / NANOS_PER_SEC;
+
+        residual_x = aX - (aTrackerPtr->x + aTrackerPtr->vx * dt);
+        residual_y = aY - (aTrackerPtr->y + aTrackerPtr->vy * dt);
+
+        aTrackerPtr->x += aTrackerPtr->vx * dt + TRACKER_ALPHA * residual_x;
+        aTrackerPtr->y += aTrackerPtr->vy * dt + TRACKER_ALPHA * residual_y;
+
+        aTrackerPtr->vx = CLAMP(aTrackerPtr->vx + TRACKER_BETA * residual_x / dt, -TRACKER_MAX_SPEED, TRACKER_MAX_SPEED);
+        aTrackerPtr->vy = CLAMP(aTrackerPtr->vy + TRACKER_BETA * residual_y / dt, -TRACKER_MAX_SPEED, TRACKER_MAX_SPEED);
+    }
+
+    aTrackerPtr->num_misses = 0;
+    aTrackerPtr->size       = aSize;
+    aTrackerPtr->last_ns    = aTimeNs;
+
+    return;
+}
+
+
+gboolean kms_detectix_tracker_predict(const KmsDetectixTracker * aTrackerPtr, guint64 aTimeNs, gint * aXPtr, gint * aYPtr)
+{
+    gdouble dt;
+
+    if (! aTrackerPtr->is_locked)
+    {
+        return FALSE;
+    }
+
+    dt = (aTimeNs > aTrackerPtr->last_ns) ? (aTimeNs - aTrackerPtr->last_ns) / NANOS_PER_SEC : 0.0;
+
+    *aXPtr = ROUND_TO_INT(aTrackerPtr->x + aTrackerPtr->vx * dt);
+    *aYPtr = ROUND_TO_INT(aTrackerPtr->y + aTrackerPtr->vy * dt);
+
+    return TRUE;
+}
+
+
+/*
+ * FALSE when the whole frame must be searched --- otherwise the window is centered
+ * on the predicted pointer and grows with its speed and with every missed analysis
+ */
+gboolean kms_detectix_tracker_search_window(const KmsDetectixTracker * aTrackerPtr,
+                                            guint64                    aTimeNs,
+                                            gint                       aWidth,
+                                            gint                       aHeight,
+                                            GstVideoRectangle        * aWindowPtr)
+{
+    gint    x, y, left, top, right, bottom;
+    gdouble dt;
+    gint    margin;
+
+    if (! kms_detectix_tracker_predict(aTrackerPtr, aTimeNs, &x, &y))
+    {
+        return FALSE;
+    }
+
+    dt     = (aTimeNs > aTrackerPtr->last_ns) ? (aTimeNs - aTrackerPtr->last_ns) / NANOS_PER_SEC : 0.0;
+    margin = MAX(TRACKER_MIN_MARGIN, aTrackerPtr->size);
+    margin = margin * (1 + aTrackerPtr->num_misses) + (gint) (MAX(ABS(aTrackerPtr->vx), ABS(aTrackerPtr->vy)) * dt);
+
+    left   = MAX(0, x - margin);
+    top    = MAX(0, y - margin);
+    right  = MIN(aWidth,  x + margin);
+    bottom = MIN(aHeight, y + margin);
+
+    if ((right <= left) || (bottom <= top) || (((right - left) * 2 > aWidth) && ((bottom - top) * 2 > aHeight)))
+    {
+        return FALSE;
+    }
+
+    aWindowPtr->x = left;
+    aWindowPtr->y = top;
+    aWindowPtr->w = right - left;
+    aWindowPtr->h = bottom - top;
+
+    return TRUE;
+}
+
+// ends file:  "kmsdetectixtracker.c"
@@ -0,0 +1,60 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _KMS_DETECTIX_TRACKER_H_
+#define _KMS_DETECTIX_TRACKER_H_
+
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Alpha-beta tracker of the pointer centroid.
+ *
+ * It predicts where the pointer will be after the pipeline latency, so
+ * window events can be raised ahead of time, and it keeps the search
+ * window of the next analysis around the predicted position.
+ */
+
+typedef struct _KmsDetectixTracker
+{
+    gboolean    is_locked;      // a recent measurement exists
+    guint       num_misses;     // analyses in a row without pointer
+    gdouble     x;              // filtered centroid, frame coordinates
+    gdouble     y;
+    gdouble     vx;             // pixels per second
+    gdouble     vy;
+    gint        size;           // largest side of the last pointer bounds
+    guint64     last_ns;        // stream time of the last measurement
+
+} KmsDetectixTracker;
+
+
+void kms_detectix_tracker_reset(KmsDetectixTracker * aTrackerPtr);
+
+void kms_detectix_tracker_update(KmsDetectixTracker * aTrackerPtr, gboolean aFound, gint aX, gint aY, gint aSize, guint64 aTimeNs);
+
+gboolean kms_detectix_tracker_predict(const KmsDetectixTracker * aTrackerPtr, guint64 aTimeNs, gint * aXPtr, gint * aYPtr);
+
+gboolean kms_detectix_tracker_search_window(const KmsDetectixTracker * aTrackerPtr,
+                                            guint64                    aTimeNs,
+                                            gint                       aWidth,
+                                            gint                       aHeight,
+                                            GstVideoRectangle        * aWindowPtr);
+
+G_END_DECLS
+
+#endif
@@ -22,11 +22,22 @@
 #endif
 
 #include "kmspointerdetectix.h"
+#include "kmsdetectixgovernor.h"
+#include "kmsdetectixtracker.h"
+#include "kmsdetectixmetaimpl.h"
+#include "kmsdetectixbranch.h"
+#include "kmsdetectixoverlay.h"
+#include "kmsdetectixkernels.h"
+#include "kmsdetectixcapture.h"
+#include "kmsdetectixmetricsimpl.h"
+#include "kmsdetectixrecorder.h"
+#include "kmsdetectixqos.h"
 
 #include <gst/gst.h>
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 #include <glib/gstdio.h>
+#include <libsoup/soup.h>
 
 
 GST_DEBUG_CATEGORY_STATIC   (kms_pointer_detectix_debug_category);
@@ -49,7 +60,27 @@ typedef enum
     e_PROP_WINDOWS_LAYOUT,
     e_PROP_MESSAGE,
     e_PROP_SHOW_WINDOWS_LAYOUT,
-    e_PROP_CALIBRATION_AREA
+    e_PROP_CALIBRATION_AREA,
+
+    e_PROP_PRIORITY,            // sessions with lower priority are degraded first
+    e_PROP_CPU_BUDGET,          // process-wide percent of all cores, 0 is unlimited
+    e_PROP_MIN_ANALYSIS_RATE,   // frames per second analyzed even when degraded
+    e_PROP_DEGRADATION,         // read-only --- current governor decisions
+    e_PROP_PREDICTION_LEAD,     // millis ahead of the frame used for window events
+    e_PROP_ENTER_FRAMES,        // analyses inside a window before window-in
+    e_PROP_EXIT_FRAMES,         // analyses outside a window before window-out
+    e_PROP_WINDOW_MARGIN,       // pixels the pointer may drift out of an entered window
+    e_PROP_POINTER_META,        // attach KmsDetectixMeta to every outgoing buffer
+    e_PROP_MOVED_RATE,          // max pointer-moved messages per second, 0 disables them
+    e_PROP_MOVED_DELTA,         // pixels the pointer must move before pointer-moved
+    e_PROP_BRANCH,              // analysis on a tee branch described by link and pads
+    e_PROP_READ_ONLY,           // passthrough with a read-only map when nothing is drawn
+    e_PROP_COMPOSITION,         // windows as GstVideoOverlayCompositionMeta, not drawn into the frame
+    e_PROP_CAPTURE,             // file recording frames, properties and messages for replay
+    e_PROP_METRICS_ID,          // key of the counters in the shared metrics segment
+    e_PROP_FLIGHT_THRESHOLD,    // millis a frame may take before the flight recorder is dumped
+    e_PROP_WINDOWS_ONLY,        // search only around the windows, for sessions that only want window events
+    e_PROP_COLOR_RANGE          // tracked color, as calibrated or as set
 
 } PLUGIN_PARAMS_e;
 
@@ -57,29 +88,136 @@ typedef enum
 enum
 {
     e_FIRST_SIGNAL = 0,
+    e_SIGNAL_CALIBRATE_COLOR = e_FIRST_SIGNAL,
+    e_SIGNAL_GET_PARAMS,
+    e_SIGNAL_SET_PARAMS,
+    e_SIGNAL_DUMP_FLIGHT_RECORD,
     e_FINAL_SIGNAL
 
 } PLUGIN_SIGNALS_e;
 
 
+static guint The_Plugin_Signals[e_FINAL_SIGNAL] = { 0 };
+
+
+/*
+ * everything the streaming thread reads from the control plane --- a snapshot is never
+ * modified once published: set_property builds a new one under the object lock and the
+ * streaming thread picks it up with one atomic load at the start of a frame
+ */
+typedef struct _ConfigStruct
+{
+    gint                    ref_count;
+    struct _ConfigStruct  * next_retired;         // replaced, waiting for the frame using it to end
+    GPtrArray             * buttons;              // ButtonStruct, shared until the layout changes
+    GstVideoRectangle       calibration_area;
+    gboolean                show_debug_info;
+    gboolean                show_windows_layout;
+    gboolean                put_message;
+    gboolean                put_meta;
+    gboolean                read_only;
+    gboolean                use_composition;
+    gboolean                windows_only;
+    guint                   prediction_lead_ms;
+    guint                   enter_frames;
+    guint                   exit_frames;
+    gint                    window_margin;
+    guint                   moved_rate;
+    guint                   moved_delta;
+    guint                   flight_threshold_ms;  // 0 never dumps on its own
+
+} ConfigStruct;
+
+
+/*
+ * typed values of wait, snap, link, pads and path --- parsed once when set,
+ * an invalid value is rejected with a note and the previous one is kept
+ */
+typedef struct _ParamsStruct
+{
+    guint       wait_ms;
+    guint       snap[3];        // millis interval, max num snaps, max num fails
+    gchar     * link[3];        // pipeline, producer and consumer names
+    gchar     * pads[3];        // producer out, consumer input and consumer out pads
+    gchar     * path;
+
+} ParamsStruct;
+
+
 typedef struct _KmsPointerDetectixPrivate
 {
-    gboolean     is_silent, show_debug_info, putMessage, show_windows_layout;
+    gboolean     is_silent;
     guint        num_buffs;
     guint        num_drops;
     guint        num_notes;
-    gchar        sz_wait[30],
-                 sz_snap[30],
-                 sz_link[90],
-                 sz_pads[90],
-                 sz_path[400],
-                 sz_note[200];
+    guint64      last_analysis_ns;
+    guint        scale_shift;
+    KmsDetectixGovernorSlot * governor_slot;
+    KmsDetectixQos          qos;                  // updated under the object lock, its level read by the frames
+
+    ConfigStruct          * config;               // atomic --- latest published snapshot
+    ConfigStruct          * retired;              // atomic --- lock-free list of replaced snapshots
+    gboolean                is_streaming;         // retired snapshots are only reclaimed by frames, the branch is only spliced then
+    ConfigStruct          * frame_config;         // streaming thread --- snapshot in use
+    GArray                * window_states;        // streaming thread --- WindowState per frame_config button
+    KmsDetectixLabels     * labels;               // streaming thread --- window_states rasterized with the margin
+    GArray                * regions;              // streaming thread --- GstVideoRectangle searched in windows-only mode
+    GstStructure          * windows_layout;       // as last set, returned by get_property
+    GMutex                  range_lock;           // color_range, set by the frames and by set_property
+    KmsDetectixColorRange   color_range;          // range_lock --- each analysis works on a copy
+    gint                    calibrate_pending;    // atomic --- calibrate on the next frame
+    KmsDetectixCv         * cv;                   // drawing and calibration in the caps layout
+    KmsDetectixAnalysis   * analysis;             // scratch arena, sized in set_info
+    KmsDetectixPointer      pointer;              // result of the most recent analysis
+    KmsDetectixTracker      tracker;
+    GstVideoRectangle       search_window;        // area analyzed in the most recent frame
+    gboolean                moved_pending;        // moved_sample is waiting for the rate limit
+    KmsDetectixPointer      moved_sample;         // latest analysis, replaces any unsent one
+    KmsDetectixPointer      moved_last;           // as last posted
+    guint64                 moved_last_ns;
+
+    GMutex                  analysis_lock;        // one analysis at a time, inline or on the branch
+    gint                    analysis_width;       // frame size the scratch images are allocated for
+    gint                    analysis_height;
+    GstVideoFormat          analysis_format;      // picks the kernel variants of the scratch images
+    GMutex                  branch_lock;          // serializes splice and unsplice
+    KmsDetectixBranch     * branch;               // analysis_lock --- NULL when analyzing inline
+    gint                    is_branch_flowing;    // atomic, set under analysis_lock --- the branch handed off a frame
+    gboolean                is_branch_wanted;     // as last set, returned by get_property
+    gboolean                copy_for_meta;        // streaming thread --- passthrough buffers still get the meta
+    KmsDetectixOverlay    * overlay;              // streaming thread --- cached windows composition
+    KmsDetectixCapture    * capture;              // any thread --- records only while a file is open
+    gchar                 * capture_path;         // as last set, returned by get_property
+    KmsDetectixTimings      timings;              // streaming thread --- phases of the last frame, while traced
+    GMutex                  metrics_lock;         // one writer of the slot at a time, the frame or set_metrics_id
+    KmsDetectixMetricsSlot * metrics;             // NULL without shared memory
+    gchar                 * metrics_id;           // as last set, returned by get_property
+    KmsDetectixRecorder   * recorder;             // any thread --- the streaming thread is its only writer
+    guint64                 flight_dump_ns;       // streaming thread --- start of the frame that last dumped
+    gint                    is_dumping;           // atomic --- an automatic dump is being written
+
+    ParamsStruct params;
+    gchar        sz_note[200];
 
 } KmsPointerDetectixPrivate;
 
 
-#define VIDEO_SRC_CAPS  GST_VIDEO_CAPS_MAKE("{ BGR }")
-#define VIDEO_SINK_CAPS GST_VIDEO_CAPS_MAKE("{ BGR }")
+// packed layouts with a kernel variant each, see layout_of_format
+#define VIDEO_SRC_CAPS  GST_VIDEO_CAPS_MAKE("{ BGR, BGRx, RGBx, RGBA, xRGB }")
+#define VIDEO_SINK_CAPS GST_VIDEO_CAPS_MAKE("{ BGR, BGRx, RGBx, RGBA, xRGB }")
+
+// a slow frame dumps the flight recorder at most this often, the ring refills in between
+#define FLIGHT_HOLDOFF_MS       10000
+
+// a pointer jittering on an edge must hold for a few analyses before it is reported
+#define DEFAULT_ENTER_FRAMES    2
+#define DEFAULT_EXIT_FRAMES     3
+#define DEFAULT_WINDOW_MARGIN   8
+#define DEFAULT_MOVED_DELTA     4
+
+// windows-only mode also searches this far beyond the window margin, so a pointer coming in is seen whole
+#define WINDOWS_ONLY_REACH      32
+#define WINDOWS_ONLY_REGIONS    16
 
 
 G_DEFINE_TYPE_WITH_CODE (KmsPointerDetectix,            \
@@ -130,278 +268,2741 @@ G_DEFINE_TYPE_WITH_CODE (KmsPointerDetectix,            \
         return 0;
     }
 
-#endif
+#endif
+
+
+static void initialize_plugin_instance(KmsPointerDetectix * aPluginPtr, KmsPointerDetectixPrivate * aPrivatePtr);
+static void set_branch (KmsPointerDetectix * pointerdetectix);
+
+
+static GstClock      * The_Sys_Clock_Ptr = NULL;
+static GstClockTime    The_Startup_Nanos = 0;
+
+
+static guint64 Get_Runtime_Nanosec()
+{
+    if (The_Sys_Clock_Ptr == NULL)
+    {
+        The_Sys_Clock_Ptr = gst_system_clock_obtain();
+
+        The_Startup_Nanos = gst_clock_get_time (The_Sys_Clock_Ptr);
+
+        g_printf("\n%s\n", THIS_PLUGIN_NAME);
+    }
+
+    GstClockTime  now_nanos = gst_clock_get_time( The_Sys_Clock_Ptr );
+
+    GstClockTime elapsed_ns = now_nanos -The_Startup_Nanos;
+
+    return (guint64) elapsed_ns;
+}
+
+
+static guint Get_Runtime_Millisec()
+{
+    #define  NANOS_PER_MILLISEC  ((guint64) (1000L * 1000L))
+
+    return (guint) (Get_Runtime_Nanosec() / NANOS_PER_MILLISEC);
+}
+
+
+static guint DBG_Print(const gchar * aTextPtr, gint aValue)
+{
+    guint elapsed_ms = Get_Runtime_Millisec();
+
+    if (aTextPtr != NULL)
+    {
+        g_printf("%-7d --- %s --- %s --- (%d)", elapsed_ms, THIS_PLUGIN_NAME, aTextPtr, aValue);
+    }
+
+    g_printf("\n");
+
+    return elapsed_ms;
+}
+
+
+static void free_button(ButtonStruct * aButtonPtr)
+{
+    g_free(aButtonPtr->id);
+
+    kms_detectix_image_unref(aButtonPtr->inactive_icon);
+    kms_detectix_image_unref(aButtonPtr->active_icon);
+    kms_detectix_image_unref(aButtonPtr->mask);
+
+    g_free(aButtonPtr->points);
+    g_free(aButtonPtr);
+
+    return;
+}
+
+
+static KmsDetectixImage * load_icon(const gchar * aUriPtr, gint aWidth, gint aHeight)
+{
+    KmsDetectixImage * image_ptr = NULL;
+
+    if (g_str_has_prefix(aUriPtr, "http://") || g_str_has_prefix(aUriPtr, "https://"))
+    {
+        SoupSession * session_ptr = soup_session_new();
+        SoupMessage * message_ptr = soup_message_new("GET", aUriPtr);
+
+        if ((message_ptr != NULL) && SOUP_STATUS_IS_SUCCESSFUL(soup_session_send_message(session_ptr, message_ptr)))
+        {
+            image_ptr = kms_detectix_image_decode((const guint8 *) message_ptr->response_body->data,
+                                                  (gsize) message_ptr->response_body->length,
+                                                  aWidth, aHeight);
+        }
+
+        g_clear_object(&message_ptr);
+        g_object_unref(session_ptr);
+    }
+    else
+    {
+        gchar * path_ptr  = g_str_has_prefix(aUriPtr, "file://") ? g_filename_from_uri(aUriPtr, NULL, NULL) : g_strdup(aUriPtr);
+        gchar * bytes_ptr = NULL;
+        gsize   length    = 0;
+
+        if ((path_ptr != NULL) && g_file_get_contents(path_ptr, &bytes_ptr, &length, NULL))
+        {
+            image_ptr = kms_detectix_image_decode((const guint8 *) bytes_ptr, length, aWidth, aHeight);
+
+            g_free(bytes_ptr);
+        }
+
+        g_free(path_ptr);
+    }
+
+    if (image_ptr == NULL)
+    {
+        GST_WARNING ("cannot load window image (%s)", aUriPtr);
+    }
+
+    return image_ptr;
+}
+
+
+/*
+ * position and size are frame pixels as ints, pixels of referenceWidth x referenceHeight
+ * when the window gives them, or fractions of the frame as doubles --- the last two
+ * follow the caps, so a layout survives a renegotiated resolution
+ */
+static gboolean parse_placement(const GstStructure * aWindowPtr, ButtonStruct * aButtonPtr)
+{
+    static const gchar * names[4] = { "upRightCornerX", "upRightCornerY", "width", "height" };
+
+    gint   * pixels_ptr[4] = { &aButtonPtr->layout.x, &aButtonPtr->layout.y, &aButtonPtr->layout.w, &aButtonPtr->layout.h };
+    gint     reference[2]  = { 0, 0 };
+    gboolean has_reference;
+    gint     index;
+
+    has_reference = gst_structure_get(aWindowPtr,
+                                      "referenceWidth",  G_TYPE_INT, &reference[0],
+                                      "referenceHeight", G_TYPE_INT, &reference[1],
+                                      NULL) && (reference[0] > 0) && (reference[1] > 0);
+
+    aButtonPtr->is_scalable = has_reference || (gst_structure_get_field_type(aWindowPtr, names[0]) == G_TYPE_DOUBLE);
+
+    for (index = 0; index < 4; index++)
+    {
+        if (aButtonPtr->is_scalable && ! has_reference)
+        {
+            if (! gst_structure_get_double(aWindowPtr, names[index], &aButtonPtr->placement[index]))
+            {
+                return FALSE;
+            }
+        }
+        else if (! gst_structure_get_int(aWindowPtr, names[index], pixels_ptr[index]))
+        {
+            return FALSE;
+        }
+        else if (has_reference)
+        {
+            aButtonPtr->placement[index] = (gdouble) *pixels_ptr[index] / reference[index % 2];
+        }
+    }
+
+    return TRUE;
+}
+
+
+/*
+ * the area of the window that is hit: its whole rectangle, the ellipse inscribed in it, a
+ * polygon of points given as fractions of it, or the opaque and bright pixels of a mask
+ * image stretched over it --- mask_uri, or the inactive image when there is none
+ */
+static gboolean parse_shape(const GstStructure * aWindowPtr, ButtonStruct * aButtonPtr)
+{
+    const gchar * shape_ptr = gst_structure_get_string(aWindowPtr, "shape");
+
+    if ((shape_ptr == NULL) || (g_strcmp0(shape_ptr, "rectangle") == 0))
+    {
+        aButtonPtr->shape = KMS_DETECTIX_SHAPE_RECTANGLE;
+    }
+    else if (g_strcmp0(shape_ptr, "ellipse") == 0)
+    {
+        aButtonPtr->shape = KMS_DETECTIX_SHAPE_ELLIPSE;
+    }
+    else if (g_strcmp0(shape_ptr, "polygon") == 0)
+    {
+        const GValue * points_ptr = gst_structure_get_value(aWindowPtr, "points");
+        guint          num_values = ((points_ptr != NULL) && GST_VALUE_HOLDS_ARRAY(points_ptr)) ? gst_value_array_get_size(points_ptr) : 0;
+        guint          index;
+
+        if ((num_values < 6) || ((num_values % 2) != 0))
+        {
+            return FALSE;
+        }
+
+        aButtonPtr->shape      = KMS_DETECTIX_SHAPE_POLYGON;
+        aButtonPtr->points     = g_new(gdouble, num_values);
+        aButtonPtr->num_points = num_values / 2;
+
+        for (index = 0; index < num_values; index++)
+        {
+            const GValue * value_ptr = gst_value_array_get_value(points_ptr, index);
+
+            if (G_VALUE_HOLDS_DOUBLE(value_ptr))
+            {
+                aButtonPtr->points[index] = g_value_get_double(value_ptr);
+            }
+            else if (G_VALUE_HOLDS_FLOAT(value_ptr))
+            {
+                aButtonPtr->points[index] = g_value_get_float(value_ptr);
+            }
+            else
+            {
+                return FALSE;
+            }
+        }
+    }
+    else if (g_strcmp0(shape_ptr, "mask") == 0)
+    {
+        const gchar * uri_ptr = gst_structure_get_string(aWindowPtr, "mask_uri");
+
+        if (uri_ptr == NULL)
+        {
+            uri_ptr = gst_structure_get_string(aWindowPtr, "inactive_uri");
+        }
+
+        aButtonPtr->mask  = (uri_ptr != NULL) ? load_icon(uri_ptr, aButtonPtr->is_scalable ? 0 : aButtonPtr->layout.w,
+                                                           aButtonPtr->is_scalable ? 0 : aButtonPtr->layout.h)
+                                              : NULL;
+        aButtonPtr->shape = (aButtonPtr->mask != NULL) ? KMS_DETECTIX_SHAPE_MASK : KMS_DETECTIX_SHAPE_RECTANGLE;
+
+        if (aButtonPtr->mask == NULL)
+        {
+            GST_WARNING ("window (%s) has no mask, its whole rectangle is hit", aButtonPtr->id);
+        }
+    }
+    else
+    {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/*
+ * builds the list of windows from the layout structure --- icons are downloaded
+ * and decoded here, so callers must not hold the object lock
+ */
+static GPtrArray * parse_windows_layout(const GstStructure * aLayoutPtr)
+{
+    GPtrArray * buttons_ptr = g_ptr_array_new_with_free_func((GDestroyNotify) free_button);
+    gint        index;
+
+    for (index = 0; (aLayoutPtr != NULL) && (index < gst_structure_n_fields(aLayoutPtr)); index++)
+    {
+        const gchar        * name_ptr  = gst_structure_nth_field_name(aLayoutPtr, index);
+        const GValue       * value_ptr = gst_structure_get_value(aLayoutPtr, name_ptr);
+        const GstStructure * window_ptr;
+        ButtonStruct       * button_ptr;
+        gchar              * uri_ptr = NULL;
+
+        if (! GST_VALUE_HOLDS_STRUCTURE(value_ptr))
+        {
+            GST_WARNING ("window (%s) is not a structure", name_ptr);
+            continue;
+        }
+
+        window_ptr = gst_value_get_structure(value_ptr);
+        button_ptr = g_new0(ButtonStruct, 1);
+
+        if (! gst_structure_get(window_ptr, "id", G_TYPE_STRING, &button_ptr->id, NULL) ||
+            ! parse_placement(window_ptr, button_ptr))
+        {
+            GST_WARNING ("window (%s) lacks position, size or id", name_ptr);
+            free_button(button_ptr);
+            continue;
+        }
+
+        if (! parse_shape(window_ptr, button_ptr))
+        {
+            GST_WARNING ("window (%s) has an unknown shape, or a polygon without three points", name_ptr);
+            free_button(button_ptr);
+            continue;
+        }
+
+        if (! gst_structure_get_double(window_ptr, "transparency", &button_ptr->transparency))
+        {
+            button_ptr->transparency = 0.0;
+        }
+
+        if (gst_structure_get(window_ptr, "inactive_uri", G_TYPE_STRING, &uri_ptr, NULL))
+        {
+            button_ptr->inactive_icon = load_icon(uri_ptr, button_ptr->is_scalable ? 0 : button_ptr->layout.w,
+                                                  button_ptr->is_scalable ? 0 : button_ptr->layout.h);
+            g_free(uri_ptr);
+        }
+
+        if (gst_structure_get(window_ptr, "active_uri", G_TYPE_STRING, &uri_ptr, NULL))
+        {
+            button_ptr->active_icon = load_icon(uri_ptr, button_ptr->is_scalable ? 0 : button_ptr->layout.w,
+                                                button_ptr->is_scalable ? 0 : button_ptr->layout.h);
+            g_free(uri_ptr);
+        }
+
+        g_ptr_array_add(buttons_ptr, button_ptr);
+    }
+
+    return buttons_ptr;
+}
+
+
+/*
+ * messages are recorded as the frame produces them but posted by the caller of process_frame
+ * once the analysis lock is released --- a sync handler on the bus may set properties
+ */
+static void queue_message(KmsPointerDetectix * pointerdetectix, GPtrArray ** aPostsPtr, GstStructure * aStructurePtr)
+{
+    kms_detectix_capture_message(pointerdetectix->priv->capture, aStructurePtr);
+
+    if (*aPostsPtr == NULL)
+    {
+        *aPostsPtr = g_ptr_array_new();
+    }
+
+    g_ptr_array_add(*aPostsPtr, gst_message_new_element(GST_OBJECT (pointerdetectix), aStructurePtr));
+
+    return;
+}
+
+
+static void post_messages(KmsPointerDetectix * pointerdetectix, GPtrArray * aPostsPtr)
+{
+    guint index;
+
+    if (aPostsPtr == NULL)
+    {
+        return;
+    }
+
+    for (index = 0; index < aPostsPtr->len; index++)
+    {
+        gst_element_post_message(GST_ELEMENT (pointerdetectix), g_ptr_array_index(aPostsPtr, index));
+    }
+
+    g_ptr_array_unref(aPostsPtr);
+
+    return;
+}
+
+
+static void queue_window_message(KmsPointerDetectix * pointerdetectix, GPtrArray ** aPostsPtr, const gchar * aTypePtr, const gchar * aWindowIdPtr)
+{
+    queue_message(pointerdetectix, aPostsPtr, gst_structure_new(aTypePtr, "window", G_TYPE_STRING, aWindowIdPtr, NULL));
+
+    return;
+}
+
+
+static void add_window_event(GPtrArray ** aIdsPtr, const gchar * aWindowIdPtr)
+{
+    if (*aIdsPtr == NULL)
+    {
+        *aIdsPtr = g_ptr_array_new_with_free_func(g_free);
+    }
+
+    g_ptr_array_add(*aIdsPtr, g_strdup(aWindowIdPtr));
+
+    return;
+}
+
+
+/*
+ * every window debounces the pointer on its own: it is entered after enter-frames
+ * analyses hitting it, and left after exit-frames analyses missing it grown by the
+ * margin --- the windows hit come from one load of the label map, in layout order ---
+ * returns the ids of the windows just left and just entered, to be posted unlocked
+ */
+static void update_windows(KmsPointerDetectixPrivate * aPrivatePtr, gboolean aFound, gint aX, gint aY,
+                           GPtrArray ** aLeftIdsPtr, GPtrArray ** aEnteredIdsPtr)
+{
+    const ConfigStruct * config_ptr  = aPrivatePtr->frame_config;
+    const guint32      * entries_ptr = NULL;
+    guint                num_entries = 0;
+    guint                next_entry  = 0;
+    guint                index;
+
+    if (aFound && (aPrivatePtr->labels != NULL))
+    {
+        num_entries = kms_detectix_labels_hit(aPrivatePtr->labels, aX, aY, &entries_ptr);
+    }
+
+    for (index = 0; index < config_ptr->buttons->len; index++)
+    {
+        ButtonStruct * button_ptr = g_ptr_array_index(config_ptr->buttons, index);
+        WindowState  * state_ptr  = &g_array_index(aPrivatePtr->window_states, WindowState, index);
+        gboolean       was_inside = (state_ptr->state == BUTTON_INSIDE) || (state_ptr->state == BUTTON_LEAVING);
+        gboolean       is_hit     = FALSE;
+
+        // within the margin only, an entered window is still hit
+        if ((next_entry < num_entries) && ((entries_ptr[next_entry] >> 1) == index))
+        {
+            is_hit = ((entries_ptr[next_entry] & 1) != 0) || was_inside;
+            next_entry++;
+        }
+
+        switch (state_ptr->state)
+        {
+            case BUTTON_OUTSIDE:
+            case BUTTON_ENTERING:
+                if (! is_hit)
+                {
+                    state_ptr->state = BUTTON_OUTSIDE;
+                }
+                else if ((state_ptr->state == BUTTON_OUTSIDE) && (config_ptr->enter_frames > 1))
+                {
+                    state_ptr->state      = BUTTON_ENTERING;
+                    state_ptr->num_frames = 1;
+                }
+                else if ((state_ptr->state == BUTTON_OUTSIDE) || (++state_ptr->num_frames >= config_ptr->enter_frames))
+                {
+                    state_ptr->state = BUTTON_INSIDE;
+                    add_window_event(aEnteredIdsPtr, button_ptr->id);
+                }
+                break;
+
+            case BUTTON_INSIDE:
+            case BUTTON_LEAVING:
+                if (is_hit)
+                {
+                    state_ptr->state = BUTTON_INSIDE;
+                }
+                else if ((state_ptr->state == BUTTON_INSIDE) && (config_ptr->exit_frames > 1))
+                {
+                    state_ptr->state      = BUTTON_LEAVING;
+                    state_ptr->num_frames = 1;
+                }
+                else if ((state_ptr->state == BUTTON_INSIDE) || (++state_ptr->num_frames >= config_ptr->exit_frames))
+                {
+                    state_ptr->state = BUTTON_OUTSIDE;
+                    add_window_event(aLeftIdsPtr, button_ptr->id);
+                }
+                break;
+        }
+    }
+
+    return;
+}
+
+
+static void clear_window_state(WindowState * aStatePtr)
+{
+    kms_detectix_image_unref(aStatePtr->inactive_icon);
+    kms_detectix_image_unref(aStatePtr->active_icon);
+    kms_detectix_image_unref(aStatePtr->mask);
+
+    return;
+}
+
+
+// a new layout keeps the state of the windows it shares with the old one, so no event is repeated
+static GArray * keep_window_states(GPtrArray * aOldButtonsPtr, GArray * aOldStatesPtr, GPtrArray * aNewButtonsPtr)
+{
+    GArray * states_ptr = g_array_sized_new(FALSE, TRUE, sizeof(WindowState), aNewButtonsPtr->len);
+    guint    old_index;
+    guint    new_index;
+
+    g_array_set_clear_func(states_ptr, (GDestroyNotify) clear_window_state);
+    g_array_set_size(states_ptr, aNewButtonsPtr->len);
+
+    for (new_index = 0; (aOldButtonsPtr != NULL) && (new_index < aNewButtonsPtr->len); new_index++)
+    {
+        const ButtonStruct * new_ptr = g_ptr_array_index(aNewButtonsPtr, new_index);
+
+        for (old_index = 0; old_index < aOldButtonsPtr->len; old_index++)
+        {
+            const ButtonStruct * old_ptr = g_ptr_array_index(aOldButtonsPtr, old_index);
+
+            if (g_strcmp0(old_ptr->id, new_ptr->id) == 0)
+            {
+                const WindowState * old_state_ptr = &g_array_index(aOldStatesPtr, WindowState, old_index);
+                WindowState       * new_state_ptr = &g_array_index(states_ptr, WindowState, new_index);
+
+                new_state_ptr->state      = old_state_ptr->state;
+                new_state_ptr->num_frames = old_state_ptr->num_frames;
+                break;
+            }
+        }
+    }
+
+    return states_ptr;
+}
+
+
+static ConfigStruct * config_ref(ConfigStruct * aConfigPtr)
+{
+    g_atomic_int_inc(&aConfigPtr->ref_count);
+
+    return aConfigPtr;
+}
+
+
+static void config_unref(ConfigStruct * aConfigPtr)
+{
+    if ((aConfigPtr != NULL) && g_atomic_int_dec_and_test(&aConfigPtr->ref_count))
+    {
+        g_ptr_array_unref(aConfigPtr->buttons);
+        g_slice_free(ConfigStruct, aConfigPtr);
+    }
+
+    return;
+}
+
+
+// the copy shares the buttons of the original, set_property replaces them when the layout changes
+static ConfigStruct * config_copy(const ConfigStruct * aConfigPtr)
+{
+    ConfigStruct * config_ptr = g_slice_dup(ConfigStruct, aConfigPtr);
+
+    config_ptr->ref_count    = 1;
+    config_ptr->next_retired = NULL;
+    config_ptr->buttons      = g_ptr_array_ref(aConfigPtr->buttons);
+
+    return config_ptr;
+}
+
+
+static void reclaim_configs(KmsPointerDetectixPrivate * aPrivatePtr)
+{
+    ConfigStruct * retired_ptr;
+
+    do
+    {
+        retired_ptr = g_atomic_pointer_get(&aPrivatePtr->retired);
+    }
+    while ((retired_ptr != NULL) && ! g_atomic_pointer_compare_and_exchange(&aPrivatePtr->retired, retired_ptr, NULL));
+
+    while (retired_ptr != NULL)
+    {
+        ConfigStruct * next_ptr = retired_ptr->next_retired;
+
+        config_unref(retired_ptr);
+
+        retired_ptr = next_ptr;
+    }
+
+    return;
+}
+
+
+/*
+ * called with the object lock held, so publishers never race each other --- the replaced
+ * snapshot may still be in use by the current frame, the streaming thread reclaims it later.
+ * Stopped, it is reclaimed here unless a branch is spliced: set_branch and the handoff read
+ * the branch under analysis_lock, so a branch seen as NULL after the new snapshot is set
+ * can only pick up the new one
+ */
+static void publish_config(KmsPointerDetectixPrivate * aPrivatePtr, ConfigStruct * aConfigPtr)
+{
+    ConfigStruct * old_ptr = g_atomic_pointer_get(&aPrivatePtr->config);
+    ConfigStruct * head_ptr;
+
+    g_atomic_pointer_set(&aPrivatePtr->config, aConfigPtr);
+
+    do
+    {
+        head_ptr = g_atomic_pointer_get(&aPrivatePtr->retired);
+        old_ptr->next_retired = head_ptr;
+    }
+    while (! g_atomic_pointer_compare_and_exchange(&aPrivatePtr->retired, head_ptr, old_ptr));
+
+    if (! aPrivatePtr->is_streaming && (g_atomic_pointer_get(&aPrivatePtr->branch) == NULL))
+    {
+        reclaim_configs(aPrivatePtr);
+    }
+
+    return;
+}
+
+
+static gboolean intersect_rects(const GstVideoRectangle * aLeftPtr, const GstVideoRectangle * aRightPtr, GstVideoRectangle * aRectPtr)
+{
+    gint left   = MAX(aLeftPtr->x, aRightPtr->x);
+    gint top    = MAX(aLeftPtr->y, aRightPtr->y);
+    gint right  = MIN(aLeftPtr->x + aLeftPtr->w, aRightPtr->x + aRightPtr->w);
+    gint bottom = MIN(aLeftPtr->y + aLeftPtr->h, aRightPtr->y + aRightPtr->h);
+
+    if ((right <= left) || (bottom <= top))
+    {
+        return FALSE;
+    }
+
+    aRectPtr->x = left;
+    aRectPtr->y = top;
+    aRectPtr->w = right - left;
+    aRectPtr->h = bottom - top;
+
+    return TRUE;
+}
+
+
+static void unite_rects(GstVideoRectangle * aRectPtr, const GstVideoRectangle * aOtherPtr)
+{
+    gint right  = MAX(aRectPtr->x + aRectPtr->w, aOtherPtr->x + aOtherPtr->w);
+    gint bottom = MAX(aRectPtr->y + aRectPtr->h, aOtherPtr->y + aOtherPtr->h);
+
+    aRectPtr->x = MIN(aRectPtr->x, aOtherPtr->x);
+    aRectPtr->y = MIN(aRectPtr->y, aOtherPtr->y);
+    aRectPtr->w = right  - aRectPtr->x;
+    aRectPtr->h = bottom - aRectPtr->y;
+
+    return;
+}
+
+
+/*
+ * the areas windows-only mode searches: every placed window grown by its margin and the
+ * reach, clipped to the frame --- overlapping areas are merged, so no pixel is classified
+ * twice, and too many of them collapse into their bounding box
+ */
+static void place_regions(KmsPointerDetectixPrivate * aPrivatePtr)
+{
+    GstVideoRectangle frame_rect = { 0, 0, aPrivatePtr->analysis_width, aPrivatePtr->analysis_height };
+    gint              reach      = aPrivatePtr->frame_config->window_margin + WINDOWS_ONLY_REACH;
+    gboolean          is_merged;
+    guint             index;
+    guint             other;
+
+    g_array_set_size(aPrivatePtr->regions, 0);
+
+    for (index = 0; index < aPrivatePtr->window_states->len; index++)
+    {
+        const GstVideoRectangle * rect_ptr = &g_array_index(aPrivatePtr->window_states, WindowState, index).rect;
+        GstVideoRectangle         grown    = { rect_ptr->x - reach, rect_ptr->y - reach, rect_ptr->w + 2 * reach, rect_ptr->h + 2 * reach };
+        GstVideoRectangle         region;
+
+        if (intersect_rects(&grown, &frame_rect, &region))
+        {
+            g_array_append_val(aPrivatePtr->regions, region);
+        }
+    }
+
+    do
+    {
+        is_merged = FALSE;
+
+        for (index = 0; ! is_merged && (index < aPrivatePtr->regions->len); index++)
+        {
+            for (other = index + 1; ! is_merged && (other < aPrivatePtr->regions->len); other++)
+            {
+                GstVideoRectangle * region_ptr = &g_array_index(aPrivatePtr->regions, GstVideoRectangle, index);
+                GstVideoRectangle * other_ptr  = &g_array_index(aPrivatePtr->regions, GstVideoRectangle, other);
+                GstVideoRectangle   common;
+
+                if (intersect_rects(region_ptr, other_ptr, &common))
+                {
+                    unite_rects(region_ptr, other_ptr);
+                    g_array_remove_index_fast(aPrivatePtr->regions, other);
+                    is_merged = TRUE;
+                }
+            }
+        }
+    }
+    while (is_merged);
+
+    if (aPrivatePtr->regions->len > WINDOWS_ONLY_REGIONS)
+    {
+        for (index = 1; index < aPrivatePtr->regions->len; index++)
+        {
+            unite_rects(&g_array_index(aPrivatePtr->regions, GstVideoRectangle, 0),
+                        &g_array_index(aPrivatePtr->regions, GstVideoRectangle, index));
+        }
+
+        g_array_set_size(aPrivatePtr->regions, 1);
+    }
+
+    return;
+}
+
+
+/*
+ * the placed windows rasterized once into the label map, and the regions searched in
+ * windows-only mode, again whenever the layout, the frame size or the margin change ---
+ * with the analysis lock held
+ */
+static void build_labels(KmsPointerDetectixPrivate * aPrivatePtr)
+{
+    GPtrArray        * buttons_ptr = aPrivatePtr->frame_config->buttons;
+    KmsDetectixShape * shapes_ptr  = g_new0(KmsDetectixShape, MAX(1, buttons_ptr->len));
+    guint              index;
+
+    for (index = 0; index < buttons_ptr->len; index++)
+    {
+        const ButtonStruct * button_ptr = g_ptr_array_index(buttons_ptr, index);
+        const WindowState  * state_ptr  = &g_array_index(aPrivatePtr->window_states, WindowState, index);
+        KmsDetectixShape   * shape_ptr  = &shapes_ptr[index];
+
+        shape_ptr->type       = button_ptr->shape;
+        shape_ptr->rect       = state_ptr->rect;
+        shape_ptr->points     = button_ptr->points;
+        shape_ptr->num_points = button_ptr->num_points;
+
+        if (state_ptr->mask != NULL)
+        {
+            shape_ptr->mask        = state_ptr->mask->data;
+            shape_ptr->mask_stride = state_ptr->mask->stride;
+        }
+    }
+
+    kms_detectix_labels_free(aPrivatePtr->labels);
+
+    aPrivatePtr->labels = kms_detectix_labels_new(aPrivatePtr->analysis_width, aPrivatePtr->analysis_height,
+                                                  shapes_ptr, buttons_ptr->len, aPrivatePtr->frame_config->window_margin);
+
+    g_free(shapes_ptr);
+
+    place_regions(aPrivatePtr);
+
+    return;
+}
+
+
+/*
+ * the windows of the frame layout on frames of the analysis size, with the analysis lock held ---
+ * icons of scalable windows are resized from the decoded image, never downloaded or decoded again
+ */
+static void place_windows(KmsPointerDetectixPrivate * aPrivatePtr)
+{
+    GPtrArray * buttons_ptr = aPrivatePtr->frame_config->buttons;
+    gint        width       = aPrivatePtr->analysis_width;
+    gint        height      = aPrivatePtr->analysis_height;
+    guint       index;
+
+    for (index = 0; index < buttons_ptr->len; index++)
+    {
+        const ButtonStruct * button_ptr = g_ptr_array_index(buttons_ptr, index);
+        WindowState        * state_ptr  = &g_array_index(aPrivatePtr->window_states, WindowState, index);
+        GstVideoRectangle  * rect_ptr   = &state_ptr->rect;
+
+        if (button_ptr->is_scalable)
+        {
+            rect_ptr->x = (gint) (button_ptr->placement[0] * width  + 0.5);
+            rect_ptr->y = (gint) (button_ptr->placement[1] * height + 0.5);
+            rect_ptr->w = MAX(1, (gint) (button_ptr->placement[2] * width  + 0.5));
+            rect_ptr->h = MAX(1, (gint) (button_ptr->placement[3] * height + 0.5));
+        }
+        else
+        {
+            *rect_ptr = button_ptr->layout;
+        }
+
+        clear_window_state(state_ptr);
+
+        state_ptr->inactive_icon = kms_detectix_image_scale(button_ptr->inactive_icon, rect_ptr->w, rect_ptr->h);
+        state_ptr->active_icon   = kms_detectix_image_scale(button_ptr->active_icon,   rect_ptr->w, rect_ptr->h);
+        state_ptr->mask          = kms_detectix_image_scale(button_ptr->mask,          rect_ptr->w, rect_ptr->h);
+    }
+
+    build_labels(aPrivatePtr);
+
+    // cached overlay rectangles hold the previous placement
+    kms_detectix_overlay_reset(aPrivatePtr->overlay);
+
+    return;
+}
+
+
+/*
+ * streaming thread, once per frame --- retired snapshots are reclaimed before the load,
+ * so the one just loaded can not be freed until the next frame
+ */
+static const ConfigStruct * acquire_frame_config(KmsPointerDetectixPrivate * aPrivatePtr)
+{
+    ConfigStruct * config_ptr;
+
+    reclaim_configs(aPrivatePtr);
+
+    config_ptr = g_atomic_pointer_get(&aPrivatePtr->config);
+
+    if (config_ptr != aPrivatePtr->frame_config)
+    {
+        gboolean is_new_layout = (aPrivatePtr->frame_config == NULL) || (config_ptr->buttons != aPrivatePtr->frame_config->buttons);
+        gboolean is_new_margin = (aPrivatePtr->frame_config != NULL) && (config_ptr->window_margin != aPrivatePtr->frame_config->window_margin);
+
+        if (is_new_layout)
+        {
+            GArray * states_ptr = keep_window_states((aPrivatePtr->frame_config != NULL) ? aPrivatePtr->frame_config->buttons : NULL,
+                                                     aPrivatePtr->window_states,
+                                                     config_ptr->buttons);
+
+            if (aPrivatePtr->window_states != NULL)
+            {
+                g_array_unref(aPrivatePtr->window_states);
+            }
+
+            aPrivatePtr->window_states = states_ptr;
+        }
+
+        config_unref(aPrivatePtr->frame_config);
+
+        aPrivatePtr->frame_config = config_ref(config_ptr);
+
+        if (is_new_layout)
+        {
+            place_windows(aPrivatePtr);
+        }
+        else if (is_new_margin)
+        {
+            build_labels(aPrivatePtr);
+        }
+    }
+
+    return aPrivatePtr->frame_config;
+}
+
+
+static void queue_moved_message(KmsPointerDetectix * pointerdetectix, GPtrArray ** aPostsPtr, const KmsDetectixPointer * aPointerPtr)
+{
+    GstStructure * structure_ptr = gst_structure_new("pointer-moved",
+                                                     "x",          G_TYPE_INT,     aPointerPtr->x,
+                                                     "y",          G_TYPE_INT,     aPointerPtr->y,
+                                                     "visible",    G_TYPE_BOOLEAN, aPointerPtr->found,
+                                                     "confidence", G_TYPE_DOUBLE,  aPointerPtr->confidence,
+                                                     NULL);
+
+    queue_message(pointerdetectix, aPostsPtr, structure_ptr);
+
+    return;
+}
+
+
+/*
+ * every analysis overwrites the sample, so a slow rate never queues stale positions
+ * --- a sample within moved_delta of the last posted one cancels the pending post
+ */
+static void offer_moved_sample(KmsPointerDetectixPrivate * aPrivatePtr, const KmsDetectixPointer * aPointerPtr)
+{
+    const KmsDetectixPointer * last_ptr = &aPrivatePtr->moved_last;
+    guint                      delta    = aPrivatePtr->frame_config->moved_delta;
+
+    if (aPrivatePtr->frame_config->moved_rate == 0)
+    {
+        aPrivatePtr->moved_pending = FALSE;
+        return;
+    }
+
+    aPrivatePtr->moved_sample  = *aPointerPtr;
+    aPrivatePtr->moved_pending = (aPointerPtr->found != last_ptr->found) ||
+                                 (aPointerPtr->found &&
+                                  ((ABS(aPointerPtr->x - last_ptr->x) > (gint) delta) ||
+                                   (ABS(aPointerPtr->y - last_ptr->y) > (gint) delta)));
+
+    return;
+}
+
+
+static gboolean take_moved_sample(KmsPointerDetectixPrivate * aPrivatePtr, guint64 aNowNs, KmsDetectixPointer * aPointerPtr)
+{
+    guint rate = aPrivatePtr->frame_config->moved_rate;
+
+    if ((! aPrivatePtr->moved_pending) || (rate == 0) ||
+        ((aPrivatePtr->moved_last_ns != 0) && (aNowNs - aPrivatePtr->moved_last_ns < GST_SECOND / rate)))
+    {
+        return FALSE;
+    }
+
+    aPrivatePtr->moved_pending = FALSE;
+    aPrivatePtr->moved_last    = aPrivatePtr->moved_sample;
+    aPrivatePtr->moved_last_ns = aNowNs;
+
+    *aPointerPtr = aPrivatePtr->moved_sample;
+
+    return TRUE;
+}
+
+
+static gchar ** get_active_windows(KmsPointerDetectixPrivate * aPrivatePtr)
+{
+    GPtrArray * buttons_ptr = aPrivatePtr->frame_config->buttons;
+    gchar    ** ids_ptr     = g_new0(gchar *, buttons_ptr->len + 1);
+    guint       num_ids     = 0;
+    guint       index;
+
+    for (index = 0; index < buttons_ptr->len; index++)
+    {
+        ButtonStruct * button_ptr = g_ptr_array_index(buttons_ptr, index);
+        WindowState  * state_ptr  = &g_array_index(aPrivatePtr->window_states, WindowState, index);
+
+        if ((state_ptr->state == BUTTON_INSIDE) || (state_ptr->state == BUTTON_LEAVING))
+        {
+            ids_ptr[num_ids++] = g_strdup(button_ptr->id);
+        }
+    }
+
+    return ids_ptr;
+}
+
+
+static gboolean shows_windows(const ConfigStruct * aConfigPtr)
+{
+    return aConfigPtr->show_windows_layout && (aConfigPtr->buttons->len > 0);
+}
+
+
+// the debug info changes every frame, it is always drawn into the pixels
+static gboolean needs_drawing(const ConfigStruct * aConfigPtr)
+{
+    return aConfigPtr->show_debug_info || (shows_windows(aConfigPtr) && ! aConfigPtr->use_composition);
+}
+
+
+static void draw_overlay(KmsPointerDetectixPrivate * aPrivatePtr, guint8 * aPixelsPtr, gint aStride, gint aWidth, gint aHeight)
+{
+    const ConfigStruct * config_ptr = aPrivatePtr->frame_config;
+    guint                index;
+
+    for (index = 0; config_ptr->show_windows_layout && ! config_ptr->use_composition && (index < config_ptr->buttons->len); index++)
+    {
+        ButtonStruct     * button_ptr = g_ptr_array_index(config_ptr->buttons, index);
+        WindowState      * state_ptr  = &g_array_index(aPrivatePtr->window_states, WindowState, index);
+        gboolean           is_active  = (state_ptr->state == BUTTON_INSIDE) || (state_ptr->state == BUTTON_LEAVING);
+        KmsDetectixImage * icon_ptr   = (is_active && state_ptr->active_icon) ? state_ptr->active_icon : state_ptr->inactive_icon;
+
+        if (icon_ptr != NULL)
+        {
+            kms_detectix_cv_draw_image(aPrivatePtr->cv, aPixelsPtr, aStride, aWidth, aHeight, icon_ptr,
+                                       state_ptr->rect.x, state_ptr->rect.y, button_ptr->transparency);
+        }
+        else
+        {
+            kms_detectix_cv_draw_rectangle(aPrivatePtr->cv, aPixelsPtr, aStride, aWidth, aHeight, &state_ptr->rect,
+                                           is_active ? 0x00FF00 : 0xFFFFFF);
+        }
+    }
+
+    if (config_ptr->show_debug_info)
+    {
+        kms_detectix_cv_draw_rectangle(aPrivatePtr->cv, aPixelsPtr, aStride, aWidth, aHeight, &config_ptr->calibration_area, 0x0000FF);
+        kms_detectix_cv_draw_rectangle(aPrivatePtr->cv, aPixelsPtr, aStride, aWidth, aHeight, &aPrivatePtr->search_window, 0xFFFF00);
+
+        if (aPrivatePtr->pointer.found)
+        {
+            kms_detectix_cv_draw_rectangle(aPrivatePtr->cv, aPixelsPtr, aStride, aWidth, aHeight, &aPrivatePtr->pointer.bounds, 0xFF0000);
+        }
+    }
+
+    return;
+}
+
+
+static void kms_pointer_detectix_calibrate_color (KmsPointerDetectix * pointerdetectix)
+{
+    KmsPointerDetectixPrivate * ptr_private = GET_PRIVATE_STRUCT_PTR (pointerdetectix);
+
+    DBG_Print( __func__, 0 );
+
+    kms_detectix_capture_action(ptr_private->capture, "calibrate-color");
+
+    g_atomic_int_set(&ptr_private->calibrate_pending, TRUE);
+
+    return;
+}
+
+
+// channels as B, G, R whatever the layout, like the range itself
+static GstStructure * color_range_to_structure(const KmsDetectixColorRange * aRangePtr)
+{
+    return gst_structure_new("color_range",
+                             "blue-min",  G_TYPE_INT, (gint) aRangePtr->low[0],
+                             "blue-max",  G_TYPE_INT, (gint) aRangePtr->high[0],
+                             "green-min", G_TYPE_INT, (gint) aRangePtr->low[1],
+                             "green-max", G_TYPE_INT, (gint) aRangePtr->high[1],
+                             "red-min",   G_TYPE_INT, (gint) aRangePtr->low[2],
+                             "red-max",   G_TYPE_INT, (gint) aRangePtr->high[2],
+                             NULL);
+}
+
+
+static gboolean color_range_from_structure(const GstStructure * aStructurePtr, KmsDetectixColorRange * aRangePtr)
+{
+    gint     values[6];
+    gint     index;
+
+    if ((aStructurePtr == NULL) ||
+        ! gst_structure_get(aStructurePtr,
+                            "blue-min",  G_TYPE_INT, &values[0],
+                            "blue-max",  G_TYPE_INT, &values[1],
+                            "green-min", G_TYPE_INT, &values[2],
+                            "green-max", G_TYPE_INT, &values[3],
+                            "red-min",   G_TYPE_INT, &values[4],
+                            "red-max",   G_TYPE_INT, &values[5],
+                            NULL))
+    {
+        return FALSE;
+    }
+
+    for (index = 0; index < 6; index += 2)
+    {
+        if ((values[index] < 0) || (values[index + 1] > 255) || (values[index] > values[index + 1]))
+        {
+            return FALSE;
+        }
+    }
+
+    for (index = 0; index < 3; index++)
+    {
+        aRangePtr->low[index]  = (guint8) values[index * 2];
+        aRangePtr->high[index] = (guint8) values[index * 2 + 1];
+    }
+
+    return TRUE;
+}
+
+
+// a calibration is recorded as its outcome, so a replay does not depend on when it ran
+static void capture_color_range(KmsPointerDetectixPrivate * aPrivatePtr, const KmsDetectixColorRange * aRangePtr)
+{
+    GValue value = G_VALUE_INIT;
+
+    if (! kms_detectix_capture_is_open(aPrivatePtr->capture))
+    {
+        return;
+    }
+
+    g_value_init(&value, GST_TYPE_STRUCTURE);
+    g_value_take_boxed(&value, color_range_to_structure(aRangePtr));
+
+    kms_detectix_capture_property(aPrivatePtr->capture, "color-range", &value);
+
+    g_value_unset(&value);
+
+    return;
+}
+
+
+/*
+ * properties a replay needs --- branch only changes where the analysis runs, metrics-id
+ * and flight-threshold only what is reported about it, and wait to path configure the
+ * frame saver and read back as name=value
+ */
+static gboolean is_captured(guint aPropId)
+{
+    return ((aPropId < e_PROP_WAIT) || (aPropId > e_PROP_PATH)) &&
+           (aPropId != e_PROP_CAPTURE) && (aPropId != e_PROP_BRANCH) &&
+           (aPropId != e_PROP_METRICS_ID) && (aPropId != e_PROP_FLIGHT_THRESHOLD);
+}
+
+
+// the slot is also written by the frames, so never under the object lock
+static void set_metrics_id(KmsPointerDetectixPrivate * aPrivatePtr, const gchar * aIdPtr)
+{
+    g_mutex_lock(&aPrivatePtr->metrics_lock);
+
+    kms_detectix_metrics_begin(aPrivatePtr->metrics);
+    kms_detectix_metrics_set_id(aPrivatePtr->metrics, aIdPtr);
+    kms_detectix_metrics_end(aPrivatePtr->metrics);
+
+    g_mutex_unlock(&aPrivatePtr->metrics_lock);
+
+    return;
+}
+
+
+// a new capture starts with every setting, later changes are recorded as they are set
+static void capture_properties(KmsPointerDetectix * pointerdetectix)
+{
+    GParamSpec ** specs_ptr;
+    guint         num_specs;
+    guint         index;
+
+    specs_ptr = g_object_class_list_properties(G_OBJECT_GET_CLASS (pointerdetectix), &num_specs);
+
+    for (index = 0; index < num_specs; index++)
+    {
+        GParamSpec * spec_ptr = specs_ptr[index];
+        GValue       value    = G_VALUE_INIT;
+
+        if ((spec_ptr->owner_type != KMS_TYPE_POINTER_DETECTOR) ||
+            ((spec_ptr->flags & G_PARAM_READWRITE) != G_PARAM_READWRITE) || ! is_captured(spec_ptr->param_id))
+        {
+            continue;
+        }
+
+        g_value_init(&value, spec_ptr->value_type);
+        g_object_get_property(G_OBJECT (pointerdetectix), spec_ptr->name, &value);
+
+        kms_detectix_capture_property(pointerdetectix->priv->capture, spec_ptr->name, &value);
+
+        g_value_unset(&value);
+    }
+
+    g_free(specs_ptr);
+
+    return;
+}
+
+
+static const gchar * The_Param_Names[] = { "wait", "snap", "link", "pads", "path", NULL };
+
+#define MAX_WAIT_MILLIS     600000
+
+
+static void clear_params(ParamsStruct * aParamsPtr)
+{
+    gint index;
+
+    for (index = 0; index < 3; index++)
+    {
+        g_free(aParamsPtr->link[index]);
+        g_free(aParamsPtr->pads[index]);
+
+        aParamsPtr->link[index] = NULL;
+        aParamsPtr->pads[index] = NULL;
+    }
+
+    g_free(aParamsPtr->path);
+    aParamsPtr->path = NULL;
+
+    return;
+}
+
+
+static void copy_params(ParamsStruct * aDestPtr, const ParamsStruct * aSourcePtr)
+{
+    gint index;
+
+    *aDestPtr = *aSourcePtr;
+
+    for (index = 0; index < 3; index++)
+    {
+        aDestPtr->link[index] = g_strdup(aSourcePtr->link[index]);
+        aDestPtr->pads[index] = g_strdup(aSourcePtr->pads[index]);
+    }
+
+    aDestPtr->path = g_strdup(aSourcePtr->path);
+
+    return;
+}
+
+
+static gboolean parse_uint(const gchar * aTextPtr, guint aMaxValue, guint * aValuePtr)
+{
+    gchar   * end_ptr = NULL;
+    guint64   value;
+
+    if ((aTextPtr == NULL) || ! g_ascii_isdigit(*aTextPtr))
+    {
+        return FALSE;
+    }
+
+    value = g_ascii_strtoull(aTextPtr, &end_ptr, 10);
+
+    if ((*end_ptr != '\0') || (value > aMaxValue))
+    {
+        return FALSE;
+    }
+
+    *aValuePtr = (guint) value;
+
+    return TRUE;
+}
+
+
+// names of elements and pads: letters, digits and _ - . : %
+static gboolean is_valid_name(const gchar * aTextPtr)
+{
+    const gchar * char_ptr;
+
+    if ((aTextPtr == NULL) || (*aTextPtr == '\0'))
+    {
+        return FALSE;
+    }
+
+    for (char_ptr = aTextPtr; *char_ptr != '\0'; char_ptr++)
+    {
+        if (! g_ascii_isalnum(*char_ptr) && (strchr("_-.:%", *char_ptr) == NULL))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+// exactly three comma separated items, each one checked by aIsValid
+static gboolean split_three(const gchar * aTextPtr, gchar ** aItemsPtr, gboolean (*aIsValid)(const gchar *))
+{
+    gchar  ** items_ptr = g_strsplit((aTextPtr != NULL) ? aTextPtr : "", ",", 4);
+    gboolean  is_ok     = (g_strv_length(items_ptr) == 3);
+    gint      index;
+
+    for (index = 0; is_ok && (index < 3); index++)
+    {
+        is_ok = aIsValid(g_strstrip(items_ptr[index]));
+    }
+
+    for (index = 0; is_ok && (index < 3); index++)
+    {
+        g_free(aItemsPtr[index]);
+        aItemsPtr[index] = g_strdup(items_ptr[index]);
+    }
+
+    g_strfreev(items_ptr);
+
+    return is_ok;
+}
+
+
+static gboolean is_valid_count(const gchar * aTextPtr)
+{
+    guint value;
+
+    return parse_uint(aTextPtr, G_MAXINT, &value);
+}
+
+
+/*
+ * parses one named value into aParamsPtr --- FALSE, with the reason in aNotePtr,
+ * when the name is unknown or the value is invalid, aParamsPtr is then unchanged
+ */
+static gboolean parse_param(ParamsStruct * aParamsPtr, const gchar * aNamePtr, const gchar * aTextPtr, gchar * aNotePtr, gsize aNoteSize)
+{
+    const gchar * expected_ptr = NULL;
+
+    if (g_strcmp0(aNamePtr, "wait") == 0)
+    {
+        if (! parse_uint(aTextPtr, MAX_WAIT_MILLIS, &aParamsPtr->wait_ms))
+        {
+            expected_ptr = "millis between 0 and 600000";
+        }
+    }
+    else if (g_strcmp0(aNamePtr, "snap") == 0)
+    {
+        gchar * items[3] = { NULL, NULL, NULL };
+        gint    index;
+
+        if (! split_three(aTextPtr, items, is_valid_count))
+        {
+            expected_ptr = "millisecInterval,maxNumSnaps,maxNumFails";
+        }
+
+        for (index = 0; index < 3; index++)
+        {
+            if (expected_ptr == NULL)
+            {
+                parse_uint(items[index], G_MAXINT, &aParamsPtr->snap[index]);
+            }
+
+            g_free(items[index]);
+        }
+    }
+    else if (g_strcmp0(aNamePtr, "link") == 0)
+    {
+        if (! split_three(aTextPtr, aParamsPtr->link, is_valid_name))
+        {
+            expected_ptr = "pipelineName,producerName,consumerName";
+        }
+    }
+    else if (g_strcmp0(aNamePtr, "pads") == 0)
+    {
+        if (! split_three(aTextPtr, aParamsPtr->pads, is_valid_name))
+        {
+            expected_ptr = "producerOut,consumerInput,consumerOut";
+        }
+    }
+    else if (g_strcmp0(aNamePtr, "path") == 0)
+    {
+        if ((aTextPtr == NULL) || ((g_strcmp0(aTextPtr, "auto") != 0) && (aTextPtr[0] != '/')))
+        {
+            expected_ptr = "auto or an absolute path";
+        }
+        else
+        {
+            g_free(aParamsPtr->path);
+            aParamsPtr->path = g_strdup(aTextPtr);
+        }
+    }
+    else
+    {
+        snprintf(aNotePtr, aNoteSize, "note=unknown parameter (%s)", aNamePtr);
+        return FALSE;
+    }
+
+    if (expected_ptr != NULL)
+    {
+        snprintf(aNotePtr, aNoteSize, "note=invalid %s (%s) --- expected %s", aNamePtr, aTextPtr ? aTextPtr : "", expected_ptr);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+// the value without the name= prefix, NULL for unknown names
+static gchar * format_param(const ParamsStruct * aParamsPtr, const gchar * aNamePtr)
+{
+    if (g_strcmp0(aNamePtr, "wait") == 0)
+    {
+        return g_strdup_printf("%u", aParamsPtr->wait_ms);
+    }
+
+    if (g_strcmp0(aNamePtr, "snap") == 0)
+    {
+        return g_strdup_printf("%u,%u,%u", aParamsPtr->snap[0], aParamsPtr->snap[1], aParamsPtr->snap[2]);
+    }
+
+    if (g_strcmp0(aNamePtr, "link") == 0)
+    {
+        return g_strdup_printf("%s,%s,%s", aParamsPtr->link[0], aParamsPtr->link[1], aParamsPtr->link[2]);
+    }
+
+    if (g_strcmp0(aNamePtr, "pads") == 0)
+    {
+        return g_strdup_printf("%s,%s,%s", aParamsPtr->pads[0], aParamsPtr->pads[1], aParamsPtr->pads[2]);
+    }
+
+    if (g_strcmp0(aNamePtr, "path") == 0)
+    {
+        return g_strdup(aParamsPtr->path);
+    }
+
+    return NULL;
+}
+
+
+/*
+ * every param and the note in one locked read --- the note is consumed as by get_property
+ */
+static GstStructure * kms_pointer_detectix_get_params (KmsPointerDetectix * pointerdetectix)
+{
+    KmsPointerDetectixPrivate * ptr_private   = GET_PRIVATE_STRUCT_PTR (pointerdetectix);
+    GstStructure              * structure_ptr = gst_structure_new_empty("params");
+    gint                        index;
+
+    DBG_Print( __func__, 0 );
+
+    GST_OBJECT_LOCK (pointerdetectix);
+
+    for (index = 0; The_Param_Names[index] != NULL; index++)
+    {
+        gchar * value_ptr = format_param(&ptr_private->params, The_Param_Names[index]);
+
+        gst_structure_set(structure_ptr, The_Param_Names[index], G_TYPE_STRING, value_ptr, NULL);
+
+        g_free(value_ptr);
+    }
+
+    gst_structure_set(structure_ptr, "note", G_TYPE_STRING, ptr_private->sz_note + strlen("note="), NULL);
+
+    strcpy(ptr_private->sz_note, "note=none");
+
+    GST_OBJECT_UNLOCK (pointerdetectix);
+
+    return structure_ptr;
+}
+
+
+/*
+ * all or nothing: the values are parsed into a copy, which replaces the params
+ * only when every one of them is valid
+ */
+static gboolean kms_pointer_detectix_set_params (KmsPointerDetectix * pointerdetectix, const GstStructure * aParamsPtr)
+{
+    KmsPointerDetectixPrivate * ptr_private = GET_PRIVATE_STRUCT_PTR (pointerdetectix);
+    ParamsStruct                params;
+    gboolean                    is_ok       = (aParamsPtr != NULL);
+    gint                        index;
+
+    DBG_Print( __func__, 0 );
+
+    GST_OBJECT_LOCK (pointerdetectix);
+
+    copy_params(&params, &ptr_private->params);
+
+    for (index = 0; is_ok && (index < gst_structure_n_fields(aParamsPtr)); index++)
+    {
+        const gchar * name_ptr  = gst_structure_nth_field_name(aParamsPtr, (guint) index);
+        const gchar * value_ptr = gst_structure_get_string(aParamsPtr, name_ptr);
+
+        if (value_ptr == NULL)
+        {
+            snprintf(ptr_private->sz_note, sizeof(ptr_private->sz_note), "note=parameter (%s) is not a string", name_ptr);
+            is_ok = FALSE;
+        }
+        else
+        {
+            is_ok = parse_param(&params, name_ptr, value_ptr, ptr_private->sz_note, sizeof(ptr_private->sz_note));
+        }
+    }
+
+    if (is_ok)
+    {
+        clear_params(&ptr_private->params);
+
+        ptr_private->params    = params;
+        ptr_private->num_buffs = 0;
+        ptr_private->num_drops = 0;
+        ptr_private->num_notes = 0;
+    }
+    else
+    {
+        clear_params(&params);
+
+        ptr_private->num_notes++;
+    }
+
+    GST_OBJECT_UNLOCK (pointerdetectix);
+
+    return is_ok;
+}
+
+
+static void kms_pointer_detectix_init (KmsPointerDetectix * pointerdetectix)
+{
+    The_Sys_Clock_Ptr = NULL;
+    DBG_Print( __func__, 0 );
+
+    initialize_plugin_instance(pointerdetectix, GET_PRIVATE_STRUCT_PTR (pointerdetectix));
+
+    return;
+}
+
+
+void kms_pointer_detectix_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec)
+{
+    const gchar * psz_now = NULL;
+
+    KmsPointerDetectix    * pointerdetectix = KMS_POINTER_DETECTOR (object);
+
+    KmsPointerDetectixPrivate * ptr_private = GET_PRIVATE_STRUCT_PTR (pointerdetectix);
+
+    GPtrArray * buttons_ptr = NULL;
+
+    ConfigStruct * config_ptr;
+
+    gboolean is_config = TRUE;
+
+    DBG_Print( __func__, (gint) prop_id );
+
+    if (prop_id == e_PROP_WINDOWS_LAYOUT)
+    {
+        buttons_ptr = parse_windows_layout(g_value_get_boxed (value));
+    }
+
+    GST_OBJECT_LOCK (pointerdetectix);
+
+    // the published snapshot is never touched, changes go to a copy published below
+    config_ptr = config_copy(ptr_private->config);
+
+    switch (prop_id) 
+    {
+        case e_PROP_SILENT:
+            ptr_private->is_silent = g_value_get_boolean(value);
+            psz_now = ptr_private->is_silent ? "Silent=TRUE" : "Silent=FALSE";
+            break;
+
+        case e_PROP_WAIT:
+        case e_PROP_SNAP:
+        case e_PROP_LINK:
+        case e_PROP_PADS:
+        case e_PROP_PATH:
+            if (parse_param(&ptr_private->params, pspec->name, g_value_get_string(value),
+                            ptr_private->sz_note, sizeof(ptr_private->sz_note)))
+            {
+                psz_now = g_value_get_string(value);
+            }
+            else
+            {
+                g_print("%s --- Property #%u --- Rejected: (%s) \n", THIS_PLUGIN_NAME, (guint) prop_id, ptr_private->sz_note);
+                ptr_private->num_notes++;
+                is_config = FALSE;
+            }
+            break;
+
+        case e_PROP_SHOW_DEBUG_INFO:
+            config_ptr->show_debug_info = g_value_get_boolean (value);
+            break;
+
+        case e_PROP_WINDOWS_LAYOUT:
+            {
+                const GstStructure * layout_ptr = g_value_get_boxed (value);
+
+                gst_structure_free(ptr_private->windows_layout);
+
+                ptr_private->windows_layout = (layout_ptr != NULL) ? gst_structure_copy(layout_ptr)
+                                                                   : gst_structure_new_empty("windowsLayout");
+
+                g_ptr_array_unref(config_ptr->buttons);
+                config_ptr->buttons = buttons_ptr;
+            }
+            break;
+
+        case e_PROP_MESSAGE:
+            config_ptr->put_message = g_value_get_boolean (value);
+            break;
+
+        case e_PROP_SHOW_WINDOWS_LAYOUT:
+            config_ptr->show_windows_layout = g_value_get_boolean (value);
+            break;
+
+        case e_PROP_CALIBRATION_AREA:
+            {
+                const GstStructure * area_ptr = g_value_get_boxed (value);
+
+                if ((area_ptr == NULL) ||
+                    ! gst_structure_get(area_ptr,
+                                        "x",      G_TYPE_INT, &config_ptr->calibration_area.x,
+                                        "y",      G_TYPE_INT, &config_ptr->calibration_area.y,
+                                        "width",  G_TYPE_INT, &config_ptr->calibration_area.w,
+                                        "height", G_TYPE_INT, &config_ptr->calibration_area.h,
+                                        NULL))
+                {
+                    GST_WARNING_OBJECT (pointerdetectix, "calibration area lacks x, y, width or height");
+                }
+            }
+            break;
+
+        case e_PROP_PRIORITY:
+            kms_detectix_governor_set_priority(ptr_private->governor_slot, g_value_get_int (value));
+            is_config = FALSE;
+            break;
+
+        case e_PROP_CPU_BUDGET:
+            kms_detectix_governor_set_budget(g_value_get_uint (value));
+            is_config = FALSE;
+            break;
+
+        case e_PROP_MIN_ANALYSIS_RATE:
+            kms_detectix_governor_set_min_rate(ptr_private->governor_slot, g_value_get_uint (value));
+            is_config = FALSE;
+            break;
+
+        case e_PROP_PREDICTION_LEAD:
+            config_ptr->prediction_lead_ms = g_value_get_uint (value);
+            break;
+
+        case e_PROP_ENTER_FRAMES:
+            config_ptr->enter_frames = g_value_get_uint (value);
+            break;
+
+        case e_PROP_EXIT_FRAMES:
+            config_ptr->exit_frames = g_value_get_uint (value);
+            break;
+
+        case e_PROP_WINDOW_MARGIN:
+            config_ptr->window_margin = (gint) g_value_get_uint (value);
+            break;
+
+        case e_PROP_POINTER_META:
+            config_ptr->put_meta = g_value_get_boolean (value);
+            break;
+
+        case e_PROP_MOVED_RATE:
+            config_ptr->moved_rate = g_value_get_uint (value);
+            break;
+
+        case e_PROP_MOVED_DELTA:
+            config_ptr->moved_delta = g_value_get_uint (value);
+            break;
+
+        case e_PROP_BRANCH:         // spliced below, once the object lock is released
+            ptr_private->is_branch_wanted = g_value_get_boolean (value);
+            is_config = FALSE;
+            break;
+
+        case e_PROP_CAPTURE:        // opened below, the snapshot of the properties takes the object lock
+            g_free(ptr_private->capture_path);
+            ptr_private->capture_path = g_value_dup_string (value);
+            is_config = FALSE;
+            break;
+
+        case e_PROP_COLOR_RANGE:    // applied below under range_lock
+            is_config = FALSE;
+            break;
+
+        case e_PROP_FLIGHT_THRESHOLD:
+            config_ptr->flight_threshold_ms = g_value_get_uint (value);
+            break;
+
+        case e_PROP_METRICS_ID:     // written below under metrics_lock
+            g_free(ptr_private->metrics_id);
+            ptr_private->metrics_id = g_value_dup_string (value);
+            is_config = FALSE;
+            break;
+
+        case e_PROP_READ_ONLY:
+            config_ptr->read_only = g_value_get_boolean (value);
+            break;
+
+        case e_PROP_COMPOSITION:
+            config_ptr->use_composition = g_value_get_boolean (value);
+            break;
+
+        case e_PROP_WINDOWS_ONLY:
+            config_ptr->windows_only = g_value_get_boolean (value);
+            break;
+
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            is_config = FALSE;
+            break;
+    }
+
+    if (psz_now != NULL)
+    {
+        is_config = FALSE;
+    }
+
+    if (is_config)
+    {
+        publish_config(ptr_private, config_ptr);
+    }
+    else
+    {
+        config_unref(config_ptr);
+    }
+
+    if (psz_now != NULL)
+    {
+        g_print("%s --- Property #%u --- Now: (%s) \n", THIS_PLUGIN_NAME, (guint) prop_id, psz_now);
+
+        ptr_private->num_buffs = 0;
+        ptr_private->num_drops = 0;
+        ptr_private->num_notes = 0;
+    }
+
+    GST_OBJECT_UNLOCK (pointerdetectix);
+
+    if (prop_id == e_PROP_BRANCH)
+    {
+        set_branch(pointerdetectix);
+    }
+
+    if (prop_id == e_PROP_METRICS_ID)
+    {
+        set_metrics_id(ptr_private, g_value_get_string (value));
+    }
+
+    if (prop_id == e_PROP_COLOR_RANGE)
+    {
+        KmsDetectixColorRange range;
+
+        if (color_range_from_structure(g_value_get_boxed (value), &range))
+        {
+            g_mutex_lock(&ptr_private->range_lock);
+            ptr_private->color_range = range;
+            g_mutex_unlock(&ptr_private->range_lock);
+        }
+        else
+        {
+            GST_WARNING_OBJECT (pointerdetectix, "color range needs {blue,green,red}-{min,max} within 0 to 255");
+        }
+    }
+
+    // every change after the snapshot is recorded where it happened between the frames
+    if (is_captured(prop_id))
+    {
+        kms_detectix_capture_property(ptr_private->capture, pspec->name, value);
+    }
+    else if (prop_id == e_PROP_CAPTURE)
+    {
+        if (! kms_detectix_capture_open(ptr_private->capture, g_value_get_string (value)))
+        {
+            GST_WARNING_OBJECT (pointerdetectix, "cannot write capture (%s)", g_value_get_string (value));
+        }
+        else if (kms_detectix_capture_is_open(ptr_private->capture))
+        {
+            capture_properties(pointerdetectix);
+        }
+    }
+
+    return;
+}
+
+
+void kms_pointer_detectix_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec)
+{
+    KmsPointerDetectix *pointerdetectix = KMS_POINTER_DETECTOR (object);
+
+    KmsPointerDetectixPrivate * ptr_private = GET_PRIVATE_STRUCT_PTR (pointerdetectix);
+
+    const ConfigStruct * config_ptr;
+
+    DBG_Print( __func__, (gint) prop_id );
+
+    // the range is also written by the frames, so never under the object lock
+    if (prop_id == e_PROP_COLOR_RANGE)
+    {
+        g_mutex_lock(&ptr_private->range_lock);
+        g_value_take_boxed (value, color_range_to_structure(&ptr_private->color_range));
+        g_mutex_unlock(&ptr_private->range_lock);
+    }
+
+    GST_OBJECT_LOCK (pointerdetectix);
+
+    // only publishers replace the snapshot, and they hold the object lock
+    config_ptr = ptr_private->config;
+
+    switch (prop_id) 
+    {
+        case e_PROP_SILENT:
+            g_value_set_boolean(value, ptr_private->is_silent);
+            break;
+
+        case e_PROP_WAIT:
+        case e_PROP_SNAP:
+        case e_PROP_LINK:
+        case e_PROP_PADS:
+        case e_PROP_PATH:
+            {
+                gchar * text_ptr = format_param(&ptr_private->params, pspec->name);
+
+                g_value_take_string(value, g_strdup_printf("%s=%s", pspec->name, text_ptr));
+
+                g_free(text_ptr);
+            }
+            break;
+
+        case e_PROP_NOTE:
+            g_value_set_string(value, ptr_private->sz_note);
+            strcpy(ptr_private->sz_note, "note=none");
+            break;
+
+        case e_PROP_SHOW_DEBUG_INFO:
+            g_value_set_boolean (value, config_ptr->show_debug_info);
+            break;
+
+        case e_PROP_WINDOWS_LAYOUT:
+            g_value_set_boxed (value, ptr_private->windows_layout);
+            break;
+
+        case e_PROP_MESSAGE:
+            g_value_set_boolean (value, config_ptr->put_message);
+            break;
+
+        case e_PROP_SHOW_WINDOWS_LAYOUT:
+            g_value_set_boolean (value, config_ptr->show_windows_layout);
+            break;
+
+        case e_PROP_CALIBRATION_AREA:
+            g_value_take_boxed (value, gst_structure_new ("calibration_area",
+                                                          "x",      G_TYPE_INT, config_ptr->calibration_area.x,
+                                                          "y",      G_TYPE_INT, config_ptr->calibration_area.y,
+                                                          "width",  G_TYPE_INT, config_ptr->calibration_area.w,
+                                                          "height", G_TYPE_INT, config_ptr->calibration_area.h,
+                                                          NULL));
+            break;
+
+        case e_PROP_PRIORITY:
+            g_value_set_int (value, kms_detectix_governor_get_priority(ptr_private->governor_slot));
+            break;
+
+        case e_PROP_CPU_BUDGET:
+            g_value_set_uint (value, kms_detectix_governor_get_budget());
+            break;
+
+        case e_PROP_MIN_ANALYSIS_RATE:
+            g_value_set_uint (value, kms_detectix_governor_get_min_rate(ptr_private->governor_slot));
+            break;
+
+        case e_PROP_PREDICTION_LEAD:
+            g_value_set_uint (value, config_ptr->prediction_lead_ms);
+            break;
+
+        case e_PROP_ENTER_FRAMES:
+            g_value_set_uint (value, config_ptr->enter_frames);
+            break;
+
+        case e_PROP_EXIT_FRAMES:
+            g_value_set_uint (value, config_ptr->exit_frames);
+            break;
+
+        case e_PROP_WINDOW_MARGIN:
+            g_value_set_uint (value, (guint) config_ptr->window_margin);
+            break;
+
+        case e_PROP_POINTER_META:
+            g_value_set_boolean (value, config_ptr->put_meta);
+            break;
+
+        case e_PROP_MOVED_RATE:
+            g_value_set_uint (value, config_ptr->moved_rate);
+            break;
+
+        case e_PROP_MOVED_DELTA:
+            g_value_set_uint (value, config_ptr->moved_delta);
+            break;
+
+        case e_PROP_BRANCH:
+            g_value_set_boolean (value, ptr_private->is_branch_wanted);
+            break;
+
+        case e_PROP_READ_ONLY:
+            g_value_set_boolean (value, config_ptr->read_only);
+            break;
+
+        case e_PROP_COMPOSITION:
+            g_value_set_boolean (value, config_ptr->use_composition);
+            break;
+
+        case e_PROP_WINDOWS_ONLY:
+            g_value_set_boolean (value, config_ptr->windows_only);
+            break;
+
+        case e_PROP_CAPTURE:
+            g_value_set_string (value, ptr_private->capture_path);
+            break;
+
+        case e_PROP_COLOR_RANGE:    // read above
+            break;
+
+        case e_PROP_METRICS_ID:
+            g_value_set_string (value, ptr_private->metrics_id);
+            break;
+
+        case e_PROP_FLIGHT_THRESHOLD:
+            g_value_set_uint (value, config_ptr->flight_threshold_ms);
+            break;
+
+        case e_PROP_DEGRADATION:
+            {
+                KmsDetectixGovernorPlan plan;
+
+                kms_detectix_governor_get_plan(ptr_private->governor_slot, &plan);
+
+                g_value_take_string (value, g_strdup_printf ("priority=%d\tlevel=%u\tinterval=%u\tscale=%u\t"
+                                                              "analyzed=%u\tskipped=%u\tload=%.1f\tbudget=%u\tqos=%u",
+                                                              kms_detectix_governor_get_priority(ptr_private->governor_slot),
+                                                              plan.level,
+                                                              (guint) (plan.interval_ns / NANOS_PER_MILLISEC),
+                                                              plan.scale_shift,
+                                                              ptr_private->num_buffs,
+                                                              ptr_private->num_drops,
+                                                              kms_detectix_governor_get_load(),
+                                                              kms_detectix_governor_get_budget(),
+                                                              kms_detectix_qos_get_level(&ptr_private->qos)));
+            }
+            break;
+
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+
+    GST_OBJECT_UNLOCK (pointerdetectix);
+
+    return;
+}
+
+
+void kms_pointer_detectix_finalize (GObject * object)
+{
+    KmsPointerDetectixPrivate * ptr_private = GET_PRIVATE_STRUCT_PTR (object);
+
+    DBG_Print( __func__, 0 );    DBG_Print( NULL, 0 );
+
+    kms_detectix_governor_unregister(ptr_private->governor_slot);
+    ptr_private->governor_slot = NULL;
+
+    reclaim_configs(ptr_private);
+    config_unref(ptr_private->frame_config);
+    config_unref(ptr_private->config);
+
+    if (ptr_private->window_states != NULL)
+    {
+        g_array_unref(ptr_private->window_states);
+    }
+
+    kms_detectix_labels_free(ptr_private->labels);
+    g_array_unref(ptr_private->regions);
+
+    gst_structure_free(ptr_private->windows_layout);
+    kms_detectix_cv_free(ptr_private->cv);
+    kms_detectix_analysis_free(ptr_private->analysis);
+    clear_params(&ptr_private->params);
+
+    // the branch elements belong to the bin, the handoff was disconnected with this object
+    kms_detectix_branch_unref(ptr_private->branch);
+    kms_detectix_overlay_free(ptr_private->overlay);
+    kms_detectix_capture_free(ptr_private->capture);
+    g_free(ptr_private->capture_path);
+    kms_detectix_metrics_release(ptr_private->metrics);
+    g_free(ptr_private->metrics_id);
+    kms_detectix_recorder_unref(ptr_private->recorder);
+    g_mutex_clear(&ptr_private->analysis_lock);
+    g_mutex_clear(&ptr_private->branch_lock);
+    g_mutex_clear(&ptr_private->range_lock);
+    g_mutex_clear(&ptr_private->metrics_lock);
+
+    G_OBJECT_CLASS (kms_pointer_detectix_parent_class)->finalize (object);
+
+    return;
+}
+
+
+static gboolean kms_pointer_detectix_start (GstBaseTransform * trans)
+{
+    KmsPointerDetectix *pointerdetectix = KMS_POINTER_DETECTOR (trans);
+
+    gchar * name_ptr = NULL;
+
+    DBG_Print( __func__, 0 );
+
+    GST_DEBUG_OBJECT (pointerdetectix, "start");
+
+    GST_OBJECT_LOCK (pointerdetectix);
+
+    pointerdetectix->priv->is_streaming = TRUE;
+
+    // without a metrics-id the counters are published under the element name
+    if ((pointerdetectix->priv->metrics_id == NULL) || (*pointerdetectix->priv->metrics_id == '\0'))
+    {
+        name_ptr = g_strdup(GST_OBJECT_NAME (pointerdetectix));
+    }
+
+    GST_OBJECT_UNLOCK (pointerdetectix);
+
+    if (name_ptr != NULL)
+    {
+        set_metrics_id(pointerdetectix->priv, name_ptr);
+        g_free(name_ptr);
+    }
+
+    // a branch set while stopped, or removed by the last stop
+    set_branch(pointerdetectix);
+
+    return TRUE;
+}
+
+
+static gboolean kms_pointer_detectix_stop (GstBaseTransform * trans)
+{
+    KmsPointerDetectix *pointerdetectix = KMS_POINTER_DETECTOR (trans);
+
+    KmsPointerDetectixPrivate * ptr_private = pointerdetectix->priv;
+
+    DBG_Print( __func__, 0 );
+
+    GST_DEBUG_OBJECT (pointerdetectix, "stop");
+
+    GST_OBJECT_LOCK (pointerdetectix);
+    ptr_private->is_streaming = FALSE;
+    GST_OBJECT_UNLOCK (pointerdetectix);
+
+    // the branch handoff takes snapshots as frames do, it is gone before they are reclaimed
+    set_branch(pointerdetectix);
+
+    // streaming has ended, so nothing else touches the streaming thread state
+    GST_OBJECT_LOCK (pointerdetectix);
+
+    reclaim_configs(ptr_private);
+
+    // the next session starts at full quality, its own sink will report
+    kms_detectix_qos_reset(&ptr_private->qos);
+
+    GST_OBJECT_UNLOCK (pointerdetectix);
+
+    // a spliced branch may still be analyzing
+    g_mutex_lock(&ptr_private->analysis_lock);
+
+    kms_detectix_analysis_release(ptr_private->analysis);
+
+    // the next session sizes the scratch again, even for the same caps
+    ptr_private->analysis_width  = 0;
+    ptr_private->analysis_height = 0;
+    ptr_private->analysis_format = GST_VIDEO_FORMAT_UNKNOWN;
+
+    ptr_private->pointer.found = FALSE;
+
+    kms_detectix_tracker_reset(&ptr_private->tracker);
+
+    ptr_private->moved_pending = FALSE;
+
+    // the next session starts with every window outside
+    config_unref(ptr_private->frame_config);
+    ptr_private->frame_config = NULL;
+
+    if (ptr_private->window_states != NULL)
+    {
+        g_array_unref(ptr_private->window_states);
+        ptr_private->window_states = NULL;
+    }
+
+    kms_detectix_labels_free(ptr_private->labels);
+    ptr_private->labels = NULL;
+    g_array_set_size(ptr_private->regions, 0);
+
+    kms_detectix_overlay_reset(ptr_private->overlay);
+
+    g_mutex_unlock(&ptr_private->analysis_lock);
+
+    // a capture spans sessions, but what was recorded so far can be replayed
+    kms_detectix_capture_flush(ptr_private->capture);
+
+    return TRUE;
+}
+
+
+// the caps templates only offer formats listed here
+static KmsDetectixLayout layout_of_format(GstVideoFormat aFormat)
+{
+    switch (aFormat)
+    {
+        case GST_VIDEO_FORMAT_BGR:  return KMS_DETECTIX_LAYOUT_BGR;
+        case GST_VIDEO_FORMAT_BGRx: return KMS_DETECTIX_LAYOUT_BGRx;
+        case GST_VIDEO_FORMAT_RGBx: return KMS_DETECTIX_LAYOUT_RGBx;
+        case GST_VIDEO_FORMAT_RGBA: return KMS_DETECTIX_LAYOUT_RGBA;
+        case GST_VIDEO_FORMAT_xRGB: return KMS_DETECTIX_LAYOUT_xRGB;
+        default:                    return KMS_DETECTIX_LAYOUTS;
+    }
+}
+
+
+/*
+ * sizes the scratch for the frame about to be analyzed, under analysis_lock --- the branch
+ * may be fed other caps than the inline frames, so each side makes them match before it
+ * analyzes rather than trusting the caps the other side left behind
+ */
+static gboolean use_frame_info(KmsPointerDetectixPrivate * aPrivatePtr, const GstVideoInfo * aInfoPtr)
+{
+    KmsDetectixLayout layout = layout_of_format(GST_VIDEO_INFO_FORMAT (aInfoPtr));
+    gboolean          is_ok;
+
+    if ((GST_VIDEO_INFO_WIDTH (aInfoPtr) == aPrivatePtr->analysis_width) && (GST_VIDEO_INFO_HEIGHT (aInfoPtr) == aPrivatePtr->analysis_height) &&
+        (GST_VIDEO_INFO_FORMAT (aInfoPtr) == aPrivatePtr->analysis_format))
+    {
+        return TRUE;
+    }
+
+    aPrivatePtr->analysis_width  = GST_VIDEO_INFO_WIDTH (aInfoPtr);
+    aPrivatePtr->analysis_height = GST_VIDEO_INFO_HEIGHT (aInfoPtr);
+    aPrivatePtr->analysis_format = GST_VIDEO_INFO_FORMAT (aInfoPtr);
+
+    // the kernel variants of the layout are chosen here once, never per frame
+    is_ok = kms_detectix_analysis_set_info(aPrivatePtr->analysis, aPrivatePtr->analysis_width, aPrivatePtr->analysis_height, layout) &&
+            kms_detectix_cv_set_layout(aPrivatePtr->cv, layout);
+
+    kms_detectix_tracker_reset(&aPrivatePtr->tracker);
+
+    // windows follow the new size in place, the layout is not sent again
+    if (aPrivatePtr->frame_config != NULL)
+    {
+        place_windows(aPrivatePtr);
+    }
+
+    // tried again with the next frame rather than analyzed with scratch of another size
+    if (! is_ok)
+    {
+        aPrivatePtr->analysis_format = GST_VIDEO_FORMAT_UNKNOWN;
+    }
+
+    return is_ok;
+}
+
+
+static gboolean kms_pointer_detectix_set_info ( GstVideoFilter  * filter, 
+                                                GstCaps         * in_caps_ptr, 
+                                                GstVideoInfo    * in_info_ptr, 
+                                                GstCaps         * out_caps_ptr, 
+                                                GstVideoInfo    * out_info_ptr )
+{
+    KmsPointerDetectix *pointerdetectix = KMS_POINTER_DETECTOR (filter);
+
+    gboolean is_ok;
+
+    DBG_Print( __func__, 0 );
+
+    GST_DEBUG_OBJECT (pointerdetectix, "set_info");
+
+    // the scratch arena is sized here once per caps, never per frame --- the object lock is not taken
+    g_mutex_lock(&pointerdetectix->priv->analysis_lock);
+
+    is_ok = use_frame_info(pointerdetectix->priv, in_info_ptr);
+
+    g_mutex_unlock(&pointerdetectix->priv->analysis_lock);
+
+    return is_ok;
+}
+
+
+/*
+ * the flight recorder as it is now, written to a new file in the path folder and announced
+ * with a flight-record message --- the file path, or NULL when it could not be written
+ */
+static gchar * kms_pointer_detectix_dump_flight_record (KmsPointerDetectix * pointerdetectix)
+{
+    KmsPointerDetectixPrivate * ptr_private = pointerdetectix->priv;
+    gchar                     * name_ptr;
+    gchar                     * folder_ptr;
+    gchar                     * path_ptr;
+
+    GST_OBJECT_LOCK (pointerdetectix);
+
+    folder_ptr = (g_strcmp0(ptr_private->params.path, "auto") == 0) ? g_strdup(g_get_tmp_dir()) : g_strdup(ptr_private->params.path);
+    name_ptr   = g_strdup_printf("detectix-flight-%s-%" G_GINT64_FORMAT ".csv", GST_OBJECT_NAME (pointerdetectix), g_get_real_time());
+
+    GST_OBJECT_UNLOCK (pointerdetectix);
+
+    path_ptr = g_build_filename(folder_ptr, name_ptr, NULL);
+
+    g_free(folder_ptr);
+    g_free(name_ptr);
+
+    if (! kms_detectix_recorder_dump(ptr_private->recorder, path_ptr))
+    {
+        g_free(path_ptr);
+        return NULL;
+    }
+
+    gst_element_post_message(GST_ELEMENT (pointerdetectix),
+                             gst_message_new_element(GST_OBJECT (pointerdetectix),
+                                                     gst_structure_new("flight-record",
+                                                                       "path", G_TYPE_STRING, path_ptr,
+                                                                       NULL)));
+    return path_ptr;
+}
+
+
+// the frame that was too slow must not wait for the file as well
+static gpointer dump_flight_record_thread (gpointer aDataPtr)
+{
+    KmsPointerDetectix * pointerdetectix = KMS_POINTER_DETECTOR (aDataPtr);
 
+    g_free(kms_pointer_detectix_dump_flight_record(pointerdetectix));
 
-static void initialize_plugin_instance(KmsPointerDetectix * aPluginPtr, KmsPointerDetectixPrivate * aPrivatePtr);
+    g_atomic_int_set(&pointerdetectix->priv->is_dumping, FALSE);
 
+    gst_object_unref(pointerdetectix);
 
-static GstClock      * The_Sys_Clock_Ptr = NULL;
-static GstClockTime    The_Startup_Nanos = 0;
+    return NULL;
+}
 
 
-static guint64 Get_Runtime_Nanosec()
+static void dump_slow_frame (KmsPointerDetectix * pointerdetectix, guint64 aStartNs)
 {
-    if (The_Sys_Clock_Ptr == NULL)
+    KmsPointerDetectixPrivate * ptr_private = pointerdetectix->priv;
+    GThread                   * thread_ptr;
+
+    if (((ptr_private->flight_dump_ns != 0) && (aStartNs - ptr_private->flight_dump_ns < FLIGHT_HOLDOFF_MS * NANOS_PER_MILLISEC)) ||
+        ! g_atomic_int_compare_and_exchange(&ptr_private->is_dumping, FALSE, TRUE))
     {
-        The_Sys_Clock_Ptr = gst_system_clock_obtain();
+        return;
+    }
 
-        The_Startup_Nanos = gst_clock_get_time (The_Sys_Clock_Ptr);
+    ptr_private->flight_dump_ns = aStartNs;
 
-        g_printf("\n%s\n", THIS_PLUGIN_NAME);
+    thread_ptr = g_thread_try_new("detectix-flight", dump_flight_record_thread, gst_object_ref(pointerdetectix), NULL);
+
+    if (thread_ptr != NULL)
+    {
+        g_thread_unref(thread_ptr);
+    }
+    else
+    {
+        g_atomic_int_set(&ptr_private->is_dumping, FALSE);
+        gst_object_unref(pointerdetectix);
     }
 
-    GstClockTime  now_nanos = gst_clock_get_time( The_Sys_Clock_Ptr );
+    return;
+}
 
-    GstClockTime elapsed_ns = now_nanos -The_Startup_Nanos;
 
-    return (guint64) elapsed_ns;
+KmsDetectixTimings * kms_pointer_detectix_get_timings (KmsPointerDetectix * pointerdetectix)
+{
+    return &pointerdetectix->priv->timings;
 }
 
 
-static guint Get_Runtime_Millisec()
+// time since the mark, which moves to now --- a stage longer than 4 seconds reads as 4 seconds
+static guint32 trace_lap(GstClockTime * aMarkPtr)
 {
-    #define  NANOS_PER_MILLISEC  ((guint64) (1000L * 1000L))
+    GstClockTime now = gst_util_get_timestamp();
+    guint64      lap = now - *aMarkPtr;
 
-    return (guint) (Get_Runtime_Nanosec() / NANOS_PER_MILLISEC);
+    *aMarkPtr = now;
+
+    return (guint32) MIN(lap, G_MAXUINT32);
 }
 
 
-static guint DBG_Print(const gchar * aTextPtr, gint aValue)
+/*
+ * windows-only search: each region within the search window is analyzed on its own and the
+ * largest blob of all is the pointer --- the search window becomes the bounds of what was searched
+ */
+static void find_pointer_in_regions(KmsPointerDetectixPrivate * aPrivatePtr, const guint8 * aPixelsPtr, gint aStride,
+                                    guint aScaleShift, const KmsDetectixColorRange * aRangePtr, KmsDetectixPointer * aPointerPtr)
 {
-    guint elapsed_ms = Get_Runtime_Millisec();
+    GstVideoRectangle  searched  = { 0, 0, 0, 0 };
+    gdouble            best_area = 0.0;
+    guint              num_blobs = 0;
+    guint              index;
 
-    if (aTextPtr != NULL)
+    aPointerPtr->found = FALSE;
+
+    for (index = 0; index < aPrivatePtr->regions->len; index++)
     {
-        g_printf("%-7d --- %s --- %s --- (%d)", elapsed_ms, THIS_PLUGIN_NAME, aTextPtr, aValue);
+        KmsDetectixPointer candidate;
+        GstVideoRectangle  roi;
+
+        if (! intersect_rects(&g_array_index(aPrivatePtr->regions, GstVideoRectangle, index), &aPrivatePtr->search_window, &roi))
+        {
+            continue;
+        }
+
+        kms_detectix_analysis_find_pointer(aPrivatePtr->analysis, aPixelsPtr, aStride, &roi, aScaleShift,
+                                           aRangePtr, &candidate);
+
+        num_blobs += candidate.blobs;
+
+        if (candidate.found)
+        {
+            // confidence is the blob area over its bounding box
+            gdouble area = candidate.confidence * candidate.bounds.w * candidate.bounds.h;
+
+            if (area > best_area)
+            {
+                *aPointerPtr = candidate;
+                best_area    = area;
+            }
+        }
+
+        if (searched.w == 0)
+        {
+            searched = roi;
+        }
+        else
+        {
+            unite_rects(&searched, &roi);
+        }
     }
 
-    g_printf("\n");
+    aPointerPtr->blobs         = num_blobs;
+    aPrivatePtr->search_window = searched;
 
-    return elapsed_ms;
+    return;
 }
 
 
-static void kms_pointer_detectix_init (KmsPointerDetectix * pointerdetectix)
+/*
+ * analysis of one frame with the analysis lock held --- inline frames carry the meta and
+ * are drawn on when mapped writable, branch frames only feed the messages, which are left
+ * in aPostsPtr for the caller to post unlocked
+ */
+static void process_frame (KmsPointerDetectix * pointerdetectix, GstVideoFrame * frame, gboolean aIsInline, gboolean aIsWritable,
+                           GPtrArray ** aPostsPtr)
 {
-    The_Sys_Clock_Ptr = NULL;
-    DBG_Print( __func__, 0 );
+    KmsPointerDetectixPrivate * ptr_private     = pointerdetectix->priv;
+    const ConfigStruct        * config_ptr;
+    KmsDetectixGovernorPlan     plan;
+    guint                       qos_level;
+    gboolean                    draws;
+    guint64                     start_ns;
+    guint8                    * pixels_ptr = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+    gint                        stride     = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+    gint                        width      = GST_VIDEO_FRAME_WIDTH (frame);
+    gint                        height     = GST_VIDEO_FRAME_HEIGHT (frame);
+    GPtrArray                 * left_ids    = NULL;
+    GPtrArray                 * entered_ids = NULL;
+    gchar                    ** active_windows = NULL;
+    KmsDetectixPointer          pointer_moved;
+    KmsDetectixColorRange       color_range;
+    gboolean                    put_moved;
+    guint                       index;
+    gboolean                    is_traced   = kms_detectix_tracer_is_active();
+    GstClockTime                trace_mark  = gst_util_get_timestamp();
+    gboolean                    is_analyzed = FALSE;
+    guint64                     cost_ns     = 0;
+    guint                       num_left    = 0;
+    guint                       num_entered = 0;
+    KmsDetectixFlight           flight;
+
+    kms_detectix_governor_get_plan(ptr_private->governor_slot, &plan);
+
+    // late video downstream costs this session more analysis before it costs any frame
+    qos_level = kms_detectix_qos_get_level(&ptr_private->qos);
+    draws     = kms_detectix_qos_draws(qos_level);
+
+    kms_detectix_qos_apply(qos_level, kms_detectix_governor_get_min_rate(ptr_private->governor_slot), &plan);
+
+    start_ns = (guint64) g_get_monotonic_time() * 1000;
+
+    // frames skipped while the branch analyzes never get here, and are not replayed either
+    kms_detectix_capture_frame(ptr_private->capture, frame);
+
+    // the only read of the control plane in this frame, the object lock is never taken
+    config_ptr = acquire_frame_config(ptr_private);
+
+    g_mutex_lock(&ptr_private->range_lock);
+    color_range = ptr_private->color_range;
+    g_mutex_unlock(&ptr_private->range_lock);
+
+    if (g_atomic_int_compare_and_exchange(&ptr_private->calibrate_pending, TRUE, FALSE))
+    {
+        kms_detectix_cv_calibrate(ptr_private->cv, pixels_ptr, stride, width, height, &config_ptr->calibration_area, &color_range);
 
-    initialize_plugin_instance(pointerdetectix, GET_PRIVATE_STRUCT_PTR (pointerdetectix));
+        g_mutex_lock(&ptr_private->range_lock);
+        ptr_private->color_range = color_range;
+        g_mutex_unlock(&ptr_private->range_lock);
 
-    return;
-}
+        capture_color_range(ptr_private, &color_range);
+    }
 
+    // the governor may ask this session to analyze less often than the frame rate
+    if ((ptr_private->last_analysis_ns == 0) || (start_ns - ptr_private->last_analysis_ns >= plan.interval_ns))
+    {
+        GstClockTime         pts        = GST_BUFFER_PTS (frame->buffer);
+        guint64              time_ns    = GST_CLOCK_TIME_IS_VALID (pts) ? pts : start_ns;
+        KmsDetectixPointer * pointer    = &ptr_private->pointer;
+        gint                 hit_x;
+        gint                 hit_y;
+
+        ptr_private->last_analysis_ns = start_ns;
+        ptr_private->scale_shift      = plan.scale_shift;
+        ptr_private->num_buffs++;
+
+        // while the pointer is tracked only the area around its predicted position is searched
+        if (! kms_detectix_tracker_search_window(&ptr_private->tracker, time_ns, width, height, &ptr_private->search_window))
+        {
+            ptr_private->search_window.x = 0;
+            ptr_private->search_window.y = 0;
+            ptr_private->search_window.w = width;
+            ptr_private->search_window.h = height;
+        }
+
+        if (config_ptr->windows_only && (ptr_private->regions->len > 0))
+        {
+            find_pointer_in_regions(ptr_private, pixels_ptr, stride, plan.scale_shift, &color_range, pointer);
+        }
+        else
+        {
+            kms_detectix_analysis_find_pointer(ptr_private->analysis, pixels_ptr, stride, &ptr_private->search_window, plan.scale_shift,
+                                               &color_range, pointer);
+        }
+
+        kms_detectix_tracker_update(&ptr_private->tracker, pointer->found, pointer->x, pointer->y,
+                                    MAX(pointer->bounds.w, pointer->bounds.h), time_ns);
+
+        // windows are hit where the pointer will be once this frame reaches the viewer
+        hit_x = pointer->x;
+        hit_y = pointer->y;
+
+        if (pointer->found && (config_ptr->prediction_lead_ms > 0))
+        {
+            kms_detectix_tracker_predict(&ptr_private->tracker,
+                                         time_ns + config_ptr->prediction_lead_ms * NANOS_PER_MILLISEC,
+                                         &hit_x, &hit_y);
+        }
+
+        update_windows(ptr_private, pointer->found, hit_x, hit_y, &left_ids, &entered_ids);
+
+        offer_moved_sample(ptr_private, pointer);
+
+        cost_ns     = (guint64) g_get_monotonic_time() * 1000 - start_ns;
+        is_analyzed = TRUE;
+
+        kms_detectix_governor_account(ptr_private->governor_slot, cost_ns);
+    }
+    else
+    {
+        ptr_private->num_drops++;
+    }
 
-void kms_pointer_detectix_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec)
-{
-    const gchar * psz_now = NULL;
+    memset(&flight, 0, sizeof(flight));
 
-    KmsPointerDetectix    * pointerdetectix = KMS_POINTER_DETECTOR (object);
+    flight.analysis_ns = trace_lap(&trace_mark);
 
-    KmsPointerDetectixPrivate * ptr_private = GET_PRIVATE_STRUCT_PTR (pointerdetectix);
+    if (aIsInline && aIsWritable && draws)
+    {
+        draw_overlay(ptr_private, pixels_ptr, stride, width, height);
+    }
 
-    DBG_Print( __func__, (gint) prop_id );
+    put_moved = config_ptr->put_message && take_moved_sample(ptr_private, start_ns, &pointer_moved);
 
-    GST_OBJECT_LOCK (pointerdetectix);
+    // frames skipped by the governor carry the most recent analysis
+    // an unchanged composition is shared by reference with the previous frames
+    if (aIsInline && draws && config_ptr->use_composition && shows_windows(config_ptr) && gst_buffer_is_writable (frame->buffer))
+    {
+        GstVideoOverlayComposition * composition_ptr = kms_detectix_overlay_compose(ptr_private->overlay,
+                                                                                    config_ptr->buttons,
+                                                                                    ptr_private->window_states);
+        if (composition_ptr != NULL)
+        {
+            gst_buffer_add_video_overlay_composition_meta(frame->buffer, composition_ptr);
+        }
+    }
 
-    switch (prop_id) 
+    if (aIsInline && config_ptr->put_meta && gst_buffer_is_writable (frame->buffer))
     {
-        case e_PROP_SILENT:
-            ptr_private->is_silent = g_value_get_boolean(value);
-            psz_now = ptr_private->is_silent ? "Silent=TRUE" : "Silent=FALSE";
-            break;
+        const KmsDetectixPointer * pointer = &ptr_private->pointer;
 
-        case e_PROP_WAIT:
-            snprintf( ptr_private->sz_wait, sizeof(ptr_private->sz_wait), "wait=%s", g_value_get_string(value) );
-            psz_now = ptr_private->sz_wait;
-            break;
+        active_windows = get_active_windows(ptr_private);
 
-        case e_PROP_SNAP:
-            snprintf( ptr_private->sz_snap, sizeof(ptr_private->sz_snap), "snap=%s", g_value_get_string(value) );
-            psz_now = ptr_private->sz_snap;
-            break;
+        gst_buffer_add_kms_detectix_meta(frame->buffer, pointer->found, pointer->x, pointer->y,
+                                         &pointer->bounds, pointer->confidence, active_windows);
 
-        case e_PROP_LINK:
-            snprintf( ptr_private->sz_link, sizeof(ptr_private->sz_link), "link=%s", g_value_get_string(value) );
-            psz_now = ptr_private->sz_link;
-            break;
+        if (pointer->found)
+        {
+            gst_buffer_add_video_region_of_interest_meta(frame->buffer, "pointer",
+                                                         (guint) pointer->bounds.x, (guint) pointer->bounds.y,
+                                                         (guint) pointer->bounds.w, (guint) pointer->bounds.h);
+        }
+    }
 
-        case e_PROP_PADS:
-            snprintf( ptr_private->sz_pads, sizeof(ptr_private->sz_pads), "pads=%s", g_value_get_string(value) );
-            psz_now = ptr_private->sz_pads;
-            break;
+    flight.overlay_ns = trace_lap(&trace_mark);
 
-        case e_PROP_PATH:
-            snprintf( ptr_private->sz_path, sizeof(ptr_private->sz_path), "path=%s", g_value_get_string(value) );
-            psz_now = ptr_private->sz_path;
-            break;
+    if (left_ids != NULL)
+    {
+        num_left = left_ids->len;
 
-        case e_PROP_SHOW_DEBUG_INFO:
-            ptr_private->show_debug_info = g_value_get_boolean (value);
-            break;
+        for (index = 0; config_ptr->put_message && (index < left_ids->len); index++)
+        {
+            queue_window_message(pointerdetectix, aPostsPtr, "window-out", g_ptr_array_index(left_ids, index));
+        }
 
-        case e_PROP_WINDOWS_LAYOUT:
-            break;
+        g_ptr_array_unref(left_ids);
+    }
 
-        case e_PROP_MESSAGE:
-            ptr_private->putMessage = g_value_get_boolean (value);
-            break;
+    if (entered_ids != NULL)
+    {
+        num_entered = entered_ids->len;
 
-        case e_PROP_SHOW_WINDOWS_LAYOUT:
-            ptr_private->show_windows_layout = g_value_get_boolean (value);
-            break;
+        for (index = 0; config_ptr->put_message && (index < entered_ids->len); index++)
+        {
+            queue_window_message(pointerdetectix, aPostsPtr, "window-in", g_ptr_array_index(entered_ids, index));
+        }
 
-        case e_PROP_CALIBRATION_AREA:
-            break;
+        g_ptr_array_unref(entered_ids);
+    }
 
-        default:
-            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-            break;
+    if (put_moved)
+    {
+        queue_moved_message(pointerdetectix, aPostsPtr, &pointer_moved);
     }
 
-    if (psz_now != NULL)
+    flight.posting_ns = trace_lap(&trace_mark);
+
+    if (is_traced)
     {
-        g_print("%s --- Property #%u --- Now: (%s) \n", THIS_PLUGIN_NAME, (guint) prop_id, psz_now);
+        ptr_private->timings.pts         = GST_BUFFER_PTS (frame->buffer);
+        ptr_private->timings.analysis_ns = flight.analysis_ns;
+        ptr_private->timings.overlay_ns  = flight.overlay_ns;
+        ptr_private->timings.posting_ns  = flight.posting_ns;
+    }
 
-        ptr_private->num_buffs = 0;
-        ptr_private->num_drops = 0;
-        ptr_private->num_notes = 0;
+    // one seqlock write per frame, scrapers never take a lock of this element
+    if (ptr_private->metrics != NULL)
+    {
+        KmsDetectixMetricsSlot * metrics_ptr = ptr_private->metrics;
+
+        g_mutex_lock(&ptr_private->metrics_lock);
+
+        kms_detectix_metrics_begin(metrics_ptr);
+
+        metrics_ptr->frames++;
+        metrics_ptr->window_in   += num_entered;
+        metrics_ptr->window_out  += num_left;
+        metrics_ptr->moved       += put_moved ? 1 : 0;
+        metrics_ptr->level        = plan.level;
+        metrics_ptr->scale_shift  = plan.scale_shift;
+
+        if (is_analyzed)
+        {
+            metrics_ptr->analyzed++;
+            metrics_ptr->found += ptr_private->pointer.found ? 1 : 0;
+
+            kms_detectix_metrics_observe(metrics_ptr->analysis_ns, cost_ns);
+        }
+        else
+        {
+            metrics_ptr->skipped++;
+        }
+
+        kms_detectix_metrics_observe(metrics_ptr->frame_ns, (guint64) flight.analysis_ns + flight.overlay_ns + flight.posting_ns);
+
+        kms_detectix_metrics_end(metrics_ptr);
+
+        g_mutex_unlock(&ptr_private->metrics_lock);
     }
 
-    GST_OBJECT_UNLOCK (pointerdetectix);
+    flight.pts         = GST_BUFFER_PTS (frame->buffer);
+    flight.start_ns    = start_ns;
+    flight.flags       = (is_analyzed ? KMS_DETECTIX_FLIGHT_ANALYZED : 0) |
+                         ((is_analyzed && ptr_private->pointer.found) ? KMS_DETECTIX_FLIGHT_FOUND : 0) |
+                         (aIsInline ? 0 : KMS_DETECTIX_FLIGHT_BRANCH);
+    flight.roi_width   = (guint16) (is_analyzed ? ptr_private->search_window.w : 0);
+    flight.roi_height  = (guint16) (is_analyzed ? ptr_private->search_window.h : 0);
+    flight.blobs       = (guint16) (is_analyzed ? MIN(ptr_private->pointer.blobs, G_MAXUINT16) : 0);
+    flight.level       = (guint8) plan.level;
+    flight.scale_shift = (guint8) plan.scale_shift;
+    flight.qos_level   = (guint8) qos_level;
+    flight.window_in   = (guint8) MIN(num_entered, G_MAXUINT8);
+    flight.window_out  = (guint8) MIN(num_left, G_MAXUINT8);
+    flight.moved       = put_moved ? 1 : 0;
+
+    if ((config_ptr->flight_threshold_ms > 0) &&
+        ((guint64) flight.analysis_ns + flight.overlay_ns + flight.posting_ns > config_ptr->flight_threshold_ms * NANOS_PER_MILLISEC))
+    {
+        flight.flags |= KMS_DETECTIX_FLIGHT_SLOW;
+    }
+
+    kms_detectix_recorder_add(ptr_private->recorder, &flight);
+
+    // the dump also holds the frames that follow the slow one until its thread gets to the ring
+    if ((flight.flags & KMS_DETECTIX_FLIGHT_SLOW) != 0)
+    {
+        dump_slow_frame(pointerdetectix, start_ns);
+    }
 
     return;
 }
 
 
-void kms_pointer_detectix_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec)
+/*
+ * a writable map of a shared buffer, e.g. one also teed to a recorder, copies its memory ---
+ * so frames nothing is drawn on go through in passthrough, mapped read-only by GstVideoFilter
+ */
+static void kms_pointer_detectix_before_transform (GstBaseTransform * trans, GstBuffer * buffer)
 {
-    KmsPointerDetectix *pointerdetectix = KMS_POINTER_DETECTOR (object);
+    KmsPointerDetectixPrivate * ptr_private    = KMS_POINTER_DETECTOR (trans)->priv;
+    gboolean                    is_passthrough = TRUE;
+    gboolean                    adds_meta      = FALSE;
 
-    KmsPointerDetectixPrivate * ptr_private = GET_PRIVATE_STRUCT_PTR (pointerdetectix);
+    // while the branch analyzes, inline frames are never drawn on
+    if (! g_atomic_int_get(&ptr_private->is_branch_flowing))
+    {
+        g_mutex_lock(&ptr_private->analysis_lock);
 
-    DBG_Print( __func__, (gint) prop_id );
+        if (! kms_detectix_branch_is_flowing(ptr_private->branch))
+        {
+            const ConfigStruct * config_ptr = acquire_frame_config(ptr_private);
+            gboolean             draws      = kms_detectix_qos_draws(kms_detectix_qos_get_level(&ptr_private->qos));
 
-    GST_OBJECT_LOCK (pointerdetectix);
+            is_passthrough = config_ptr->read_only && ! (draws && needs_drawing(config_ptr));
+            adds_meta      = config_ptr->put_meta || (draws && config_ptr->use_composition && shows_windows(config_ptr));
+        }
 
-    switch (prop_id) 
+        g_mutex_unlock(&ptr_private->analysis_lock);
+    }
+
+    ptr_private->copy_for_meta = is_passthrough && adds_meta;
+
+    if (is_passthrough != gst_base_transform_is_passthrough (trans))
     {
-        case e_PROP_SILENT:
-            g_value_set_boolean(value, ptr_private->is_silent);
-            break;
+        gst_base_transform_set_passthrough (trans, is_passthrough);
+    }
 
-        case e_PROP_WAIT:
-            g_value_set_string(value, ptr_private->sz_wait);
-            break;
+    return;
+}
 
-        case e_PROP_SNAP:
-            g_value_set_string(value, ptr_private->sz_snap);
-            break;
 
-        case e_PROP_LINK:
-            g_value_set_string(value, ptr_private->sz_link);
-            break;
+/*
+ * lateness reported by downstream steps the analysis down before basetransform, when its
+ * qos property is set, starts dropping frames --- throttling sinks are not late
+ */
+static gboolean kms_pointer_detectix_src_event (GstBaseTransform * trans, GstEvent * event)
+{
+    KmsPointerDetectix * pointerdetectix = KMS_POINTER_DETECTOR (trans);
 
-        case e_PROP_PADS:
-            g_value_set_string(value, ptr_private->sz_pads);
-            break;
+    if (GST_EVENT_TYPE (event) == GST_EVENT_QOS)
+    {
+        GstQOSType       type;
+        gdouble          proportion;
+        GstClockTimeDiff diff;
+        GstClockTime     timestamp;
+        gboolean         is_changed = FALSE;
 
-        case e_PROP_PATH:
-            g_value_set_string(value, ptr_private->sz_path);
-            break;
+        gst_event_parse_qos(event, &type, &proportion, &diff, &timestamp);
 
-        case e_PROP_NOTE:
-            g_value_set_string(value, ptr_private->sz_note);
-            strcpy(ptr_private->sz_note, "note=none");
-            break;
+        if (type != GST_QOS_TYPE_THROTTLE)
+        {
+            GST_OBJECT_LOCK (pointerdetectix);
 
-        case e_PROP_SHOW_DEBUG_INFO:
-            g_value_set_boolean (value, ptr_private->show_debug_info);
-            break;
+            is_changed = kms_detectix_qos_update(&pointerdetectix->priv->qos, proportion, diff, (guint64) g_get_monotonic_time() * 1000);
 
-        case e_PROP_WINDOWS_LAYOUT:
-            break;
+            GST_OBJECT_UNLOCK (pointerdetectix);
+        }
 
-        case e_PROP_MESSAGE:
-            g_value_set_boolean (value, ptr_private->putMessage);
-            break;
+        if (is_changed)
+        {
+            GST_INFO_OBJECT (pointerdetectix, "qos level %u, proportion %f, diff %" G_GINT64_FORMAT,
+                             kms_detectix_qos_get_level(&pointerdetectix->priv->qos), proportion, diff);
+        }
+    }
 
-        case e_PROP_SHOW_WINDOWS_LAYOUT:
-            g_value_set_boolean (value, ptr_private->show_windows_layout);
-            break;
+    return GST_BASE_TRANSFORM_CLASS (kms_pointer_detectix_parent_class)->src_event (trans, event);
+}
 
-        case e_PROP_CALIBRATION_AREA:
-            break;
 
-        default:
-            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-            break;
+// in passthrough a shared buffer only gets a new GstBuffer for the meta, its memory stays shared
+static GstFlowReturn kms_pointer_detectix_prepare_output_buffer (GstBaseTransform * trans, GstBuffer * input, GstBuffer ** outbuf)
+{
+    KmsPointerDetectixPrivate * ptr_private = KMS_POINTER_DETECTOR (trans)->priv;
+
+    if (! gst_base_transform_is_passthrough (trans))
+    {
+        return GST_BASE_TRANSFORM_CLASS (kms_pointer_detectix_parent_class)->prepare_output_buffer (trans, input, outbuf);
     }
 
-    GST_OBJECT_UNLOCK (pointerdetectix);
+    *outbuf = (ptr_private->copy_for_meta && ! gst_buffer_is_writable (input)) ? gst_buffer_copy (input) : input;
 
-    return;
+    return (*outbuf != NULL) ? GST_FLOW_OK : GST_FLOW_ERROR;
 }
 
 
-void kms_pointer_detectix_finalize (GObject * object)
+static GstFlowReturn kms_pointer_detectix_transform_frame_ip (GstVideoFilter * filter, GstVideoFrame * frame)
 {
-    DBG_Print( __func__, 0 );    DBG_Print( NULL, 0 );
+    static gint  num_frames = 0;
 
-    G_OBJECT_CLASS (kms_pointer_detectix_parent_class)->finalize (object);
+    KmsPointerDetectix        * pointerdetectix = KMS_POINTER_DETECTOR (filter);
+    KmsPointerDetectixPrivate * ptr_private     = pointerdetectix->priv;
+    GPtrArray                 * posts_ptr       = NULL;
 
-    return;
-}
+    DBG_Print( __func__, (frame == NULL) ? 0 : ++num_frames );
 
+    /*
+     * the media path never waits on the branch --- while it analyzes, frames pass untouched.
+     * Otherwise the lock is only held for an analysis being handed over, or by the caps
+     */
+    if (g_atomic_int_get(&ptr_private->is_branch_flowing))
+    {
+        return GST_FLOW_OK;
+    }
 
-static gboolean kms_pointer_detectix_start (GstBaseTransform * trans)
-{
-    KmsPointerDetectix *pointerdetectix = KMS_POINTER_DETECTOR (trans);
+    g_mutex_lock(&ptr_private->analysis_lock);
 
-    DBG_Print( __func__, 0 );
+    // a branch removed since the last inline frame may have left its own caps behind
+    if (! kms_detectix_branch_is_flowing(ptr_private->branch) && use_frame_info(ptr_private, &frame->info))
+    {
+        process_frame(pointerdetectix, frame, TRUE, ! gst_base_transform_is_passthrough (GST_BASE_TRANSFORM (filter)), &posts_ptr);
+    }
 
-    GST_DEBUG_OBJECT (pointerdetectix, "start");
+    g_mutex_unlock(&ptr_private->analysis_lock);
 
-    return TRUE;
+    post_messages(pointerdetectix, posts_ptr);
+
+    return GST_FLOW_OK;
 }
 
 
-static gboolean kms_pointer_detectix_stop (GstBaseTransform * trans)
+// fakesink handoff at the end of the branch, on the thread of the leaky queue
+static void on_branch_handoff (GstElement * aSinkPtr, GstBuffer * aBufferPtr, GstPad * aPadPtr, gpointer aDataPtr)
 {
-    KmsPointerDetectix *pointerdetectix = KMS_POINTER_DETECTOR (trans);
+    KmsPointerDetectix        * pointerdetectix = KMS_POINTER_DETECTOR (aDataPtr);
+    KmsPointerDetectixPrivate * ptr_private     = pointerdetectix->priv;
+    GstCaps                   * caps_ptr        = gst_pad_get_current_caps(aPadPtr);
+    GPtrArray                 * posts_ptr       = NULL;
+    GstVideoInfo                info;
+    GstVideoFrame               frame;
+
+    if ((caps_ptr == NULL) || ! gst_video_info_from_caps(&info, caps_ptr) ||
+        ! gst_video_frame_map(&frame, &info, aBufferPtr, GST_MAP_READ))
+    {
+        if (caps_ptr != NULL)
+        {
+            gst_caps_unref(caps_ptr);
+        }
 
-    DBG_Print( __func__, 0 );
+        return;
+    }
 
-    GST_DEBUG_OBJECT (pointerdetectix, "stop");
+    g_mutex_lock(&ptr_private->analysis_lock);
 
-    return TRUE;
-}
+    // the branch may be fed by another producer than the inline caps describe
+    if (kms_detectix_branch_is_flowing(ptr_private->branch) && use_frame_info(ptr_private, &info))
+    {
+        g_atomic_int_set(&ptr_private->is_branch_flowing, TRUE);
 
+        process_frame(pointerdetectix, &frame, FALSE, FALSE, &posts_ptr);
+    }
 
-static gboolean kms_pointer_detectix_set_info ( GstVideoFilter  * filter, 
-                                                GstCaps         * in_caps_ptr, 
-                                                GstVideoInfo    * in_info_ptr, 
-                                                GstCaps         * out_caps_ptr, 
-                                                GstVideoInfo    * out_info_ptr )
-{
-    KmsPointerDetectix *pointerdetectix = KMS_POINTER_DETECTOR (filter);
+    g_mutex_unlock(&ptr_private->analysis_lock);
 
-    DBG_Print( __func__, 0 );
+    post_messages(pointerdetectix, posts_ptr);
 
-    GST_DEBUG_OBJECT (pointerdetectix, "set_info");
+    gst_video_frame_unmap(&frame);
+    gst_caps_unref(caps_ptr);
 
-    return TRUE;
+    return;
 }
 
 
-static GstFlowReturn kms_pointer_detectix_transform_frame_ip (GstVideoFilter * filter, GstVideoFrame * frame)
+/*
+ * splices or removes the analysis branch to match the branch property, and only while
+ * streaming --- stopped, nothing would reclaim the snapshots its handoff takes. Never
+ * under the object lock, the pads are relinked from an idle probe that may run right
+ * here or on the streaming thread
+ */
+static void set_branch (KmsPointerDetectix * pointerdetectix)
 {
-    static gint  num_frames = 0;
+    KmsPointerDetectixPrivate * ptr_private = pointerdetectix->priv;
+    KmsDetectixBranch         * branch_ptr;
+    ParamsStruct                params;
+    GstCaps                   * caps_ptr;
+    gboolean                    is_enabled;
+    gchar                       sz_note[sizeof(ptr_private->sz_note)] = "";
 
-    DBG_Print( __func__, (frame == NULL) ? 0 : ++num_frames );
+    g_mutex_lock(&ptr_private->branch_lock);
 
-    return GST_FLOW_OK;
+    // read under branch_lock, so the last of start, stop and set_property decides
+    GST_OBJECT_LOCK (pointerdetectix);
+    is_enabled = ptr_private->is_branch_wanted && ptr_private->is_streaming;
+    GST_OBJECT_UNLOCK (pointerdetectix);
+
+    g_mutex_lock(&ptr_private->analysis_lock);
+    branch_ptr = ptr_private->branch;
+    g_atomic_pointer_set(&ptr_private->branch, is_enabled ? branch_ptr : NULL);
+    g_atomic_int_set(&ptr_private->is_branch_flowing, is_enabled && g_atomic_int_get(&ptr_private->is_branch_flowing));
+    g_mutex_unlock(&ptr_private->analysis_lock);
+
+    if (! is_enabled)
+    {
+        // the unsplice probe stops the queue, whose handoff may be waiting for the analysis lock
+        kms_detectix_branch_unsplice(branch_ptr);
+    }
+    else if (branch_ptr == NULL)
+    {
+        GST_OBJECT_LOCK (pointerdetectix);
+        copy_params(&params, &ptr_private->params);
+        GST_OBJECT_UNLOCK (pointerdetectix);
+
+        caps_ptr   = gst_caps_from_string(VIDEO_SINK_CAPS);
+        branch_ptr = kms_detectix_branch_splice(GST_ELEMENT (pointerdetectix), params.link, params.pads, caps_ptr,
+                                                G_CALLBACK (on_branch_handoff), pointerdetectix, sz_note, sizeof(sz_note));
+        gst_caps_unref(caps_ptr);
+        clear_params(&params);
+
+        g_mutex_lock(&ptr_private->analysis_lock);
+        g_atomic_pointer_set(&ptr_private->branch, branch_ptr);
+        g_mutex_unlock(&ptr_private->analysis_lock);
+    }
+
+    g_mutex_unlock(&ptr_private->branch_lock);
+
+    if (sz_note[0] != '\0')
+    {
+        g_print("%s --- Branch --- Rejected: (%s) \n", THIS_PLUGIN_NAME, sz_note);
+
+        GST_OBJECT_LOCK (pointerdetectix);
+        strcpy(ptr_private->sz_note, sz_note);
+        ptr_private->num_notes++;
+        ptr_private->is_branch_wanted = FALSE;
+        GST_OBJECT_UNLOCK (pointerdetectix);
+    }
+
+    return;
 }
 
 
@@ -428,9 +3029,48 @@ static void kms_pointer_detectix_class_init (KmsPointerDetectixClass * klass)
     base_transform_class_ptr->start = GST_DEBUG_FUNCPTR (kms_pointer_detectix_start);
     base_transform_class_ptr->stop  = GST_DEBUG_FUNCPTR (kms_pointer_detectix_stop);
 
+    base_transform_class_ptr->before_transform      = GST_DEBUG_FUNCPTR (kms_pointer_detectix_before_transform);
+    base_transform_class_ptr->prepare_output_buffer = GST_DEBUG_FUNCPTR (kms_pointer_detectix_prepare_output_buffer);
+    base_transform_class_ptr->src_event             = GST_DEBUG_FUNCPTR (kms_pointer_detectix_src_event);
+    base_transform_class_ptr->transform_ip_on_passthrough = TRUE;
+
     video_filter_class_ptr->set_info = GST_DEBUG_FUNCPTR (kms_pointer_detectix_set_info);
     video_filter_class_ptr->transform_frame_ip = GST_DEBUG_FUNCPTR (kms_pointer_detectix_transform_frame_ip);
 
+    klass->calibrate_color = kms_pointer_detectix_calibrate_color;
+    klass->get_params      = kms_pointer_detectix_get_params;
+    klass->set_params      = kms_pointer_detectix_set_params;
+
+    klass->dump_flight_record = kms_pointer_detectix_dump_flight_record;
+
+    The_Plugin_Signals[e_SIGNAL_CALIBRATE_COLOR] = g_signal_new ("calibrate-color",
+                                                                 G_TYPE_FROM_CLASS (klass),
+                                                                 (GSignalFlags) (G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+                                                                 G_STRUCT_OFFSET (KmsPointerDetectixClass, calibrate_color),
+                                                                 NULL, NULL, NULL,
+                                                                 G_TYPE_NONE, 0);
+
+    The_Plugin_Signals[e_SIGNAL_GET_PARAMS] = g_signal_new ("get-params",
+                                                            G_TYPE_FROM_CLASS (klass),
+                                                            (GSignalFlags) (G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+                                                            G_STRUCT_OFFSET (KmsPointerDetectixClass, get_params),
+                                                            NULL, NULL, NULL,
+                                                            GST_TYPE_STRUCTURE, 0);
+
+    The_Plugin_Signals[e_SIGNAL_SET_PARAMS] = g_signal_new ("set-params",
+                                                            G_TYPE_FROM_CLASS (klass),
+                                                            (GSignalFlags) (G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+                                                            G_STRUCT_OFFSET (KmsPointerDetectixClass, set_params),
+                                                            NULL, NULL, NULL,
+                                                            G_TYPE_BOOLEAN, 1, GST_TYPE_STRUCTURE);
+
+    The_Plugin_Signals[e_SIGNAL_DUMP_FLIGHT_RECORD] = g_signal_new ("dump-flight-record",
+                                                                    G_TYPE_FROM_CLASS (klass),
+                                                                    (GSignalFlags) (G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+                                                                    G_STRUCT_OFFSET (KmsPointerDetectixClass, dump_flight_record),
+                                                                    NULL, NULL, NULL,
+                                                                    G_TYPE_STRING, 0);
+
     gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
                                         gst_pad_template_new ("src", 
                                                               GST_PAD_SRC, 
@@ -511,7 +3151,9 @@ static void kms_pointer_detectix_class_init (KmsPointerDetectixClass * klass)
                                      e_PROP_WINDOWS_LAYOUT,
                                      g_param_spec_boxed ("windows-layout", 
                                                          "windows layout",
-                                                         "supply the positions and dimensions of windows into the main window",
+                                                         "supply the positions and dimensions of windows into the main window --- "
+                                                         "in pixels, in pixels of referenceWidth x referenceHeight or as fractions of the frame --- "
+                                                         "shape is rectangle, ellipse, polygon with points or mask with mask_uri",
                                                          GST_TYPE_STRUCTURE, 
                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
@@ -531,6 +3173,159 @@ static void kms_pointer_detectix_class_init (KmsPointerDetectixClass * klass)
                                                            TRUE, 
                                                            G_PARAM_READWRITE));
 
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_PRIORITY,
+                                     g_param_spec_int ("priority",
+                                                       "session priority",
+                                                       "sessions with lower priority are degraded first when the host is saturated",
+                                                       G_MININT, G_MAXINT, 0,
+                                                       G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_CPU_BUDGET,
+                                     g_param_spec_uint ("cpu-budget",
+                                                        "process-wide cpu budget",
+                                                        "percent of all cores shared by every pointerdetectix in the process, 0 is unlimited",
+                                                        0, 100, 0,
+                                                        G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_MIN_ANALYSIS_RATE,
+                                     g_param_spec_uint ("min-analysis-rate",
+                                                        "minimum analysis rate",
+                                                        "frames per second analyzed even when the session is degraded",
+                                                        0, 120, 2,
+                                                        G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_DEGRADATION,
+                                     g_param_spec_string ("degradation",
+                                                          "degradation=name=value list separated by tabs",
+                                                          "current degradation level decided by the cpu governor and downstream qos",
+                                                          "",
+                                                          G_PARAM_READABLE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_PREDICTION_LEAD,
+                                     g_param_spec_uint ("prediction-lead",
+                                                        "prediction lead in millis",
+                                                        "raise window events where the pointer is predicted to be this many millis later, 0 disables",
+                                                        0, 1000, 0,
+                                                        G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_ENTER_FRAMES,
+                                     g_param_spec_uint ("enter-frames",
+                                                        "analyses before window-in",
+                                                        "analyzed frames in a row the pointer must hit a window before it is entered",
+                                                        1, 100, DEFAULT_ENTER_FRAMES,
+                                                        G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_EXIT_FRAMES,
+                                     g_param_spec_uint ("exit-frames",
+                                                        "analyses before window-out",
+                                                        "analyzed frames in a row the pointer must miss a window before it is left",
+                                                        1, 100, DEFAULT_EXIT_FRAMES,
+                                                        G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_WINDOW_MARGIN,
+                                     g_param_spec_uint ("window-margin",
+                                                        "window margin in pixels",
+                                                        "an entered window is not left while the pointer stays this close to it",
+                                                        0, 1000, DEFAULT_WINDOW_MARGIN,
+                                                        G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_POINTER_META,
+                                     g_param_spec_boolean ("pointer-meta",
+                                                           "attach pointer meta",
+                                                           "attach the pointer and the active windows to every outgoing buffer",
+                                                           TRUE,
+                                                           G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_MOVED_RATE,
+                                     g_param_spec_uint ("pointer-moved-rate",
+                                                        "pointer-moved messages per second",
+                                                        "maximum rate of pointer-moved messages, 0 disables them",
+                                                        0, 120, 0,
+                                                        G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_MOVED_DELTA,
+                                     g_param_spec_uint ("pointer-moved-delta",
+                                                        "pointer-moved delta in pixels",
+                                                        "pointer-moved is only posted when the pointer moves farther than this",
+                                                        0, 1000, DEFAULT_MOVED_DELTA,
+                                                        G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_BRANCH,
+                                     g_param_spec_boolean ("branch",
+                                                           "analysis branch",
+                                                           "splice a tee and a leaky queue as described by link and pads, and analyze on that branch while streaming",
+                                                           FALSE,
+                                                           G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_READ_ONLY,
+                                     g_param_spec_boolean ("read-only-analysis",
+                                                           "read-only analysis",
+                                                           "analyze in passthrough through a read-only map, frames are only made writable when something is drawn on them",
+                                                           TRUE,
+                                                           G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_COMPOSITION,
+                                     g_param_spec_boolean ("overlay-composition",
+                                                           "windows as overlay composition",
+                                                           "attach the windows as GstVideoOverlayCompositionMeta for downstream to blend, instead of drawing them into the frame",
+                                                           FALSE,
+                                                           G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_WINDOWS_ONLY,
+                                     g_param_spec_boolean ("windows-only",
+                                                           "search only around the windows",
+                                                           "classify colors only in the windows grown by their margin and a motion reach, "
+                                                           "for sessions that want window events rather than the free pointer position",
+                                                           FALSE,
+                                                           G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_CAPTURE,
+                                     g_param_spec_string ("capture",
+                                                          "capture file",
+                                                          "record frames, caps, property changes and posted messages to this file for offline replay, empty stops",
+                                                          NULL,
+                                                          G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_COLOR_RANGE,
+                                     g_param_spec_boxed ("color-range",
+                                                         "tracked color range",
+                                                         "{blue,green,red}-{min,max} of the tracked color, replaced by each calibration",
+                                                         GST_TYPE_STRUCTURE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_METRICS_ID,
+                                     g_param_spec_string ("metrics-id",
+                                                          "metrics id",
+                                                          "key of this element's counters in the shared metrics segment, the element name when empty",
+                                                          NULL,
+                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property (gobject_class_ptr,
+                                     e_PROP_FLIGHT_THRESHOLD,
+                                     g_param_spec_uint ("flight-threshold",
+                                                        "flight recorder threshold",
+                                                        "millis a frame may take before the recent frame timings are dumped to the path folder, 0 only dumps on dump-flight-record",
+                                                        0, 60000, 0,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
     g_object_class_install_property (gobject_class_ptr, 
                                      e_PROP_CALIBRATION_AREA,
                                      g_param_spec_boxed ("calibration-area", 
@@ -559,6 +3354,11 @@ static gboolean register_this_plugin(GstPlugin * aPluginPtr)
     The_Sys_Clock_Ptr = NULL;
     DBG_Print( __func__, 0 );
 
+    kms_detectix_kernels_init();
+
+    // optional, GST_TRACERS=detectixlatency only finds it on GStreamer 1.8 and later
+    kms_detectix_tracer_register(aPluginPtr);
+
     return gst_element_register (aPluginPtr, THIS_PLUGIN_NAME, GST_RANK_NONE, KMS_TYPE_POINTER_DETECTOR);
 }
 
@@ -574,11 +3374,14 @@ GST_PLUGIN_DEFINE ( GST_VERSION_MAJOR,
 
 static void initialize_plugin_instance(KmsPointerDetectix * aPluginPtr, KmsPointerDetectixPrivate * aPrivatePtr)
 {
-    strcpy(aPrivatePtr->sz_wait, "wait=2000");
-    strcpy(aPrivatePtr->sz_snap, "snap=0,0,0");
-    strcpy(aPrivatePtr->sz_link, "link=Live,auto,auto");
-    strcpy(aPrivatePtr->sz_pads, "pads=auto,auto,auto");
-    strcpy(aPrivatePtr->sz_path, "path=auto");
+    memset(&aPrivatePtr->params, 0, sizeof(aPrivatePtr->params));
+
+    parse_param(&aPrivatePtr->params, "wait", "2000",                aPrivatePtr->sz_note, sizeof(aPrivatePtr->sz_note));
+    parse_param(&aPrivatePtr->params, "snap", "0,0,0",               aPrivatePtr->sz_note, sizeof(aPrivatePtr->sz_note));
+    parse_param(&aPrivatePtr->params, "link", "Live,auto,auto",      aPrivatePtr->sz_note, sizeof(aPrivatePtr->sz_note));
+    parse_param(&aPrivatePtr->params, "pads", "auto,auto,auto",      aPrivatePtr->sz_note, sizeof(aPrivatePtr->sz_note));
+    parse_param(&aPrivatePtr->params, "path", "auto",                aPrivatePtr->sz_note, sizeof(aPrivatePtr->sz_note));
+
     strcpy(aPrivatePtr->sz_note, "note=none");
     
     aPrivatePtr->num_buffs = 0;
@@ -586,9 +3389,81 @@ static void initialize_plugin_instance(KmsPointerDetectix * aPluginPtr, KmsPoint
     aPrivatePtr->num_notes = 0;
     aPrivatePtr->is_silent = TRUE;
 
-    aPrivatePtr->show_debug_info    = FALSE;
-    aPrivatePtr->putMessage         = TRUE;
-    aPrivatePtr->show_windows_layout= TRUE;
+    aPrivatePtr->config             = g_slice_new0(ConfigStruct);
+    aPrivatePtr->retired            = NULL;
+    aPrivatePtr->is_streaming       = FALSE;
+    aPrivatePtr->frame_config       = NULL;
+    aPrivatePtr->window_states      = NULL;
+    aPrivatePtr->labels             = NULL;
+    aPrivatePtr->regions            = g_array_new(FALSE, FALSE, sizeof(GstVideoRectangle));
+
+    aPrivatePtr->config->ref_count          = 1;
+    aPrivatePtr->config->buttons            = g_ptr_array_new_with_free_func((GDestroyNotify) free_button);
+    aPrivatePtr->config->show_debug_info    = FALSE;
+    aPrivatePtr->config->show_windows_layout= TRUE;
+    aPrivatePtr->config->put_message        = TRUE;
+    aPrivatePtr->config->put_meta           = TRUE;
+    aPrivatePtr->config->read_only          = TRUE;
+    aPrivatePtr->config->use_composition    = FALSE;
+    aPrivatePtr->config->windows_only       = FALSE;
+    aPrivatePtr->config->prediction_lead_ms = 0;
+    aPrivatePtr->config->enter_frames       = DEFAULT_ENTER_FRAMES;
+    aPrivatePtr->config->exit_frames        = DEFAULT_EXIT_FRAMES;
+    aPrivatePtr->config->window_margin      = DEFAULT_WINDOW_MARGIN;
+    aPrivatePtr->config->moved_rate         = 0;
+    aPrivatePtr->config->moved_delta        = DEFAULT_MOVED_DELTA;
+    aPrivatePtr->config->flight_threshold_ms = 0;
+
+    aPrivatePtr->last_analysis_ns   = 0;
+    aPrivatePtr->scale_shift        = 0;
+    aPrivatePtr->governor_slot      = kms_detectix_governor_register(aPluginPtr);
+
+    kms_detectix_qos_reset(&aPrivatePtr->qos);
+
+    aPrivatePtr->windows_layout     = gst_structure_new_empty("windowsLayout");
+    aPrivatePtr->calibrate_pending  = FALSE;
+    aPrivatePtr->cv                 = kms_detectix_cv_new();
+    aPrivatePtr->analysis           = kms_detectix_analysis_new();
+    aPrivatePtr->pointer.found      = FALSE;
+    aPrivatePtr->moved_pending      = FALSE;
+    aPrivatePtr->moved_last_ns      = 0;
+    aPrivatePtr->analysis_width     = 0;
+    aPrivatePtr->analysis_height    = 0;
+    aPrivatePtr->analysis_format    = GST_VIDEO_FORMAT_UNKNOWN;
+    aPrivatePtr->branch             = NULL;
+    aPrivatePtr->is_branch_flowing  = FALSE;
+    aPrivatePtr->is_branch_wanted   = FALSE;
+    aPrivatePtr->copy_for_meta      = FALSE;
+    aPrivatePtr->overlay            = kms_detectix_overlay_new();
+    aPrivatePtr->capture            = kms_detectix_capture_new();
+    aPrivatePtr->capture_path       = NULL;
+    aPrivatePtr->metrics            = kms_detectix_metrics_acquire(NULL);
+    aPrivatePtr->metrics_id         = NULL;
+    aPrivatePtr->recorder           = kms_detectix_recorder_new();
+    aPrivatePtr->flight_dump_ns     = 0;
+    aPrivatePtr->is_dumping         = FALSE;
+
+    memset(&aPrivatePtr->timings, 0, sizeof(aPrivatePtr->timings));
+
+    aPrivatePtr->timings.entry_ts   = GST_CLOCK_TIME_NONE;
+    aPrivatePtr->timings.pts        = GST_CLOCK_TIME_NONE;
+
+    g_mutex_init(&aPrivatePtr->analysis_lock);
+    g_mutex_init(&aPrivatePtr->branch_lock);
+    g_mutex_init(&aPrivatePtr->range_lock);
+    g_mutex_init(&aPrivatePtr->metrics_lock);
+
+    memset(&aPrivatePtr->moved_sample, 0, sizeof(aPrivatePtr->moved_sample));
+    memset(&aPrivatePtr->moved_last,   0, sizeof(aPrivatePtr->moved_last));
+
+    kms_detectix_tracker_reset(&aPrivatePtr->tracker);
+
+    // until calibrated, track a bright red pointer
+    aPrivatePtr->color_range.low[0]  = 0;    aPrivatePtr->color_range.high[0] = 90;
+    aPrivatePtr->color_range.low[1]  = 0;    aPrivatePtr->color_range.high[1] = 90;
+    aPrivatePtr->color_range.low[2]  = 150;  aPrivatePtr->color_range.high[2] = 255;
+
+    aPrivatePtr->search_window      = aPrivatePtr->config->calibration_area;
 
     aPluginPtr->priv = aPrivatePtr;
 
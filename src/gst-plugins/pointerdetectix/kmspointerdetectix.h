@@ -19,10 +19,12 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
-#include <opencv/cv.h>
-#include <opencv/highgui.h>
 #include <stdio.h>
 
+#include "kmsdetectixcv.h"
+#include "kmsdetectixlabels.h"
+#include "kmsdetectixtracer.h"
+
 
 #define THIS_PLUGIN_NAME "pointerdetectix"
 
@@ -39,14 +41,37 @@ typedef struct _KmsPointerDetectix KmsPointerDetectix;
 typedef struct _KmsPointerDetectixClass KmsPointerDetectixClass;
 typedef struct _KmsPointerDetectixPrivate KmsPointerDetectixPrivate;
 
+typedef enum {
+    BUTTON_OUTSIDE,
+    BUTTON_ENTERING,    /* hit, waiting for enter-frames */
+    BUTTON_INSIDE,
+    BUTTON_LEAVING      /* missed, waiting for exit-frames */
+} ButtonState;
+
 typedef struct _ButtonStruct {
-    CvRect cvButtonLayout;
+    GstVideoRectangle layout;   /* frame pixels, unless is_scalable */
+    gboolean is_scalable;       /* placed again on every caps */
+    gdouble placement[4];       /* x, y, width and height as fractions of the frame */
     gchar *id;
-    IplImage* inactive_icon;
-    IplImage* active_icon;
+    KmsDetectixImage* inactive_icon;    /* sized to layout, as decoded when is_scalable */
+    KmsDetectixImage* active_icon;
     gdouble transparency;
+    KmsDetectixShapeType shape;   /* hit area within layout */
+    gdouble *points;            /* polygon: x, y pairs as fractions of layout */
+    guint num_points;
+    KmsDetectixImage* mask;     /* mask: sized like the icons */
 } ButtonStruct;
 
+/* owned by the streaming thread, one per button of the layout in use */
+typedef struct _WindowState {
+    ButtonState state;
+    guint num_frames;   /* analyses spent in ENTERING or LEAVING */
+    GstVideoRectangle rect;     /* the button placed on frames of the analysis size */
+    KmsDetectixImage* inactive_icon;    /* the button icons at the size of rect */
+    KmsDetectixImage* active_icon;
+    KmsDetectixImage* mask;     /* the button mask at the size of rect */
+} WindowState;
+
 struct _KmsPointerDetectix {
   GstVideoFilter base_pointerdetectix;
 
@@ -58,12 +83,18 @@ struct _KmsPointerDetectixClass {
 
   /* Actions */
   void (*calibrate_color) (KmsPointerDetectix *pointerdetectix);
+  GstStructure * (*get_params) (KmsPointerDetectix *pointerdetectix);
+  gboolean (*set_params) (KmsPointerDetectix *pointerdetectix, const GstStructure *params);
+  gchar * (*dump_flight_record) (KmsPointerDetectix *pointerdetectix);
 };
 
 GType kms_pointer_detectix_get_type (void);
 
 gboolean kms_pointer_detectix_plugin_init (GstPlugin * plugin);
 
+/* streaming thread only --- filled in while kms_detectix_tracer_is_active () */
+KmsDetectixTimings * kms_pointer_detectix_get_timings (KmsPointerDetectix *pointerdetectix);
+
 G_END_DECLS
 
 #endif
@@ -34,6 +34,17 @@ GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 #define WINDOWS_LAYOUT "windows-layout"
 #define CALIBRATION_AREA "calibration-area"
 #define CALIBRATE_COLOR "calibrate-color"
+#define PRIORITY "priority"
+#define CPU_BUDGET "cpu-budget"
+#define DEGRADATION "degradation"
+#define POINTER_MOVED_RATE "pointer-moved-rate"
+#define POINTER_MOVED_DELTA "pointer-moved-delta"
+#define ANALYSIS_BRANCH "branch"
+#define OVERLAY_COMPOSITION "overlay-composition"
+#define METRICS_ID "metrics-id"
+#define FLIGHT_THRESHOLD "flight-threshold"
+#define WINDOWS_ONLY "windows-only"
+#define DUMP_FLIGHT_RECORD "dump-flight-record"
 
 namespace kurento
 {
@@ -71,6 +82,40 @@ get_structure_from_window (std::shared_ptr<PointerDetectixWindowMediaParam>
                        G_TYPE_STRING, window->getActiveImage().c_str(), NULL);
   }
 
+  if (window->isSetReferenceWidth() && window->isSetReferenceHeight() ) {
+    gst_structure_set (buttonsLayoutAux,
+                       "referenceWidth", G_TYPE_INT, window->getReferenceWidth(),
+                       "referenceHeight", G_TYPE_INT, window->getReferenceHeight(),
+                       NULL);
+  }
+
+  if (window->isSetShape() ) {
+    gst_structure_set (buttonsLayoutAux, "shape",
+                       G_TYPE_STRING, window->getShape().c_str(), NULL);
+  }
+
+  if (window->isSetPoints() ) {
+    GValue points = G_VALUE_INIT;
+
+    g_value_init (&points, GST_TYPE_ARRAY);
+
+    for (float point : window->getPoints() ) {
+      GValue value = G_VALUE_INIT;
+
+      g_value_init (&value, G_TYPE_DOUBLE);
+      g_value_set_double (&value, point);
+      gst_value_array_append_value (&points, &value);
+      g_value_unset (&value);
+    }
+
+    gst_structure_take_value (buttonsLayoutAux, "points", &points);
+  }
+
+  if (window->isSetMask() ) {
+    gst_structure_set (buttonsLayoutAux, "mask_uri",
+                       G_TYPE_STRING, window->getMask().c_str(), NULL);
+  }
+
   return buttonsLayoutAux;
 }
 
@@ -89,6 +134,17 @@ void PointerDetectixFilterImpl::busMessage (GstMessage *message)
   st = gst_message_get_structure (message);
   type = gst_structure_get_name (st);
 
+  if (g_strcmp0 (type, "pointer-moved") == 0) {
+    pointerMoved (st);
+    return;
+  }
+
+  if (g_strcmp0 (type, "flight-record") == 0) {
+    GST_INFO ("Flight record written to %s",
+              gst_structure_get_string (st, "path") );
+    return;
+  }
+
   if ( (g_strcmp0 (type, "window-out") != 0) &&
        (g_strcmp0 (type, "window-in") != 0) ) {
     GST_WARNING ("The message does not have the correct name");
@@ -122,6 +178,28 @@ void PointerDetectixFilterImpl::busMessage (GstMessage *message)
   }
 }
 
+void PointerDetectixFilterImpl::pointerMoved (const GstStructure *st)
+{
+  gint x, y;
+  gboolean visible;
+  gdouble confidence;
+
+  if (!gst_structure_get (st, "x", G_TYPE_INT, &x, "y", G_TYPE_INT, &y,
+                          "visible", G_TYPE_BOOLEAN, &visible,
+                          "confidence", G_TYPE_DOUBLE, &confidence, NULL) ) {
+    GST_WARNING ("The message does not contain the pointer position");
+    return;
+  }
+
+  try {
+    PointerMoved event (shared_from_this(), PointerMoved::getName(), x, y,
+                        visible, float (confidence) );
+
+    signalPointerMoved (event);
+  } catch (std::bad_weak_ptr &e) {
+  }
+}
+
 void PointerDetectixFilterImpl::postConstructor ()
 {
   GstBus *bus;
@@ -129,6 +207,10 @@ void PointerDetectixFilterImpl::postConstructor ()
 
   FilterImpl::postConstructor ();
 
+  // the shared metrics segment is keyed by the id clients know this filter by
+  g_object_set (G_OBJECT (mNativeElementPtr), METRICS_ID, getId().c_str(),
+                NULL);
+
   pipe = std::dynamic_pointer_cast<MediaPipelineImpl> (getMediaPipeline() );
 
   bus = gst_pipeline_get_bus (GST_PIPELINE (pipe->getPipeline() ) );
@@ -148,7 +230,8 @@ PointerDetectixFilterImpl::PointerDetectixFilterImpl (const
     boost::property_tree::ptree &config,
     std::shared_ptr<MediaPipeline> mediaPipeline,
     std::shared_ptr<WindowParam> calibrationRegion,
-    const std::vector<std::shared_ptr<PointerDetectixWindowMediaParam>> &windows)  :
+    const std::vector<std::shared_ptr<PointerDetectixWindowMediaParam>> &windows,
+    int priority)  :
   FilterImpl (config, std::dynamic_pointer_cast<MediaPipelineImpl>
               (mediaPipeline) )
 {
@@ -193,6 +276,8 @@ PointerDetectixFilterImpl::PointerDetectixFilterImpl (const
                 NULL);
   gst_structure_free (buttonsLayout);
 
+  g_object_set (G_OBJECT (mNativeElementPtr), PRIORITY, priority, NULL);
+
   bus_handler_id = 0;
   // There is no need to reference pointerdetectix because its life cycle is the same as the filter life cycle
   g_object_unref (mNativeElementPtr);
@@ -342,24 +427,18 @@ std::string PointerDetectixFilterImpl::getParamsList()
 
     std::string  params_separated_by_tabs;
 
+    std::map<std::string, std::string> params = getParams();
+
     int index = -1;
 
-    while ( names[++index] != NULL )
+    while ( mLastErrorDetails.empty() && (names[++index] != NULL) )
     {
-        std::string param_text = getParam( std::string(names[index]) );
-
-        bool is_ok = mLastErrorDetails.empty();
-
-        if (! is_ok)
-        {
-            params_separated_by_tabs.assign("");
-            break;
-        }
-
         params_separated_by_tabs.append( names[index] ); 
         params_separated_by_tabs.append( "=" );
 
-        params_separated_by_tabs.append( param_text.c_str() );
+        params_separated_by_tabs.append( names[index] ); 
+        params_separated_by_tabs.append( "=" );
+        params_separated_by_tabs.append( params[names[index]] );
         params_separated_by_tabs.append( "\t" );
     }
 
@@ -384,6 +463,8 @@ std::string PointerDetectixFilterImpl::getParam(const std::string & rParamName)
 
     std::string param_value(is_ok ? text_ptr : "");
 
+    g_free(text_ptr);
+
     mLastErrorDetails.assign(is_ok ? "" : "ERROR");
 
     return param_value;
@@ -391,23 +472,279 @@ std::string PointerDetectixFilterImpl::getParam(const std::string & rParamName)
 
 
 bool PointerDetectixFilterImpl::setParam(const std::string & rParamName, const std::string & rNewValue)
+{
+    std::map<std::string, std::string> params;
+
+    params[rParamName] = rNewValue;
+
+    return setParams(params);
+}
+
+
+std::map<std::string, std::string> PointerDetectixFilterImpl::getParams()
 {
     std::unique_lock <std::recursive_mutex>  locker (mRecursiveMutex);
 
-    std::string param_text = getParam(rParamName);
+    std::map<std::string, std::string> params;
+
+    GstStructure * structure_ptr = NULL;
 
-    bool is_ok = mLastErrorDetails.empty();
+    bool is_ok = (mNativeElementPtr != NULL);
 
     if (is_ok)
     {
-        g_object_set( G_OBJECT(mNativeElementPtr), rParamName.c_str(), rNewValue.c_str(), NULL );
+        g_signal_emit_by_name( mNativeElementPtr, "get-params", & structure_ptr );
+
+        is_ok = (structure_ptr != NULL);
+    }
+
+    for (int index = 0; is_ok && (index < gst_structure_n_fields(structure_ptr)); index++)
+    {
+        const gchar * name_ptr  = gst_structure_nth_field_name(structure_ptr, index);
+        const gchar * value_ptr = gst_structure_get_string(structure_ptr, name_ptr);
+
+        params[name_ptr] = (value_ptr != NULL) ? value_ptr : "";
+    }
+
+    if (structure_ptr != NULL)
+    {
+        gst_structure_free(structure_ptr);
     }
 
     mLastErrorDetails.assign( is_ok ? "" : "ERROR" );
 
+    return params;
+}
+
+
+bool PointerDetectixFilterImpl::setParams(const std::map<std::string, std::string> & rParams)
+{
+    std::unique_lock <std::recursive_mutex>  locker (mRecursiveMutex);
+
+    gboolean is_ok = (mNativeElementPtr != NULL);
+
+    if (is_ok)
+    {
+        GstStructure * structure_ptr = gst_structure_new_empty("params");
+
+        for (const auto & param : rParams)
+        {
+            gst_structure_set(structure_ptr, param.first.c_str(), G_TYPE_STRING, param.second.c_str(), NULL);
+        }
+
+        g_signal_emit_by_name( mNativeElementPtr, "set-params", structure_ptr, & is_ok );
+
+        gst_structure_free(structure_ptr);
+
+        // the element explains the rejected value in its note
+        mLastErrorDetails.assign( is_ok ? "" : getParams()["note"] );
+    }
+    else
+    {
+        mLastErrorDetails.assign("ERROR");
+    }
+
     return is_ok;
 }
 
+std::string PointerDetectixFilterImpl::getDegradationLevels()
+{
+    std::unique_lock <std::recursive_mutex>  locker (mRecursiveMutex);
+
+    gchar * text_ptr = NULL;
+
+    bool is_ok = (mNativeElementPtr != NULL);
+
+    if (is_ok)
+    {
+        g_object_get( G_OBJECT(mNativeElementPtr), DEGRADATION, & text_ptr, NULL );
+
+        is_ok = (text_ptr != NULL);
+    }
+
+    std::string levels(is_ok ? text_ptr : "");
+
+    g_free(text_ptr);
+
+    mLastErrorDetails.assign(is_ok ? "" : "ERROR");
+
+    return levels;
+}
+
+
+std::string PointerDetectixFilterImpl::dumpFlightRecord()
+{
+    std::unique_lock <std::recursive_mutex>  locker (mRecursiveMutex);
+
+    gchar * path_ptr = NULL;
+
+    bool is_ok = (mNativeElementPtr != NULL);
+
+    if (is_ok)
+    {
+        g_signal_emit_by_name( mNativeElementPtr, DUMP_FLIGHT_RECORD, & path_ptr );
+
+        is_ok = (path_ptr != NULL);
+    }
+
+    std::string path(is_ok ? path_ptr : "");
+
+    g_free(path_ptr);
+
+    mLastErrorDetails.assign(is_ok ? "" : "ERROR");
+
+    return path;
+}
+
+
+int PointerDetectixFilterImpl::getPriority ()
+{
+  int priority;
+
+  g_object_get (G_OBJECT (mNativeElementPtr), PRIORITY, &priority, NULL);
+
+  return priority;
+}
+
+void PointerDetectixFilterImpl::setPriority (int priority)
+{
+  g_object_set (G_OBJECT (mNativeElementPtr), PRIORITY, priority, NULL);
+}
+
+int PointerDetectixFilterImpl::getCpuBudget ()
+{
+  guint cpuBudget;
+
+  g_object_get (G_OBJECT (mNativeElementPtr), CPU_BUDGET, &cpuBudget, NULL);
+
+  return cpuBudget;
+}
+
+void PointerDetectixFilterImpl::setCpuBudget (int cpuBudget)
+{
+  if (cpuBudget < 0 || cpuBudget > 100) {
+    throw KurentoException (MARSHALL_ERROR,
+                            "cpuBudget must be a percent between 0 and 100");
+  }
+
+  /* The budget is shared by every filter in the process */
+  g_object_set (G_OBJECT (mNativeElementPtr), CPU_BUDGET, (guint) cpuBudget,
+                NULL);
+}
+
+int PointerDetectixFilterImpl::getPointerMovedRate ()
+{
+  guint rate;
+
+  g_object_get (G_OBJECT (mNativeElementPtr), POINTER_MOVED_RATE, &rate, NULL);
+
+  return rate;
+}
+
+void PointerDetectixFilterImpl::setPointerMovedRate (int pointerMovedRate)
+{
+  if (pointerMovedRate < 0 || pointerMovedRate > 120) {
+    throw KurentoException (MARSHALL_ERROR,
+                            "pointerMovedRate must be between 0 and 120");
+  }
+
+  g_object_set (G_OBJECT (mNativeElementPtr), POINTER_MOVED_RATE,
+                (guint) pointerMovedRate, NULL);
+}
+
+int PointerDetectixFilterImpl::getPointerMovedDelta ()
+{
+  guint delta;
+
+  g_object_get (G_OBJECT (mNativeElementPtr), POINTER_MOVED_DELTA, &delta, NULL);
+
+  return delta;
+}
+
+void PointerDetectixFilterImpl::setPointerMovedDelta (int pointerMovedDelta)
+{
+  if (pointerMovedDelta < 0 || pointerMovedDelta > 1000) {
+    throw KurentoException (MARSHALL_ERROR,
+                            "pointerMovedDelta must be between 0 and 1000");
+  }
+
+  g_object_set (G_OBJECT (mNativeElementPtr), POINTER_MOVED_DELTA,
+                (guint) pointerMovedDelta, NULL);
+}
+
+bool PointerDetectixFilterImpl::getAnalysisBranch ()
+{
+  gboolean branch;
+
+  g_object_get (G_OBJECT (mNativeElementPtr), ANALYSIS_BRANCH, &branch, NULL);
+
+  return branch;
+}
+
+void PointerDetectixFilterImpl::setAnalysisBranch (bool analysisBranch)
+{
+  g_object_set (G_OBJECT (mNativeElementPtr), ANALYSIS_BRANCH,
+                (gboolean) analysisBranch, NULL);
+
+  if (analysisBranch && !getAnalysisBranch () ) {
+    throw KurentoException (MARSHALL_ERROR,
+                            "analysis branch not spliced: " + getParams () ["note"]);
+  }
+}
+
+bool PointerDetectixFilterImpl::getOverlayComposition ()
+{
+  gboolean composition;
+
+  g_object_get (G_OBJECT (mNativeElementPtr), OVERLAY_COMPOSITION, &composition,
+                NULL);
+
+  return composition;
+}
+
+void PointerDetectixFilterImpl::setOverlayComposition (bool overlayComposition)
+{
+  g_object_set (G_OBJECT (mNativeElementPtr), OVERLAY_COMPOSITION,
+                (gboolean) overlayComposition, NULL);
+}
+
+bool PointerDetectixFilterImpl::getWindowsOnly ()
+{
+  gboolean windowsOnly;
+
+  g_object_get (G_OBJECT (mNativeElementPtr), WINDOWS_ONLY, &windowsOnly, NULL);
+
+  return windowsOnly;
+}
+
+void PointerDetectixFilterImpl::setWindowsOnly (bool windowsOnly)
+{
+  g_object_set (G_OBJECT (mNativeElementPtr), WINDOWS_ONLY,
+                (gboolean) windowsOnly, NULL);
+}
+
+int PointerDetectixFilterImpl::getFlightRecordThreshold ()
+{
+  guint threshold;
+
+  g_object_get (G_OBJECT (mNativeElementPtr), FLIGHT_THRESHOLD, &threshold,
+                NULL);
+
+  return threshold;
+}
+
+void PointerDetectixFilterImpl::setFlightRecordThreshold (int
+    flightRecordThreshold)
+{
+  if (flightRecordThreshold < 0 || flightRecordThreshold > 60000) {
+    throw KurentoException (MARSHALL_ERROR,
+                            "flightRecordThreshold must be between 0 and 60000");
+  }
+
+  g_object_set (G_OBJECT (mNativeElementPtr), FLIGHT_THRESHOLD,
+                (guint) flightRecordThreshold, NULL);
+}
+
 void PointerDetectixFilterImpl::addWindow (
   std::shared_ptr<PointerDetectixWindowMediaParam> window)
 {
@@ -479,11 +816,12 @@ PointerDetectixFilterImplFactory::createObject (const
     boost::property_tree::ptree &config,
     std::shared_ptr<MediaPipeline> mediaPipeline,
     std::shared_ptr<WindowParam> calibrationRegion,
-    const std::vector<std::shared_ptr<PointerDetectixWindowMediaParam>> &windows)
+    const std::vector<std::shared_ptr<PointerDetectixWindowMediaParam>> &windows,
+    int priority)
 const
 {
   return new PointerDetectixFilterImpl (config, mediaPipeline, calibrationRegion,
-                                        windows);
+                                        windows, priority);
 }
 
 PointerDetectixFilterImpl::StaticConstructor
@@ -26,6 +26,7 @@
 #include <KurentoException.hpp>
 #include <EventHandler.hpp>
 #include <mutex>
+#include <map>
 
 
 namespace kurento
@@ -79,7 +80,8 @@ public:
     PointerDetectixFilterImpl (const boost::property_tree::ptree &config,
                              std::shared_ptr<MediaPipeline> mediaPipeline,
                              std::shared_ptr<WindowParam> calibrationRegion,
-                             const std::vector<std::shared_ptr<PointerDetectixWindowMediaParam>> &windows);
+                             const std::vector<std::shared_ptr<PointerDetectixWindowMediaParam>> &windows,
+                             int priority);
 
     virtual ~PointerDetectixFilterImpl ();
 
@@ -102,8 +104,34 @@ public:
 
     bool setParam(const std::string & rParamName, const std::string & rNewValue); // FALSE if failed
 
+    std::map<std::string, std::string> getParams();                 // all params and the note, one locked read
+
+    bool setParams(const std::map<std::string, std::string> & rParams); // all or nothing, FALSE if failed
+
+    std::string getDegradationLevels();                             // returns ParamsSeparatedByTabs
+
+    std::string dumpFlightRecord();                                 // returns empty if failed
+
+    int getPriority ();
+    void setPriority (int priority);
+    int getCpuBudget ();
+    void setCpuBudget (int cpuBudget);
+    int getPointerMovedRate ();
+    void setPointerMovedRate (int pointerMovedRate);
+    int getPointerMovedDelta ();
+    void setPointerMovedDelta (int pointerMovedDelta);
+    bool getAnalysisBranch ();
+    void setAnalysisBranch (bool analysisBranch);
+    bool getOverlayComposition ();
+    void setOverlayComposition (bool overlayComposition);
+    bool getWindowsOnly ();
+    void setWindowsOnly (bool windowsOnly);
+    int getFlightRecordThreshold ();
+    void setFlightRecordThreshold (int flightRecordThreshold);
+
     sigc::signal<void, WindowIn> signalWindowIn;
     sigc::signal<void, WindowOut> signalWindowOut;
+    sigc::signal<void, PointerMoved> signalPointerMoved;
 
     /* Next methods are automatically implemented by code generator */
     virtual void Serialize (JsonSerializer &serializer);
@@ -120,6 +148,7 @@ private:
     gulong                  bus_handler_id;
 
     void busMessage (GstMessage *message);
+    void pointerMoved (const GstStructure *st);
 
     class StaticConstructor
     {
@@ -0,0 +1,574 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <kmsdetectixanalysis.h>
+#include <kmsdetectixblobs.h>
+#include <kmsdetectixlabels.h>
+#include <kmsdetectixmetricsimpl.h>
+#include <kmsdetectixrecorder.h>
+
+#define WIDTH 320
+#define HEIGHT 240
+#define FRAMES 1000
+#define WARMUP 10
+#define SIDE 12
+
+/* counting allocator, glibc only: every entry point forwards to libc */
+#ifdef __GLIBC__
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t count, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+extern void *__libc_memalign (size_t alignment, size_t size);
+
+static gint counting = FALSE;
+static gint allocations = 0;
+
+static void
+count_allocation (void)
+{
+  if (g_atomic_int_get (&counting)) {
+    g_atomic_int_inc (&allocations);
+  }
+}
+
+void *
+malloc (size_t size)
+{
+  count_allocation ();
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t count, size_t size)
+{
+  count_allocation ();
+  return __libc_calloc (count, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+  count_allocation ();
+  return __libc_realloc (ptr, size);
+}
+
+void *
+memalign (size_t alignment, size_t size)
+{
+  count_allocation ();
+  return __libc_memalign (alignment, size);
+}
+
+int
+posix_memalign (void **ptr, size_t alignment, size_t size)
+{
+  count_allocation ();
+  *ptr = __libc_memalign (alignment, size);
+  return (*ptr == NULL) ? ENOMEM : 0;
+}
+
+#endif
+
+static const KmsDetectixColorRange red = { {0, 0, 200}, {60, 60, 255} };
+
+/* gray BGR frame with a red square whose top left corner is at x, y */
+static void
+paint_frame (guint8 * pixels, gint x, gint y)
+{
+  gint row, col;
+
+  memset (pixels, 90, WIDTH * 3 * HEIGHT);
+
+  for (row = y; row < y + SIDE; row++) {
+    for (col = x; col < x + SIDE; col++) {
+      guint8 *pixel = pixels + row * WIDTH * 3 + col * 3;
+
+      pixel[0] = 20;
+      pixel[1] = 30;
+      pixel[2] = 230;
+    }
+  }
+}
+
+GST_START_TEST (steady_state_allocations)
+{
+  KmsDetectixAnalysis *analysis = kms_detectix_analysis_new ();
+  GstVideoRectangle roi = { 0, 0, WIDTH, HEIGHT };
+  guint8 *pixels = g_malloc (WIDTH * 3 * HEIGHT);
+  gint frame;
+
+  kms_detectix_kernels_init ();
+
+  fail_unless (kms_detectix_analysis_set_info (analysis, WIDTH, HEIGHT,
+          KMS_DETECTIX_LAYOUT_BGR));
+
+  for (frame = 0; frame < FRAMES; frame++) {
+    KmsDetectixPointer pointer;
+    gint x = 8 + (frame * 3) % (WIDTH - SIDE - 16);
+    gint y = 8 + (frame * 2) % (HEIGHT - SIDE - 16);
+
+#ifdef __GLIBC__
+    if (frame == WARMUP) {
+      g_atomic_int_set (&counting, TRUE);
+    }
+#endif
+
+    paint_frame (pixels, x, y);
+
+    kms_detectix_analysis_find_pointer (analysis, pixels, WIDTH * 3, &roi,
+        frame & 1, &red, &pointer);
+
+    fail_unless (pointer.found, "no pointer in frame %d", frame);
+    fail_unless (ABS (pointer.x - (x + SIDE / 2)) <= 2
+        && ABS (pointer.y - (y + SIDE / 2)) <= 2,
+        "pointer at %d,%d in frame %d, expected %d,%d", pointer.x, pointer.y,
+        frame, x + SIDE / 2, y + SIDE / 2);
+  }
+
+#ifdef __GLIBC__
+  g_atomic_int_set (&counting, FALSE);
+
+  fail_unless (g_atomic_int_get (&allocations) == 0,
+      "%d allocations after warmup", g_atomic_int_get (&allocations));
+#endif
+
+  /* smaller caps reuse the block, stop gives it back */
+  fail_unless (kms_detectix_analysis_set_info (analysis, WIDTH / 2,
+          HEIGHT / 2, KMS_DETECTIX_LAYOUT_BGR));
+  kms_detectix_analysis_release (analysis);
+
+  g_free (pixels);
+  kms_detectix_analysis_free (analysis);
+}
+
+GST_END_TEST;
+
+#define STRIPS_WIDTH 1280
+#define STRIPS_HEIGHT 720
+#define STRIPS_STRIDE (STRIPS_WIDTH * 3)
+#define STRIPS_WORDS KMS_DETECTIX_MASK_WORDS (STRIPS_WIDTH)
+
+/*
+ * a square moved down by aOffset rows, so its edges fall on every row of a
+ * strip, over a tall bar, a ring and a diagonal band crossing many strips,
+ * and dust the opening removes
+ */
+static void
+paint_strips_frame (guint8 * pixels, gint offset)
+{
+  guint32 seed = 1;
+  gint row, col;
+
+  memset (pixels, 90, STRIPS_STRIDE * STRIPS_HEIGHT);
+
+  for (row = 0; row < STRIPS_HEIGHT; row++) {
+    for (col = 0; col < STRIPS_WIDTH; col++) {
+      gint ring = (col - 600) * (col - 600) + (row - 300) * (row - 300);
+      guint8 *pixel = pixels + row * STRIPS_STRIDE + col * 3;
+
+      seed = seed * 1103515245 + 12345;
+
+      if ((col >= 900 && col < 1100 && row >= 200 + offset
+              && row < 400 + offset)
+          || (col >= 100 && col < 140 && row >= 30 && row < 400)
+          || (ring < 150 * 150 && ring > 120 * 120)
+          || (ABS (col - row - 300) < 6)
+          || ((seed >> 16) % 97 == 0)) {
+        pixel[0] = 20;
+        pixel[1] = 30;
+        pixel[2] = 230;
+      }
+    }
+  }
+}
+
+/*
+ * the strips find exactly what whole-frame passes of the same kernels find,
+ * wherever the blobs cross strip borders, at every scale
+ */
+GST_START_TEST (strips_match_frame)
+{
+  static const GstVideoRectangle rois[] = {
+    {0, 0, STRIPS_WIDTH, STRIPS_HEIGHT}, {37, 53, 900, 600}, {200, 90, 64, 500}
+  };
+  const KmsDetectixKernels *kernels;
+  KmsDetectixAnalysis *analysis = kms_detectix_analysis_new ();
+  KmsDetectixArena *arena = kms_detectix_arena_new ();
+  guint8 *pixels = g_malloc (STRIPS_STRIDE * STRIPS_HEIGHT);
+  guint8 *scaled = g_malloc (STRIPS_STRIDE * STRIPS_HEIGHT);
+  guint64 *mask = g_new (guint64, STRIPS_WORDS * STRIPS_HEIGHT);
+  guint64 *eroded = g_new (guint64, STRIPS_WORDS * STRIPS_HEIGHT);
+  guint16 *sums = g_new (guint16, STRIPS_STRIDE);
+  KmsDetectixBlobs blobs;
+  guint shift, index;
+  gint offset;
+
+  kms_detectix_kernels_init ();
+  kernels = kms_detectix_kernels ();
+
+  fail_unless (kms_detectix_analysis_set_info (analysis, STRIPS_WIDTH,
+          STRIPS_HEIGHT, KMS_DETECTIX_LAYOUT_BGR));
+  fail_unless (kms_detectix_arena_prepare (arena,
+          kms_detectix_blobs_scratch_size (STRIPS_WIDTH, STRIPS_HEIGHT)));
+  fail_unless (kms_detectix_blobs_init (&blobs, arena, STRIPS_WIDTH,
+          STRIPS_HEIGHT));
+
+  for (offset = 0; offset < 64; offset++) {
+    paint_strips_frame (pixels, offset);
+
+    for (index = 0; index < G_N_ELEMENTS (rois); index++) {
+      for (shift = 0; shift <= 2; shift++) {
+        const GstVideoRectangle *roi = &rois[index];
+        const guint8 *roi_pixels = pixels + roi->y * STRIPS_STRIDE + roi->x * 3;
+        gint w = roi->w >> shift, h = roi->h >> shift;
+        KmsDetectixPointer pointer;
+        KmsDetectixBlob blob;
+        gboolean found;
+
+        if (shift > 0) {
+          kernels->downscale[KMS_DETECTIX_LAYOUT_BGR] (roi_pixels,
+              STRIPS_STRIDE, scaled, STRIPS_STRIDE, w, h, shift, sums);
+          roi_pixels = scaled;
+        }
+
+        kernels->classify[KMS_DETECTIX_LAYOUT_BGR] (roi_pixels, STRIPS_STRIDE,
+            mask, STRIPS_WORDS, w, h, red.low, red.high);
+        kernels->erode (mask, STRIPS_WORDS, eroded, STRIPS_WORDS, w, h);
+        kernels->dilate (eroded, STRIPS_WORDS, mask, STRIPS_WORDS, w, h);
+        found = kms_detectix_blobs_largest (&blobs, mask, STRIPS_WORDS, w, h,
+            &blob);
+
+        kms_detectix_analysis_find_pointer (analysis, pixels, STRIPS_STRIDE,
+            roi, shift, &red, &pointer);
+
+        fail_unless_equals_int (pointer.blobs, blobs.num_blobs);
+        fail_unless_equals_int (pointer.found, found && blob.area >= 4);
+
+        if (pointer.found) {
+          fail_unless_equals_int (pointer.bounds.x,
+              roi->x + (blob.left << shift));
+          fail_unless_equals_int (pointer.bounds.y,
+              roi->y + (blob.top << shift));
+          fail_unless_equals_int (pointer.bounds.w,
+              (blob.right - blob.left + 1) << shift);
+          fail_unless_equals_int (pointer.bounds.h,
+              (blob.bottom - blob.top + 1) << shift);
+          fail_unless_equals_int (pointer.x, roi->x +
+              (gint) (((gdouble) blob.sum_x / blob.area) * (1 << shift)));
+          fail_unless_equals_int (pointer.y, roi->y +
+              (gint) (((gdouble) blob.sum_y / blob.area) * (1 << shift)));
+        }
+      }
+    }
+  }
+
+  g_free (sums);
+  g_free (eroded);
+  g_free (mask);
+  g_free (scaled);
+  g_free (pixels);
+  kms_detectix_arena_free (arena);
+  kms_detectix_analysis_free (analysis);
+}
+
+GST_END_TEST;
+
+/* 8-connected: the diagonal joins, the far dot stays apart */
+GST_START_TEST (largest_blob)
+{
+  static const gchar *rows[] = {
+    "##..#.....",
+    "..#.#....#",
+    "...##.....",
+    "#.........",
+    "#....###..",
+  };
+  gint width = 10, height = G_N_ELEMENTS (rows);
+  KmsDetectixArena *arena = kms_detectix_arena_new ();
+  KmsDetectixBlobs blobs;
+  KmsDetectixBlob blob;
+  guint64 mask[G_N_ELEMENTS (rows)] = { 0 };
+  gint row, col;
+
+  for (row = 0; row < height; row++) {
+    for (col = 0; col < width; col++) {
+      if (rows[row][col] == '#') {
+        mask[row] |= G_GUINT64_CONSTANT (1) << col;
+      }
+    }
+  }
+
+  fail_unless (kms_detectix_arena_prepare (arena,
+          kms_detectix_blobs_scratch_size (width, height)));
+  fail_unless (kms_detectix_blobs_init (&blobs, arena, width, height));
+  fail_unless (kms_detectix_blobs_largest (&blobs, mask, 1, width, height,
+          &blob));
+
+  fail_unless_equals_int (blob.area, 7);
+  fail_unless_equals_int (blob.left, 0);
+  fail_unless_equals_int (blob.top, 0);
+  fail_unless_equals_int (blob.right, 4);
+  fail_unless_equals_int (blob.bottom, 2);
+  fail_unless_equals_int (blobs.num_blobs, 4);
+
+  memset (mask, 0, sizeof (mask));
+  fail_if (kms_detectix_blobs_largest (&blobs, mask, 1, width, height,
+          &blob));
+
+  kms_detectix_arena_free (arena);
+}
+
+GST_END_TEST;
+
+/* a scraper maps the segment on its own and finds each slot by id */
+GST_START_TEST (metrics_segment)
+{
+  KmsDetectixMetricsSlot *first, *second, copy;
+  const KmsDetectixMetricsHeader *header;
+  const KmsDetectixMetricsSlot *slot;
+  gsize size;
+  guint index;
+  gchar *name;
+  gint fd;
+
+  /* concurrent runs must not share a segment */
+  name = g_strdup_printf ("/kms-pointerdetectix-check-%u", (guint) getpid ());
+  g_setenv ("DETECTIX_METRICS_SEGMENT", name, TRUE);
+
+  first = kms_detectix_metrics_acquire ("first");
+  second = kms_detectix_metrics_acquire ("second");
+
+  fail_unless (first != NULL && second != NULL && first != second);
+  fail_unless_equals_string (kms_detectix_metrics_segment_name (), name);
+
+  kms_detectix_metrics_begin (first);
+  first->frames = 3;
+  first->analyzed = 2;
+  kms_detectix_metrics_observe (first->analysis_ns, 20000);
+  kms_detectix_metrics_observe (first->analysis_ns, 70000);
+  kms_detectix_metrics_end (first);
+
+  fd = shm_open (kms_detectix_metrics_segment_name (), O_RDONLY, 0);
+  fail_unless (fd >= 0);
+
+  header = mmap (NULL, sizeof (KmsDetectixMetricsHeader), PROT_READ,
+      MAP_SHARED, fd, 0);
+  fail_unless (header != MAP_FAILED);
+  fail_unless_equals_int (header->magic, KMS_DETECTIX_METRICS_MAGIC);
+  fail_unless_equals_int (header->bucket_count, KMS_DETECTIX_METRICS_BUCKETS);
+
+  size = header->slots_offset + (gsize) header->slot_count * header->slot_size;
+  munmap ((gpointer) header, sizeof (KmsDetectixMetricsHeader));
+
+  header = mmap (NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  fail_unless (header != MAP_FAILED);
+  close (fd);
+
+  /* the writer's slots and the scraper's are the same pages */
+  for (index = 0; index < header->slot_count; index++) {
+    slot = (const KmsDetectixMetricsSlot *) ((const guint8 *) header +
+        header->slots_offset + (gsize) index * header->slot_size);
+
+    fail_unless (kms_detectix_metrics_read (slot, &copy));
+
+    if (copy.in_use && g_strcmp0 (copy.id, "first") == 0) {
+      break;
+    }
+  }
+
+  fail_unless (index < header->slot_count, "no slot for first");
+  fail_unless_equals_int (copy.frames, 3);
+  fail_unless_equals_int (copy.analyzed, 2);
+  fail_unless_equals_int (copy.analysis_ns[0], 1);
+  fail_unless_equals_int (copy.analysis_ns[2], 1);
+
+  /* a released slot reads as free and zeroed */
+  kms_detectix_metrics_release (first);
+  fail_unless (kms_detectix_metrics_read (slot, &copy));
+  fail_if (copy.in_use);
+  fail_unless_equals_int (copy.frames, 0);
+
+  kms_detectix_metrics_release (second);
+  munmap ((gpointer) header, size);
+  g_free (name);
+}
+
+GST_END_TEST;
+
+/* the ring keeps the newest frames, oldest first, and dumps one line each */
+GST_START_TEST (flight_recorder)
+{
+  KmsDetectixRecorder *recorder = kms_detectix_recorder_new ();
+  KmsDetectixFlight *flights = g_new (KmsDetectixFlight,
+      KMS_DETECTIX_RECORDER_FRAMES);
+  KmsDetectixFlight flight;
+  gchar *path, *contents;
+  gchar **lines;
+  guint count, index;
+
+  fail_unless_equals_int (kms_detectix_recorder_snapshot (recorder, flights),
+      0);
+
+  memset (&flight, 0, sizeof (flight));
+
+  for (index = 1; index <= KMS_DETECTIX_RECORDER_FRAMES + 100; index++) {
+    flight.pts = index;
+    flight.analysis_ns = index * 1000;
+    flight.flags = (index & 1) ? KMS_DETECTIX_FLIGHT_ANALYZED : 0;
+    kms_detectix_recorder_add (recorder, &flight);
+  }
+
+  count = kms_detectix_recorder_snapshot (recorder, flights);
+
+  fail_unless_equals_int (count, KMS_DETECTIX_RECORDER_FRAMES);
+  fail_unless_equals_uint64 (flights[0].frame, 101);
+  fail_unless_equals_uint64 (flights[0].pts, 101);
+  fail_unless_equals_uint64 (flights[count - 1].frame,
+      KMS_DETECTIX_RECORDER_FRAMES + 100);
+
+  path = g_build_filename (g_get_tmp_dir (), "detectix-flight-check.csv",
+      NULL);
+
+  fail_unless (kms_detectix_recorder_dump (recorder, path));
+  fail_unless (g_file_get_contents (path, &contents, NULL, NULL));
+
+  lines = g_strsplit (contents, "\n", -1);
+
+  /* a header, one line per frame and the empty string after the last newline */
+  fail_unless_equals_int (g_strv_length (lines),
+      KMS_DETECTIX_RECORDER_FRAMES + 2);
+  fail_unless (g_str_has_prefix (lines[0], "frame,pts,"));
+  fail_unless (g_str_has_prefix (lines[1], "101,101,0,101000,101000,"));
+
+  g_strfreev (lines);
+  g_free (contents);
+  g_unlink (path);
+  g_free (path);
+  g_free (flights);
+  kms_detectix_recorder_unref (recorder);
+}
+
+GST_END_TEST;
+
+/*
+ * overlapping shapes share cells, each window marked inside or in its margin,
+ * and a rectangle is hit exactly as before the label map
+ */
+GST_START_TEST (window_labels)
+{
+  static const gdouble triangle[] = { 0.5, 0.0, 1.0, 1.0, 0.0, 1.0 };
+  KmsDetectixShape shapes[3];
+  KmsDetectixLabels *labels;
+  const guint32 *entries;
+
+  memset (shapes, 0, sizeof (shapes));
+
+  shapes[0].type = KMS_DETECTIX_SHAPE_RECTANGLE;
+  shapes[0].rect.x = 10;
+  shapes[0].rect.y = 10;
+  shapes[0].rect.w = 40;
+  shapes[0].rect.h = 40;
+
+  shapes[1].type = KMS_DETECTIX_SHAPE_ELLIPSE;
+  shapes[1].rect.x = 30;
+  shapes[1].rect.y = 30;
+  shapes[1].rect.w = 40;
+  shapes[1].rect.h = 40;
+
+  shapes[2].type = KMS_DETECTIX_SHAPE_POLYGON;
+  shapes[2].rect.x = 100;
+  shapes[2].rect.y = 10;
+  shapes[2].rect.w = 40;
+  shapes[2].rect.h = 40;
+  shapes[2].points = triangle;
+  shapes[2].num_points = 3;
+
+  labels = kms_detectix_labels_new (160, 120, shapes, 3, 4);
+
+  fail_unless_equals_int (kms_detectix_labels_get_margin (labels), 4);
+
+  /* inside the rectangle and the ellipse */
+  fail_unless_equals_int (kms_detectix_labels_hit (labels, 45, 45, &entries),
+      2);
+  fail_unless_equals_int (entries[0], (0 << 1) | 1);
+  fail_unless_equals_int (entries[1], (1 << 1) | 1);
+
+  /* the corner of the ellipse bounds is only in the margin of the ellipse */
+  fail_unless_equals_int (kms_detectix_labels_hit (labels, 32, 32, &entries),
+      2);
+  fail_unless_equals_int (entries[0], (0 << 1) | 1);
+  fail_unless_equals_int (entries[1], 1 << 1);
+
+  /* edges and margin of the rectangle */
+  fail_unless_equals_int (kms_detectix_labels_hit (labels, 10, 10, &entries),
+      1);
+  fail_unless_equals_int (kms_detectix_labels_hit (labels, 6, 6, &entries),
+      1);
+  fail_unless_equals_int (entries[0], 0 << 1);
+  fail_unless_equals_int (kms_detectix_labels_hit (labels, 5, 20, &entries),
+      0);
+
+  /* the tip of the triangle, and beside it */
+  fail_unless_equals_int (kms_detectix_labels_hit (labels, 120, 40, &entries),
+      1);
+  fail_unless_equals_int (entries[0], (2 << 1) | 1);
+  fail_unless_equals_int (kms_detectix_labels_hit (labels, 112, 20, &entries),
+      1);
+  fail_unless_equals_int (entries[0], 2 << 1);
+
+  fail_unless_equals_int (kms_detectix_labels_hit (labels, -1, 20, &entries),
+      0);
+  fail_unless_equals_int (kms_detectix_labels_hit (labels, 80, 100,
+          &entries), 0);
+
+  kms_detectix_labels_free (labels);
+}
+
+GST_END_TEST;
+
+/* Define test suite */
+static Suite *
+detectixanalysis_suite (void)
+{
+  Suite *s = suite_create ("detectixanalysis");
+  TCase *tc_chain = tcase_create ("element");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, steady_state_allocations);
+  tcase_add_test (tc_chain, largest_blob);
+  tcase_add_test (tc_chain, strips_match_frame);
+  tcase_add_test (tc_chain, metrics_segment);
+  tcase_add_test (tc_chain, flight_recorder);
+  tcase_add_test (tc_chain, window_labels);
+
+  return s;
+}
+
+GST_CHECK_MAIN (detectixanalysis);
@@ -0,0 +1,361 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <glib.h>
+#include <string.h>
+
+#include <kmsdetectixkernels.h>
+
+/* odd sizes so that every set runs its vector body and its scalar tail */
+/* and masks end inside, on and past the end of a word */
+static const gint widths[] = { 1, 2, 3, 15, 17, 31, 33, 63, 64, 65, 101, 129 };
+static const gint heights[] = { 1, 2, 3, 5, 9 };
+
+#define ROUNDS 20
+#define PADDING 13
+
+static guint8 *
+random_bytes (GRand * rand, gsize size)
+{
+  guint8 *data = g_malloc (size);
+  gsize index;
+
+  for (index = 0; index < size; index++) {
+    data[index] = (guint8) g_rand_int_range (rand, 0, 256);
+  }
+
+  return data;
+}
+
+static gboolean
+mask_bit (const guint64 * mask, gint stride, gint col, gint row)
+{
+  return (mask[row * stride + col / 64] >> (col % 64)) & 1;
+}
+
+/* masks as the analysis sees them, runs of set and clear bits, none past the width */
+static guint64 *
+random_mask (GRand * rand, gint width, gint height, gint stride)
+{
+  guint64 *data = g_new0 (guint64, (gsize) stride * height);
+  gboolean value = FALSE;
+  gint row, col;
+
+  for (row = 0; row < height; row++) {
+    for (col = 0; col < width; col++) {
+      if (g_rand_int_range (rand, 0, 4) == 0) {
+        value = !value;
+      }
+      if (value) {
+        data[row * stride + col / 64] |= G_GUINT64_CONSTANT (1) << (col % 64);
+      }
+    }
+  }
+
+  return data;
+}
+
+/* 3x3 minimum or maximum of one pixel, the neighbourhood clipped to the image */
+static gboolean
+morph_pixel (const guint64 * src, gint stride, gint width, gint height,
+    gint x, gint y, gboolean erode)
+{
+  gint row, col;
+
+  for (row = MAX (0, y - 1); row <= MIN (height - 1, y + 1); row++) {
+    for (col = MAX (0, x - 1); col <= MIN (width - 1, x + 1); col++) {
+      if (mask_bit (src, stride, col, row) != erode) {
+        return !erode;
+      }
+    }
+  }
+
+  return erode;
+}
+
+static const KmsDetectixKernels *
+scalar (void)
+{
+  const KmsDetectixKernels *kernels = kms_detectix_kernels_nth (0);
+
+  fail_unless (kernels != NULL);
+  fail_unless (g_strcmp0 (kernels->name, "scalar") == 0);
+
+  return kernels;
+}
+
+static void
+check_classify (const KmsDetectixKernels * reference,
+    const KmsDetectixKernels * kernels, guint layout, GRand * rand)
+{
+  guint size = kms_detectix_layout_pixel (layout)->size;
+  guint w, h, round;
+
+  for (w = 0; w < G_N_ELEMENTS (widths); w++) {
+    for (h = 0; h < G_N_ELEMENTS (heights); h++) {
+      for (round = 0; round < ROUNDS; round++) {
+        gint width = widths[w], height = heights[h];
+        gint stride = width * size + g_rand_int_range (rand, 0, PADDING);
+        gint words = KMS_DETECTIX_MASK_WORDS (width);
+        gint mask_stride = words + g_rand_int_range (rand, 0, 3);
+        guint8 *src = random_bytes (rand, (gsize) stride * height);
+        guint64 *expected = g_new0 (guint64, (gsize) mask_stride * height);
+        guint64 *actual = g_new0 (guint64, (gsize) mask_stride * height);
+        guint8 low[3], high[3];
+        gint channel, row;
+
+        for (channel = 0; channel < 3; channel++) {
+          low[channel] = (guint8) g_rand_int_range (rand, 0, 256);
+          high[channel] = (guint8) g_rand_int_range (rand, low[channel], 256);
+        }
+
+        reference->classify[layout] (src, stride, expected, mask_stride,
+            width, height, low, high);
+        kernels->classify[layout] (src, stride, actual, mask_stride, width,
+            height, low, high);
+
+        for (row = 0; row < height; row++) {
+          fail_unless (memcmp (expected + row * mask_stride,
+                  actual + row * mask_stride, words * sizeof (guint64)) == 0,
+              "%s classify of layout %u differs at %dx%d row %d",
+              kernels->name, layout, width, height, row);
+        }
+
+        g_free (src);
+        g_free (expected);
+        g_free (actual);
+      }
+    }
+  }
+}
+
+static void
+check_downscale (const KmsDetectixKernels * reference,
+    const KmsDetectixKernels * kernels, guint layout, GRand * rand)
+{
+  guint size = kms_detectix_layout_pixel (layout)->size;
+  guint w, h, shift, round;
+
+  for (w = 0; w < G_N_ELEMENTS (widths); w++) {
+    for (h = 0; h < G_N_ELEMENTS (heights); h++) {
+      for (shift = 1; shift <= 3; shift++) {
+        for (round = 0; round < ROUNDS / 4; round++) {
+          gint width = widths[w], height = heights[h];
+          gint stride = ((width << shift) * size) + g_rand_int_range (rand, 0,
+              PADDING);
+          gint dst_stride = width * size + g_rand_int_range (rand, 0, PADDING);
+          guint8 *src = random_bytes (rand, (gsize) stride * (height << shift));
+          guint8 *expected = g_malloc0 ((gsize) dst_stride * height);
+          guint8 *actual = g_malloc0 ((gsize) dst_stride * height);
+          guint16 *sums = g_new (guint16, (width << shift) * size);
+          gint row;
+
+          reference->downscale[layout] (src, stride, expected, dst_stride,
+              width, height, shift, sums);
+          kernels->downscale[layout] (src, stride, actual, dst_stride, width,
+              height, shift, sums);
+
+          for (row = 0; row < height; row++) {
+            fail_unless (memcmp (expected + row * dst_stride,
+                    actual + row * dst_stride, width * size) == 0,
+                "%s downscale of layout %u differs at %dx%d shift %u row %d",
+                kernels->name, layout, width, height, shift, row);
+          }
+
+          g_free (src);
+          g_free (expected);
+          g_free (actual);
+          g_free (sums);
+        }
+      }
+    }
+  }
+}
+
+static void
+check_blend_row (const KmsDetectixKernels * reference,
+    const KmsDetectixKernels * kernels, guint layout, GRand * rand)
+{
+  guint size = kms_detectix_layout_pixel (layout)->size;
+  guint w, round;
+
+  for (w = 0; w < G_N_ELEMENTS (widths); w++) {
+    for (round = 0; round < ROUNDS; round++) {
+      gint width = widths[w];
+      guint opacity = (round < 2) ? round * 255 : (guint)
+          g_rand_int_range (rand, 0, 256);
+      guint8 *icon = random_bytes (rand, (gsize) width * 4);
+      guint8 *expected = random_bytes (rand, (gsize) width * size);
+      guint8 *actual = g_memdup (expected, width * size);
+
+      reference->blend_row[layout] (expected, icon, width, opacity);
+      kernels->blend_row[layout] (actual, icon, width, opacity);
+
+      fail_unless (memcmp (expected, actual, width * size) == 0,
+          "%s blend of layout %u differs at width %d opacity %u",
+          kernels->name, layout, width, opacity);
+
+      g_free (icon);
+      g_free (expected);
+      g_free (actual);
+    }
+  }
+}
+
+/* every frame kernel of every set against the scalar one of the same layout */
+static void
+check_layouts (void (*check) (const KmsDetectixKernels *,
+        const KmsDetectixKernels *, guint, GRand *))
+{
+  const KmsDetectixKernels *reference = scalar ();
+  const KmsDetectixKernels *kernels;
+  GRand *rand = g_rand_new_with_seed (37);
+  guint set, layout;
+
+  for (set = 1; (kernels = kms_detectix_kernels_nth (set)) != NULL; set++) {
+    for (layout = 0; layout < KMS_DETECTIX_LAYOUTS; layout++) {
+      check (reference, kernels, layout, rand);
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_START_TEST (classify)
+{
+  check_layouts (check_classify);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (downscale)
+{
+  check_layouts (check_downscale);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (blend_row)
+{
+  check_layouts (check_blend_row);
+}
+
+GST_END_TEST;
+
+/* the pad byte of 4 byte layouts is never written */
+GST_START_TEST (pad_kept)
+{
+  const KmsDetectixKernels *kernels = kms_detectix_kernels ();
+  guint8 icon[4 * 40];
+  guint8 frame[4 * 40];
+  guint layout, index;
+
+  memset (icon, 0xFF, sizeof (icon));
+
+  for (layout = 0; layout < KMS_DETECTIX_LAYOUTS; layout++) {
+    const KmsDetectixPixel *pixel = kms_detectix_layout_pixel (layout);
+    guint pad = 6 - pixel->blue - pixel->green - pixel->red;
+
+    if (pixel->size != 4) {
+      continue;
+    }
+
+    memset (frame, 0x5A, sizeof (frame));
+    kernels->blend_row[layout] (frame, icon, 40, 255);
+
+    for (index = 0; index < 40; index++) {
+      fail_unless (frame[index * 4 + pad] == 0x5A);
+      fail_unless (frame[index * 4 + pixel->blue] == 0xFF);
+    }
+  }
+}
+
+GST_END_TEST;
+
+/* the word kernels against one pixel at a time, the bits past the width stay clear */
+GST_START_TEST (morphology)
+{
+  const KmsDetectixKernels *kernels;
+  GRand *rand = g_rand_new_with_seed (37);
+  guint set, w, h, round;
+
+  for (set = 0; (kernels = kms_detectix_kernels_nth (set)) != NULL; set++) {
+    for (w = 0; w < G_N_ELEMENTS (widths); w++) {
+      for (h = 0; h < G_N_ELEMENTS (heights); h++) {
+        for (round = 0; round < ROUNDS; round++) {
+          gint width = widths[w], height = heights[h];
+          gint words = KMS_DETECTIX_MASK_WORDS (width);
+          gint stride = words + g_rand_int_range (rand, 0, 3);
+          gint dst_stride = words + g_rand_int_range (rand, 0, 3);
+          guint64 *src = random_mask (rand, width, height, stride);
+          guint64 *actual = g_new0 (guint64, (gsize) dst_stride * height);
+          gint row, col, pass;
+
+          for (pass = 0; pass < 2; pass++) {
+            if (pass == 0) {
+              kernels->erode (src, stride, actual, dst_stride, width, height);
+            } else {
+              kernels->dilate (src, stride, actual, dst_stride, width, height);
+            }
+
+            for (row = 0; row < height; row++) {
+              for (col = 0; col < words * 64; col++) {
+                gboolean expected = (col < width) && morph_pixel (src, stride,
+                    width, height, col, row, pass == 0);
+
+                fail_unless (mask_bit (actual, dst_stride, col, row) ==
+                    expected, "%s %s differs at %dx%d pixel %d,%d",
+                    kernels->name, pass ? "dilate" : "erode", width, height,
+                    col, row);
+              }
+            }
+          }
+
+          g_free (src);
+          g_free (actual);
+        }
+      }
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+/* Define test suite */
+static Suite *
+detectixkernels_suite (void)
+{
+  Suite *s = suite_create ("detectixkernels");
+  TCase *tc_chain = tcase_create ("element");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, classify);
+  tcase_add_test (tc_chain, downscale);
+  tcase_add_test (tc_chain, blend_row);
+  tcase_add_test (tc_chain, pad_kept);
+  tcase_add_test (tc_chain, morphology);
+
+  return s;
+}
+
+GST_CHECK_MAIN (detectixkernels);
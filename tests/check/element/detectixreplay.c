@@ -0,0 +1,717 @@
+/*
+ * (C) Copyright 2016 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include <kmsdetectixcapture.h>
+
+#define WIDTH 160
+#define HEIGHT 120
+#define FRAMES 60
+#define SIDE 10
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+
+typedef struct
+{
+  GstElement *element;
+  GstPad *srcpad;
+  GstPad *sinkpad;
+  GstBus *bus;
+  gboolean has_caps;
+} Session;
+
+static void
+session_start (Session * session)
+{
+  session->element = gst_check_setup_element ("pointerdetectix");
+  session->srcpad = gst_check_setup_src_pad (session->element, &srctemplate);
+  session->sinkpad = gst_check_setup_sink_pad (session->element,
+      &sinktemplate);
+  session->bus = gst_bus_new ();
+  session->has_caps = FALSE;
+
+  gst_element_set_bus (session->element, session->bus);
+  gst_pad_set_active (session->srcpad, TRUE);
+  gst_pad_set_active (session->sinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (session->element,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS);
+}
+
+static void
+session_stop (Session * session)
+{
+  fail_unless (gst_element_set_state (session->element,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+
+  gst_bus_set_flushing (session->bus, TRUE);
+  gst_object_unref (session->bus);
+
+  gst_pad_set_active (session->srcpad, FALSE);
+  gst_pad_set_active (session->sinkpad, FALSE);
+  gst_check_teardown_src_pad (session->element);
+  gst_check_teardown_sink_pad (session->element);
+  gst_check_teardown_element (session->element);
+
+  gst_check_drop_buffers ();
+}
+
+static void
+session_caps (Session * session, GstCaps * caps)
+{
+  if (!session->has_caps) {
+    gst_check_setup_events (session->srcpad, session->element, caps,
+        GST_FORMAT_TIME);
+    session->has_caps = TRUE;
+  } else {
+    fail_unless (gst_pad_push_event (session->srcpad,
+            gst_event_new_caps (caps)));
+  }
+}
+
+/* element messages posted so far, as strings in the order they were posted */
+static void
+session_messages (Session * session, GPtrArray * messages)
+{
+  GstMessage *message;
+
+  while ((message = gst_bus_pop_filtered (session->bus,
+              GST_MESSAGE_ELEMENT)) != NULL) {
+    g_ptr_array_add (messages,
+        gst_structure_to_string (gst_message_get_structure (message)));
+    gst_message_unref (message);
+  }
+}
+
+/* gray BGR frame with a red square centered on x, y */
+static GstBuffer *
+paint_frame (gint x, gint y, GstClockTime pts)
+{
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, WIDTH * 3 * HEIGHT, NULL);
+  GstMapInfo map;
+  gint row, col;
+
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_WRITE));
+
+  memset (map.data, 90, map.size);
+
+  for (row = y - SIDE / 2; row < y + SIDE / 2; row++) {
+    for (col = x - SIDE / 2; col < x + SIDE / 2; col++) {
+      guint8 *pixel = map.data + row * WIDTH * 3 + col * 3;
+
+      pixel[0] = 20;
+      pixel[1] = 30;
+      pixel[2] = 230;
+    }
+  }
+
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_PTS (buffer) = pts;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 30;
+
+  return buffer;
+}
+
+/* rows as recorded, packed, into a buffer with the strides of the caps */
+static GstBuffer *
+unpack_frame (const GstVideoInfo * info, const KmsDetectixRecord * record)
+{
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, info->size, NULL);
+  gsize row_size = GST_VIDEO_INFO_WIDTH (info) *
+      GST_VIDEO_INFO_COMP_PSTRIDE (info, 0);
+  GstMapInfo map;
+  gint row;
+
+  fail_unless (record->size == row_size * GST_VIDEO_INFO_HEIGHT (info),
+      "frame of %" G_GSIZE_FORMAT " bytes does not match its caps",
+      record->size);
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_WRITE));
+
+  for (row = 0; row < GST_VIDEO_INFO_HEIGHT (info); row++) {
+    memcpy (map.data + GST_VIDEO_INFO_PLANE_OFFSET (info, 0) +
+        row * GST_VIDEO_INFO_PLANE_STRIDE (info, 0),
+        record->data + row * row_size, row_size);
+  }
+
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_PTS (buffer) = record->time_ns;
+
+  return buffer;
+}
+
+static void
+set_recorded_property (GstElement * element, const gchar * text)
+{
+  const gchar *value_text = text + strlen (text) + 1;
+  GParamSpec *spec;
+  GValue value = G_VALUE_INIT;
+
+  spec = g_object_class_find_property (G_OBJECT_GET_CLASS (element), text);
+  fail_unless (spec != NULL, "unknown property %s", text);
+
+  g_value_init (&value, spec->value_type);
+  fail_unless (gst_value_deserialize (&value, value_text),
+      "cannot deserialize %s=%s", text, value_text);
+
+  g_object_set_property (G_OBJECT (element), text, &value);
+  g_value_unset (&value);
+}
+
+/*
+ * feeds the frames, properties and actions of a capture through a new element
+ * and checks that it posts the recorded messages, in the recorded order
+ */
+static void
+replay (const gchar * path)
+{
+  KmsDetectixCaptureReader *reader = kms_detectix_capture_reader_new (path);
+  GPtrArray *expected = g_ptr_array_new_with_free_func (g_free);
+  GPtrArray *actual = g_ptr_array_new_with_free_func (g_free);
+  KmsDetectixRecord record;
+  GstVideoInfo info;
+  Session session;
+  guint index;
+
+  fail_unless (reader != NULL, "%s is not a capture", path);
+
+  gst_video_info_init (&info);
+  session_start (&session);
+
+  while (kms_detectix_capture_reader_next (reader, &record)) {
+    switch (record.type) {
+      case KMS_DETECTIX_RECORD_CAPS:{
+        GstCaps *caps = gst_caps_from_string ((const gchar *) record.data);
+
+        fail_unless (caps != NULL && gst_video_info_from_caps (&info, caps));
+        session_caps (&session, caps);
+        gst_caps_unref (caps);
+        break;
+      }
+      case KMS_DETECTIX_RECORD_FRAME:
+        fail_unless (session.has_caps, "frame before any caps");
+        fail_unless_equals_int (gst_pad_push (session.srcpad,
+                unpack_frame (&info, &record)), GST_FLOW_OK);
+        break;
+      case KMS_DETECTIX_RECORD_PROPERTY:
+        set_recorded_property (session.element, (const gchar *) record.data);
+        break;
+      case KMS_DETECTIX_RECORD_ACTION:
+        g_signal_emit_by_name (session.element, (const gchar *) record.data);
+        break;
+      case KMS_DETECTIX_RECORD_MESSAGE:
+        g_ptr_array_add (expected, g_strdup ((const gchar *) record.data));
+        break;
+    }
+
+    session_messages (&session, actual);
+  }
+
+  for (index = 0; index < MIN (expected->len, actual->len); index++) {
+    fail_unless_equals_string (g_ptr_array_index (actual, index),
+        g_ptr_array_index (expected, index));
+  }
+
+  fail_unless_equals_int (actual->len, expected->len);
+
+  session_stop (&session);
+  kms_detectix_capture_reader_free (reader);
+  g_ptr_array_unref (expected);
+  g_ptr_array_unref (actual);
+}
+
+GST_START_TEST (record_and_replay)
+{
+  gchar *path = g_build_filename (g_get_tmp_dir (), "detectixreplay.dtx",
+      NULL);
+  GPtrArray *recorded = g_ptr_array_new_with_free_func (g_free);
+  GstStructure *window, *layout, *area;
+  GstCaps *caps;
+  Session session;
+  gint frame;
+
+  session_start (&session);
+
+  window = gst_structure_new ("middle",
+      "upRightCornerX", G_TYPE_INT, 60, "upRightCornerY", G_TYPE_INT, 40,
+      "width", G_TYPE_INT, 40, "height", G_TYPE_INT, 40,
+      "id", G_TYPE_STRING, "middle", NULL);
+  layout = gst_structure_new ("windowsLayout",
+      "middle", GST_TYPE_STRUCTURE, window, NULL);
+  g_object_set (session.element, "windows-layout", layout, NULL);
+  gst_structure_free (window);
+  gst_structure_free (layout);
+
+  g_object_set (session.element, "capture", path, NULL);
+
+  caps = gst_caps_new_simple ("video/x-raw",
+      "format", G_TYPE_STRING, "BGR",
+      "width", G_TYPE_INT, WIDTH, "height", G_TYPE_INT, HEIGHT,
+      "framerate", GST_TYPE_FRACTION, 30, 1, NULL);
+  session_caps (&session, caps);
+  gst_caps_unref (caps);
+
+  /* left to right through the window, calibrated on the square midway */
+  for (frame = 0; frame < FRAMES; frame++) {
+    gint x = SIDE + frame * (WIDTH - 2 * SIDE) / FRAMES;
+
+    if (frame == FRAMES / 4) {
+      area = gst_structure_new ("calibration_area",
+          "x", G_TYPE_INT, x - 2, "y", G_TYPE_INT, HEIGHT / 2 - 2,
+          "width", G_TYPE_INT, 4, "height", G_TYPE_INT, 4, NULL);
+      g_object_set (session.element, "calibration-area", area, NULL);
+      gst_structure_free (area);
+      g_signal_emit_by_name (session.element, "calibrate-color");
+    }
+
+    fail_unless_equals_int (gst_pad_push (session.srcpad,
+            paint_frame (x, HEIGHT / 2, frame * GST_SECOND / 30)),
+        GST_FLOW_OK);
+  }
+
+  session_messages (&session, recorded);
+  g_object_set (session.element, "capture", "", NULL);
+  session_stop (&session);
+
+  fail_unless (recorded->len >= 2, "the pointer never crossed the window");
+
+  replay (path);
+
+  g_unlink (path);
+  g_free (path);
+  g_ptr_array_unref (recorded);
+}
+
+GST_END_TEST;
+
+/* DETECTIX_CAPTURE=file.dtx replays a capture taken from a live session */
+GST_START_TEST (replay_capture)
+{
+  const gchar *path = g_getenv ("DETECTIX_CAPTURE");
+
+  if (path != NULL && path[0] != '\0') {
+    replay (path);
+  }
+}
+
+GST_END_TEST;
+
+/* in windows-only mode a pointer far from every window is not seen at all */
+GST_START_TEST (windows_only)
+{
+  GPtrArray *messages = g_ptr_array_new_with_free_func (g_free);
+  GstStructure *window, *layout, *area;
+  GstCaps *caps;
+  Session session;
+  gboolean entered = FALSE, hidden = FALSE;
+  gint frame;
+  guint index;
+
+  session_start (&session);
+
+  window = gst_structure_new ("middle",
+      "upRightCornerX", G_TYPE_INT, 60, "upRightCornerY", G_TYPE_INT, 40,
+      "width", G_TYPE_INT, 40, "height", G_TYPE_INT, 40,
+      "id", G_TYPE_STRING, "middle", NULL);
+  layout = gst_structure_new ("windowsLayout",
+      "middle", GST_TYPE_STRUCTURE, window, NULL);
+  g_object_set (session.element, "windows-layout", layout,
+      "windows-only", TRUE, "pointer-moved-rate", 1000,
+      "pointer-moved-delta", 0, NULL);
+  gst_structure_free (window);
+  gst_structure_free (layout);
+
+  caps = gst_caps_new_simple ("video/x-raw",
+      "format", G_TYPE_STRING, "BGR",
+      "width", G_TYPE_INT, WIDTH, "height", G_TYPE_INT, HEIGHT,
+      "framerate", GST_TYPE_FRACTION, 30, 1, NULL);
+  session_caps (&session, caps);
+  gst_caps_unref (caps);
+
+  area = gst_structure_new ("calibration_area",
+      "x", G_TYPE_INT, 78, "y", G_TYPE_INT, HEIGHT / 2 - 2,
+      "width", G_TYPE_INT, 4, "height", G_TYPE_INT, 4, NULL);
+  g_object_set (session.element, "calibration-area", area, NULL);
+  gst_structure_free (area);
+  g_signal_emit_by_name (session.element, "calibrate-color");
+
+  /*
+   * inside the window, then beyond the margin and the reach around it, slow
+   * enough for the rate limit of pointer-moved
+   */
+  for (frame = 0; frame < 20; frame++) {
+    g_usleep (2 * 1000);
+    fail_unless_equals_int (gst_pad_push (session.srcpad,
+            paint_frame ((frame < 10) ? 80 : SIDE, HEIGHT / 2,
+                frame * GST_SECOND / 30)), GST_FLOW_OK);
+  }
+
+  session_messages (&session, messages);
+
+  for (index = 0; index < messages->len; index++) {
+    const gchar *message = g_ptr_array_index (messages, index);
+
+    entered = entered || g_str_has_prefix (message, "window-in");
+    hidden = hidden || (g_str_has_prefix (message, "pointer-moved")
+        && strstr (message, "visible=(boolean)false") != NULL);
+  }
+
+  fail_unless (entered, "the pointer never entered the window");
+  fail_unless (hidden, "the pointer was seen away from the window");
+
+  session_stop (&session);
+  g_ptr_array_unref (messages);
+}
+
+GST_END_TEST;
+
+/* pushes one frame and counts the window messages it caused */
+static void
+push_and_count (Session * session, gint x, gint frame, guint * entered,
+    guint * left)
+{
+  GPtrArray *messages = g_ptr_array_new_with_free_func (g_free);
+  guint index;
+
+  fail_unless_equals_int (gst_pad_push (session->srcpad,
+          paint_frame (x, HEIGHT / 2, frame * GST_SECOND / 30)), GST_FLOW_OK);
+
+  session_messages (session, messages);
+
+  *entered = 0;
+  *left = 0;
+
+  for (index = 0; index < messages->len; index++) {
+    const gchar *message = g_ptr_array_index (messages, index);
+
+    *entered += g_str_has_prefix (message, "window-in") ? 1 : 0;
+    *left += g_str_has_prefix (message, "window-out") ? 1 : 0;
+  }
+
+  g_ptr_array_unref (messages);
+}
+
+/*
+ * a pointer jittering across the edge of an entered window, but within its
+ * margin, enters it once and never leaves; entering and leaving each wait for
+ * their number of analyses
+ */
+GST_START_TEST (window_margin_jitter)
+{
+  GstStructure *window, *layout;
+  GstCaps *caps;
+  Session session;
+  guint entered, left, total_entered = 0, total_left = 0;
+  gint frame = 0, count;
+
+  session_start (&session);
+
+  /* from x 60 to 100, so x 56 is outside by less than the margin */
+  window = gst_structure_new ("middle",
+      "upRightCornerX", G_TYPE_INT, 60, "upRightCornerY", G_TYPE_INT, 40,
+      "width", G_TYPE_INT, 40, "height", G_TYPE_INT, 40,
+      "id", G_TYPE_STRING, "middle", NULL);
+  layout = gst_structure_new ("windowsLayout",
+      "middle", GST_TYPE_STRUCTURE, window, NULL);
+  g_object_set (session.element, "windows-layout", layout,
+      "enter-frames", 3, "exit-frames", 4, "window-margin", 8, NULL);
+  gst_structure_free (window);
+  gst_structure_free (layout);
+
+  caps = gst_caps_new_simple ("video/x-raw",
+      "format", G_TYPE_STRING, "BGR",
+      "width", G_TYPE_INT, WIDTH, "height", G_TYPE_INT, HEIGHT,
+      "framerate", GST_TYPE_FRACTION, 30, 1, NULL);
+  session_caps (&session, caps);
+  gst_caps_unref (caps);
+
+  /* the default range tracks the red square, no calibration needed */
+  for (count = 1; count <= 3; count++, frame++) {
+    push_and_count (&session, 66, frame, &entered, &left);
+    fail_unless_equals_int (entered, (count == 3) ? 1 : 0);
+    fail_unless_equals_int (left, 0);
+    total_entered += entered;
+  }
+
+  for (count = 0; count < 20; count++, frame++) {
+    push_and_count (&session, (count & 1) ? 66 : 56, frame, &entered, &left);
+    total_entered += entered;
+    total_left += left;
+  }
+
+  fail_unless_equals_int (total_entered, 1);
+  fail_unless_equals_int (total_left, 0);
+
+  /* far away, it takes exit-frames analyses to leave */
+  for (count = 1; count <= 4; count++, frame++) {
+    push_and_count (&session, SIDE, frame, &entered, &left);
+    fail_unless_equals_int (entered, 0);
+    fail_unless_equals_int (left, (count == 4) ? 1 : 0);
+  }
+
+  session_stop (&session);
+}
+
+GST_END_TEST;
+
+static gpointer
+change_properties (gpointer data)
+{
+  Session *session = data;
+  GstStructure *range;
+  gint round;
+
+  range = gst_structure_new ("color_range",
+      "blue-min", G_TYPE_INT, 0, "blue-max", G_TYPE_INT, 90,
+      "green-min", G_TYPE_INT, 0, "green-max", G_TYPE_INT, 90,
+      "red-min", G_TYPE_INT, 150, "red-max", G_TYPE_INT, 255, NULL);
+
+  for (round = 0; round < 2000; round++) {
+    g_object_set (session->element, "color-range", range,
+        "metrics-id", (round & 1) ? "odd" : "even", NULL);
+  }
+
+  gst_structure_free (range);
+
+  return NULL;
+}
+
+/*
+ * with no branch, every frame carries the windows, however busy the control
+ * plane is
+ */
+GST_START_TEST (composition_every_frame)
+{
+  GstStructure *window, *layout;
+  GstCaps *caps;
+  GThread *thread;
+  Session session;
+  GList *item;
+  gint frame;
+
+  session_start (&session);
+
+  window = gst_structure_new ("middle",
+      "upRightCornerX", G_TYPE_INT, 60, "upRightCornerY", G_TYPE_INT, 40,
+      "width", G_TYPE_INT, 40, "height", G_TYPE_INT, 40,
+      "id", G_TYPE_STRING, "middle", NULL);
+  layout = gst_structure_new ("windowsLayout",
+      "middle", GST_TYPE_STRUCTURE, window, NULL);
+  g_object_set (session.element, "windows-layout", layout,
+      "overlay-composition", TRUE, NULL);
+  gst_structure_free (window);
+  gst_structure_free (layout);
+
+  caps = gst_caps_new_simple ("video/x-raw",
+      "format", G_TYPE_STRING, "BGR",
+      "width", G_TYPE_INT, WIDTH, "height", G_TYPE_INT, HEIGHT,
+      "framerate", GST_TYPE_FRACTION, 30, 1, NULL);
+  session_caps (&session, caps);
+  gst_caps_unref (caps);
+
+  thread = g_thread_new ("properties", change_properties, &session);
+
+  for (frame = 0; frame < FRAMES; frame++) {
+    fail_unless_equals_int (gst_pad_push (session.srcpad,
+            paint_frame (80, HEIGHT / 2, frame * GST_SECOND / 30)),
+        GST_FLOW_OK);
+  }
+
+  g_thread_join (thread);
+
+  fail_unless_equals_int (g_list_length (buffers), FRAMES);
+
+  for (item = buffers, frame = 0; item != NULL; item = item->next, frame++) {
+    fail_unless (gst_buffer_get_video_overlay_composition_meta (item->data)
+        != NULL, "frame %d has no windows", frame);
+  }
+
+  session_stop (&session);
+}
+
+GST_END_TEST;
+
+/* an invalid value is rejected with a note, and set-params applies all or nothing */
+GST_START_TEST (params_all_or_nothing)
+{
+  GstElement *element = gst_element_factory_make ("pointerdetectix", NULL);
+  GstStructure *params, *before, *after;
+  gboolean is_set;
+  gchar *text;
+
+  fail_unless (element != NULL);
+
+  g_object_set (element, "wait", "250", NULL);
+  g_object_get (element, "wait", &text, NULL);
+  fail_unless_equals_string (text, "wait=250");
+  g_free (text);
+
+  /* a single property keeps its value */
+  g_object_set (element, "wait", "soon", NULL);
+  g_object_get (element, "wait", &text, NULL);
+  fail_unless_equals_string (text, "wait=250");
+  g_free (text);
+
+  g_object_get (element, "note", &text, NULL);
+  fail_unless (g_str_has_prefix (text, "note=invalid wait (soon)"), "%s", text);
+  g_free (text);
+
+  g_object_set (element, "snap", "100,5", "pads", "src,sink", NULL);
+  g_object_get (element, "note", &text, NULL);
+  fail_unless (g_str_has_prefix (text, "note=invalid"), "%s", text);
+  g_free (text);
+
+  g_signal_emit_by_name (element, "get-params", &before);
+  fail_unless (before != NULL);
+
+  /* the bad snap sits between two good values, neither is applied */
+  params = gst_structure_new ("params",
+      "wait", G_TYPE_STRING, "500",
+      "snap", G_TYPE_STRING, "100,x,3",
+      "path", G_TYPE_STRING, "/tmp/detectix", NULL);
+  g_signal_emit_by_name (element, "set-params", params, &is_set);
+  gst_structure_free (params);
+  fail_if (is_set);
+
+  g_signal_emit_by_name (element, "get-params", &after);
+  fail_unless (g_str_has_prefix (gst_structure_get_string (after, "note"),
+          "invalid snap (100,x,3)"), "%s",
+      gst_structure_get_string (after, "note"));
+  gst_structure_remove_field (before, "note");
+  gst_structure_remove_field (after, "note");
+  fail_unless (gst_structure_is_equal (before, after),
+      "set-params applied part of a rejected map");
+  gst_structure_free (after);
+
+  /* as are unknown names and values that are not strings */
+  params = gst_structure_new ("params",
+      "wait", G_TYPE_STRING, "500", "speed", G_TYPE_STRING, "1", NULL);
+  g_signal_emit_by_name (element, "set-params", params, &is_set);
+  gst_structure_free (params);
+  fail_if (is_set);
+
+  params = gst_structure_new ("params",
+      "wait", G_TYPE_STRING, "500", "path", G_TYPE_INT, 1, NULL);
+  g_signal_emit_by_name (element, "set-params", params, &is_set);
+  gst_structure_free (params);
+  fail_if (is_set);
+
+  g_signal_emit_by_name (element, "get-params", &after);
+  gst_structure_remove_field (after, "note");
+  fail_unless (gst_structure_is_equal (before, after),
+      "set-params applied part of a rejected map");
+  gst_structure_free (after);
+
+  /* a map of valid values is applied whole */
+  params = gst_structure_new ("params",
+      "wait", G_TYPE_STRING, "500",
+      "snap", G_TYPE_STRING, "100,5,3",
+      "path", G_TYPE_STRING, "/tmp/detectix", NULL);
+  g_signal_emit_by_name (element, "set-params", params, &is_set);
+  gst_structure_free (params);
+  fail_unless (is_set);
+
+  g_signal_emit_by_name (element, "get-params", &after);
+  fail_unless_equals_string (gst_structure_get_string (after, "wait"), "500");
+  fail_unless_equals_string (gst_structure_get_string (after, "snap"),
+      "100,5,3");
+  fail_unless_equals_string (gst_structure_get_string (after, "path"),
+      "/tmp/detectix");
+  fail_unless_equals_string (gst_structure_get_string (after, "note"),
+      "none");
+  gst_structure_free (after);
+
+  gst_structure_free (before);
+  gst_object_unref (element);
+}
+
+GST_END_TEST;
+
+/*
+ * a late sink steps the analysis down once, and not again before the hold off;
+ * whether the event goes further upstream does not matter here
+ */
+GST_START_TEST (qos_steps_down)
+{
+  Session session;
+  gchar *degradation;
+
+  session_start (&session);
+
+  g_object_get (session.element, "degradation", &degradation, NULL);
+  fail_unless (strstr (degradation, "qos=0") != NULL, "%s", degradation);
+  g_free (degradation);
+
+  gst_pad_push_event (session.sinkpad,
+      gst_event_new_qos (GST_QOS_TYPE_UNDERFLOW, 1.2, 20 * GST_MSECOND,
+          GST_SECOND));
+  g_object_get (session.element, "degradation", &degradation, NULL);
+  fail_unless (strstr (degradation, "qos=1") != NULL, "%s", degradation);
+  g_free (degradation);
+
+  gst_pad_push_event (session.sinkpad,
+      gst_event_new_qos (GST_QOS_TYPE_UNDERFLOW, 1.2, 20 * GST_MSECOND,
+          GST_SECOND + GST_SECOND / 30));
+  g_object_get (session.element, "degradation", &degradation, NULL);
+  fail_unless (strstr (degradation, "qos=1") != NULL, "%s", degradation);
+  g_free (degradation);
+
+  /* a throttling sink is not late */
+  gst_pad_push_event (session.sinkpad,
+      gst_event_new_qos (GST_QOS_TYPE_THROTTLE, 1.0, GST_SECOND,
+          2 * GST_SECOND));
+  g_object_get (session.element, "degradation", &degradation, NULL);
+  fail_unless (strstr (degradation, "qos=1") != NULL, "%s", degradation);
+  g_free (degradation);
+
+  session_stop (&session);
+}
+
+GST_END_TEST;
+
+/* Define test suite */
+static Suite *
+detectixreplay_suite (void)
+{
+  Suite *s = suite_create ("detectixreplay");
+  TCase *tc_chain = tcase_create ("element");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, record_and_replay);
+  tcase_add_test (tc_chain, replay_capture);
+  tcase_add_test (tc_chain, qos_steps_down);
+  tcase_add_test (tc_chain, params_all_or_nothing);
+  tcase_add_test (tc_chain, windows_only);
+  tcase_add_test (tc_chain, window_margin_jitter);
+  tcase_add_test (tc_chain, composition_every_frame);
+
+  return s;
+}
+
+GST_CHECK_MAIN (detectixreplay);